@@ -0,0 +1,155 @@
+#include "rsargumentresolver.h"
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSArgumentResolver::RSArgumentResolver()
+{
+
+}
+
+void RSArgumentResolver::clear()
+{
+    values.clear();
+    resolved.clear();
+    dependents.clear();
+}
+
+QStringList RSArgumentResolver::references(const QString& value)
+{
+    QStringList result;
+    int start = 0;
+
+    while ( (start = value.indexOf("${", start)) >= 0 ) {
+        int end = value.indexOf('}', start + 2);
+        if ( end < 0 ) {
+            break;
+        }
+        QString key = value.mid(start + 2, end - start - 2);
+        if ( ! result.contains(key) ) {
+            result << key;
+        }
+        start = end + 1;
+    }
+
+    return result;
+}
+
+/*
+ * Takes over the job's current arguments and returns the keys whose
+ * resolved value may have changed: the ones that were edited, added or
+ * removed and all arguments that refer to them, directly or not.
+ */
+QSet<QString> RSArgumentResolver::update(RSJob* job)
+{
+    QHash<QString, QString> newValues;
+    vector<rsArgument*> arguments = job->getArguments();
+    for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+        if ( (*it)->key != NULL ) {
+            newValues.insert(QString::fromUtf8((*it)->key), QString::fromUtf8((*it)->value == NULL ? "" : (*it)->value));
+        }
+    }
+
+    return update(newValues);
+}
+
+// Same as above for arguments taken from a snapshot
+QSet<QString> RSArgumentResolver::update(const QHash<QString, QString>& newValues)
+{
+    QList<QString> pending;
+    for ( QHash<QString, QString>::const_iterator it = newValues.begin(); it != newValues.end(); ++it ) {
+        QHash<QString, QString>::const_iterator old = values.find(it.key());
+        if ( old == values.end() || old.value() != it.value() ) {
+            pending << it.key();
+        }
+    }
+    for ( QHash<QString, QString>::const_iterator it = values.begin(); it != values.end(); ++it ) {
+        if ( ! newValues.contains(it.key()) ) {
+            pending << it.key();
+        }
+    }
+
+    values = newValues;
+
+    // the references of the new values have to be known before following them
+    dependents.clear();
+    for ( QHash<QString, QString>::const_iterator it = values.begin(); it != values.end(); ++it ) {
+        foreach( const QString &reference, references(it.value()) ) {
+            dependents[reference].insert(it.key());
+        }
+    }
+
+    QSet<QString> changed;
+    while ( ! pending.isEmpty() ) {
+        QString key = pending.takeFirst();
+        if ( changed.contains(key) ) {
+            continue;
+        }
+        changed.insert(key);
+        resolved.remove(key);
+        pending << dependents.value(key).toList();
+    }
+
+    return changed;
+}
+
+QString RSArgumentResolver::resolve(const QString& value)
+{
+    if ( ! value.contains("${") ) {
+        return value;
+    }
+    return substitute(value, 0);
+}
+
+QString RSArgumentResolver::substitute(const QString& value, int depth)
+{
+    QString result;
+    int position = 0;
+    int start;
+
+    while ( (start = value.indexOf("${", position)) >= 0 ) {
+        int end = value.indexOf('}', start + 2);
+        if ( end < 0 ) {
+            break;
+        }
+
+        QString key = value.mid(start + 2, end - start - 2);
+        result += value.mid(position, start - position);
+
+        // unknown references stay as they are
+        if ( values.contains(key) ) {
+            result += resolveArgument(key, depth + 1);
+        } else {
+            result += value.mid(start, end - start + 1);
+        }
+
+        position = end + 1;
+    }
+
+    result += value.mid(position);
+    return result;
+}
+
+QString RSArgumentResolver::resolveArgument(const QString& key, int depth)
+{
+    QHash<QString, QString>::const_iterator it = resolved.find(key);
+    if ( it != resolved.end() ) {
+        return it.value();
+    }
+
+    // arguments may refer to other arguments, but not endlessly
+    const QString value = values.value(key);
+    if ( depth > 8 || ! value.contains("${") ) {
+        return value;
+    }
+
+    QString result = substitute(value, depth);
+    resolved.insert(key, result);
+    return result;
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,42 @@
+#ifndef rstools_rsbatch_jobeditor_rsargumentresolver_h
+#define rstools_rsbatch_jobeditor_rsargumentresolver_h
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include "batch/util/rsjob.hpp"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Substitutes ${key} references to job arguments. The resolved value of
+ * every job argument is computed once and kept until that argument or one
+ * it refers to changes, so resolving many task arguments stays cheap.
+ */
+class RSArgumentResolver
+{
+public:
+    RSArgumentResolver();
+
+    void clear();
+    QSet<QString> update(RSJob* job);
+    QSet<QString> update(const QHash<QString, QString>& values);
+    QString resolve(const QString& value);
+
+    static QStringList references(const QString& value);
+
+protected:
+    QString resolveArgument(const QString& key, int depth);
+    QString substitute(const QString& value, int depth);
+
+    QHash<QString, QString> values;
+    QHash<QString, QString> resolved;
+    QHash<QString, QSet<QString> > dependents;   // arguments referring to a key
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
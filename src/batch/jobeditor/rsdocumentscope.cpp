@@ -0,0 +1,205 @@
+#include "rsdocumentscope.h"
+#include "rstoolindex.h"
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <string.h>
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+int RSDocumentScope::openScopes = 0;
+qint64 RSDocumentScope::totalArenaSize = 0;
+
+// jobs may be opened in the background as well
+static QMutex totalsMutex;
+
+RSDocumentScope::RSDocumentScope()
+{
+    chunk = g_string_chunk_new(4096);
+    arenaSize = 0;
+    requestedSize = 0;
+
+    QMutexLocker locker(&totalsMutex);
+    openScopes++;
+}
+
+RSDocumentScope::~RSDocumentScope()
+{
+    g_string_chunk_free(chunk);
+
+    QMutexLocker locker(&totalsMutex);
+    totalArenaSize -= arenaSize;
+    openScopes--;
+}
+
+/*
+ * Only option names of known tools are pooled. Keys of unknown or
+ * misspelled options would stay in the pool for good, they go into the
+ * arena like values.
+ */
+char* RSDocumentScope::copyKey(const char *key)
+{
+    if ( key != NULL && RSToolIndex::getInstance().hasOption(key) ) {
+        return (char*)RSStringPool::getInstance().intern(key);
+    }
+    return copyString(key);
+}
+
+char* RSDocumentScope::copyString(const char *s)
+{
+    if ( s == NULL ) {
+        return NULL;
+    }
+
+    const size_t length = strlen(s);
+    requestedSize += (qint64)length + 1;
+
+    // returns the earlier copy if the job already holds the same value
+    char *copy = g_string_chunk_insert_const(chunk, s);
+    if ( ! strings.contains(copy) ) {
+        strings.insert(copy);
+        arenaSize += (qint64)length + 1;
+
+        QMutexLocker locker(&totalsMutex);
+        totalArenaSize += (qint64)length + 1;
+    }
+
+    return copy;
+}
+
+/*
+ * To be called for a string that the job no longer refers to. Strings that
+ * came from the parser are freed right away, interned strings may still be
+ * shared and stay until the arena or the process goes away.
+ */
+void RSDocumentScope::releaseString(char *s)
+{
+    if ( s != NULL && ! owns(s) ) {
+        rsFree(s);
+    }
+}
+
+bool RSDocumentScope::owns(const void *p) const
+{
+    return strings.contains(p) || RSStringPool::getInstance().contains(p);
+}
+
+/*
+ * Replaces every key and value the parser allocated by an interned copy,
+ * so that the job holds each distinct string only once.
+ */
+void RSDocumentScope::adopt(RSJob *job)
+{
+    vector<rsArgument*> arguments = job->getArguments();
+    for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+        adopt(*it, false);
+    }
+
+    vector<RSTask*> tasks = job->getTasks();
+    for (vector<RSTask*>::iterator t = tasks.begin(); t != tasks.end(); ++t) {
+        arguments = (*t)->getArguments();
+        for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+            adopt(*it, true);
+        }
+    }
+}
+
+// Only option names are pooled, job arguments are named by the user
+void RSDocumentScope::adopt(rsArgument *argument, bool poolKey)
+{
+    if ( argument->key != NULL && ! owns(argument->key) ) {
+        char *key = argument->key;
+        argument->key = poolKey ? copyKey(key) : copyString(key);
+        rsFree(key);
+    }
+    if ( argument->value != NULL && ! owns(argument->value) ) {
+        char *value = argument->value;
+        argument->value = copyString(value);
+        rsFree(value);
+    }
+}
+
+/*
+ * Removes all references to interned strings from the job before it is
+ * deleted, so that whatever the job frees on destruction, it never frees
+ * memory of the arena or the pool.
+ */
+void RSDocumentScope::detach(RSJob *job)
+{
+    vector<rsArgument*> arguments = job->getArguments();
+    for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+        detach(*it);
+    }
+
+    vector<RSTask*> tasks = job->getTasks();
+    for (vector<RSTask*>::iterator t = tasks.begin(); t != tasks.end(); ++t) {
+        arguments = (*t)->getArguments();
+        for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+            detach(*it);
+        }
+    }
+}
+
+void RSDocumentScope::detach(rsArgument *argument)
+{
+    if ( owns(argument->key) ) {
+        argument->key = NULL;
+    }
+    if ( owns(argument->value) ) {
+        argument->value = NULL;
+    }
+}
+
+// Number of distinct values held by the arena
+int RSDocumentScope::getStringCount() const
+{
+    return strings.size();
+}
+
+qint64 RSDocumentScope::getArenaSize() const
+{
+    return arenaSize;
+}
+
+qint64 RSDocumentScope::getRequestedSize() const
+{
+    return requestedSize;
+}
+
+int RSDocumentScope::getOpenScopes()
+{
+    QMutexLocker locker(&totalsMutex);
+    return openScopes;
+}
+
+qint64 RSDocumentScope::getTotalArenaSize()
+{
+    QMutexLocker locker(&totalsMutex);
+    return totalArenaSize;
+}
+
+// Resident set size of the process in kB, or -1 where /proc is not available
+qint64 RSDocumentScope::getResidentMemory()
+{
+    QFile file("/proc/self/status");
+    if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+        return -1;
+    }
+
+    QTextStream stream(&file);
+    QString line;
+    while ( ! (line = stream.readLine()).isNull() ) {
+        if ( line.startsWith("VmRSS:") ) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+}}} // namespace rstools::batch::util
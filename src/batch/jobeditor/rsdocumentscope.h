@@ -0,0 +1,60 @@
+#ifndef rstools_rsbatch_jobeditor_rsdocumentscope_h
+#define rstools_rsbatch_jobeditor_rsdocumentscope_h
+
+#include <QSet>
+#include <QString>
+#include <glib.h>
+#include "batch/util/rsjob.hpp"
+#include "batch/util/rstask.hpp"
+#include "rsstringpool.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Allocation scope of one open job. Task argument keys that are option
+ * names of a known tool are interned in the process-wide RSStringPool.
+ * Values and all other keys are interned in a string arena of the job, so
+ * that a path repeated by many tasks is held once, and the arena is
+ * released in one go when the job is closed. Strings that came from the
+ * parser are freed as soon as they are replaced.
+ */
+class RSDocumentScope
+{
+public:
+    RSDocumentScope();
+    ~RSDocumentScope();
+
+    char* copyKey(const char *key);
+    char* copyString(const char *s);
+    void releaseString(char *s);
+    bool owns(const void *p) const;
+
+    void adopt(RSJob *job);
+    void detach(RSJob *job);
+
+    int getStringCount() const;
+    qint64 getArenaSize() const;
+    qint64 getRequestedSize() const;
+
+    static int getOpenScopes();
+    static qint64 getTotalArenaSize();
+    static qint64 getResidentMemory();
+
+protected:
+    void adopt(rsArgument *argument, bool poolKey);
+    void detach(rsArgument *argument);
+
+    GStringChunk *chunk;
+    QSet<const void*> strings;
+    qint64 arenaSize;        // bytes held by the arena
+    qint64 requestedSize;    // bytes that would have been copied one by one
+
+    static int openScopes;
+    static qint64 totalArenaSize;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,162 @@
+#include "rsfilestatcache.h"
+#include <QMutexLocker>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSFileStatTask::RSFileStatTask(RSFileStatCache *cache, const QString &path, bool listing)
+{
+    this->cache   = cache;
+    this->path    = path;
+    this->listing = listing;
+}
+
+void RSFileStatTask::run()
+{
+    if ( listing ) {
+        cache->fetchListing(path);
+    } else {
+        cache->fetchStat(path);
+    }
+}
+
+RSFileStatCache& RSFileStatCache::getInstance()
+{
+    static RSFileStatCache instance;
+    return instance;
+}
+
+RSFileStatCache::RSFileStatCache() : QObject(0)
+{
+    // slow network filesystems block in the kernel, not on the CPU
+    pool.setMaxThreadCount(4);
+    clock.start();
+}
+
+RSFileStatCache::~RSFileStatCache()
+{
+    pool.waitForDone();
+}
+
+bool RSFileStatCache::isFresh(qint64 fetched)
+{
+    return clock.elapsed() - fetched < timeToLive;
+}
+
+bool RSFileStatCache::lookupStat(const QString &path, rsFileStat &stat)
+{
+    QMutexLocker locker(&mutex);
+    QHash<QString, rsFileStat>::const_iterator it = stats.constFind(path);
+
+    if ( it == stats.constEnd() || ! isFresh(it.value().fetched) ) {
+        return false;
+    }
+
+    stat = it.value();
+    return true;
+}
+
+void RSFileStatCache::requestStat(const QString &path)
+{
+    QMutexLocker locker(&mutex);
+
+    if ( pendingStats.contains(path) ) {
+        return;
+    }
+
+    pendingStats.insert(path);
+    pool.start(new RSFileStatTask(this, path, false));
+}
+
+bool RSFileStatCache::lookupListing(const QString &directory, QStringList &entries)
+{
+    QMutexLocker locker(&mutex);
+    QHash<QString, rsDirectoryListing>::const_iterator it = listings.constFind(directory);
+
+    if ( it == listings.constEnd() || ! isFresh(it.value().fetched) ) {
+        return false;
+    }
+
+    entries = it.value().entries;
+    return true;
+}
+
+void RSFileStatCache::requestListing(const QString &directory)
+{
+    QMutexLocker locker(&mutex);
+
+    if ( pendingListings.contains(directory) ) {
+        return;
+    }
+
+    pendingListings.insert(directory);
+    pool.start(new RSFileStatTask(this, directory, true));
+}
+
+void RSFileStatCache::invalidate(const QString &path)
+{
+    QMutexLocker locker(&mutex);
+    stats.remove(path);
+    listings.remove(path);
+}
+
+// Runs in a worker thread
+void RSFileStatCache::fetchStat(const QString &path)
+{
+    QByteArray p = path.toLocal8Bit();
+    struct stat buffer;
+
+    rsFileStat result;
+    result.exists = ::stat(p.data(), &buffer) == 0;
+    result.isDir  = result.exists && S_ISDIR(buffer.st_mode);
+    result.size   = result.exists ? (qint64)buffer.st_size  : 0;
+    result.mtime  = result.exists ? (qint64)buffer.st_mtime : 0;
+
+    {
+        QMutexLocker locker(&mutex);
+        result.fetched = clock.elapsed();
+        stats.insert(path, result);
+        pendingStats.remove(path);
+    }
+
+    emit statReady(path);
+}
+
+// Runs in a worker thread
+void RSFileStatCache::fetchListing(const QString &directory)
+{
+    QByteArray p = directory.toLocal8Bit();
+    rsDirectoryListing listing;
+
+    DIR *dir = opendir(p.data());
+    if ( dir != NULL ) {
+        struct dirent *entry;
+        while ( (entry = readdir(dir)) != NULL ) {
+            if ( entry->d_name[0] == '.' ) {
+                continue;
+            }
+            QString name = QString::fromLocal8Bit(entry->d_name);
+            if ( entry->d_type == DT_DIR ) {
+                name += QString("/");
+            }
+            listing.entries << name;
+        }
+        closedir(dir);
+    }
+    listing.entries.sort();
+
+    {
+        QMutexLocker locker(&mutex);
+        listing.fetched = clock.elapsed();
+        listings.insert(directory, listing);
+        pendingListings.remove(directory);
+    }
+
+    emit listingReady(directory);
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,92 @@
+#ifndef rstools_rsbatch_jobeditor_rsfilestatcache_h
+#define rstools_rsbatch_jobeditor_rsfilestatcache_h
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    bool exists;
+    bool isDir;
+    qint64 size;
+    qint64 mtime;
+    qint64 fetched;
+} rsFileStat;
+
+typedef struct {
+    QStringList entries;
+    qint64 fetched;
+} rsDirectoryListing;
+
+class RSFileStatCache;
+
+class RSFileStatTask : public QRunnable
+{
+public:
+    RSFileStatTask(RSFileStatCache *cache, const QString &path, bool listing);
+    void run();
+
+protected:
+    RSFileStatCache *cache;
+    QString path;
+    bool listing;
+};
+
+/*
+ * Expiring cache of stat() results and directory listings that is shared
+ * by all SettingWidgets. Lookups never touch the filesystem, misses are
+ * resolved by a small worker pool and announced with statReady() or
+ * listingReady() in the GUI thread.
+ */
+class RSFileStatCache : public QObject
+{
+    Q_OBJECT
+public:
+    static RSFileStatCache& getInstance();
+
+    bool lookupStat(const QString &path, rsFileStat &stat);
+    void requestStat(const QString &path);
+
+    bool lookupListing(const QString &directory, QStringList &entries);
+    void requestListing(const QString &directory);
+
+    void invalidate(const QString &path);
+
+    static const qint64 timeToLive = 10000; // ms
+
+signals:
+    void statReady(const QString &path);
+    void listingReady(const QString &directory);
+
+protected:
+    friend class RSFileStatTask;
+
+    RSFileStatCache();
+    ~RSFileStatCache();
+
+    void fetchStat(const QString &path);
+    void fetchListing(const QString &directory);
+    bool isFresh(qint64 fetched);
+
+    QThreadPool pool;
+    QMutex mutex;
+    QElapsedTimer clock;
+    QHash<QString, rsFileStat> stats;
+    QHash<QString, rsDirectoryListing> listings;
+    QSet<QString> pendingStats;
+    QSet<QString> pendingListings;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
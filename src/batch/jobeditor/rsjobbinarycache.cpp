@@ -0,0 +1,377 @@
+#include "rsjobbinarycache.h"
+#include "rsjobutils.h"
+#include "rsrunhistory.h"
+#include "rstaskcache.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSettings>
+#include <QTemporaryFile>
+#include <QVector>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utime.h>
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+static const char binaryMagic[8] = { 'R', 'S', 'J', 'O', 'B', 'B', 'I', 'N' };
+static const quint32 byteOrderMark = 0x01020304;
+static const quint32 noString = 0xffffffff;
+
+/*
+ * The file starts with the header, followed by the job arguments, the
+ * tasks, the arguments of all tasks one after another and finally the
+ * string table. Everything is written in host byte order, a cache file
+ * from a machine with a different one is simply not used.
+ */
+typedef struct {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 mtime;            // of the job file, in ms
+    qint64 size;
+    char hash[64];           // RSTaskCache::hashFileContents() of the job file
+    quint32 nArguments;
+    quint32 nTasks;
+    quint32 nTaskArguments;
+    quint32 stringTableSize;
+} rsJobBinaryHeader;
+
+typedef struct {
+    quint32 key;             // offsets into the string table
+    quint32 value;           // noString for flags
+} rsJobBinaryArgument;
+
+typedef struct {
+    quint32 code;
+    quint32 description;
+    quint32 firstArgument;
+    quint32 nArguments;
+} rsJobBinaryTask;
+
+// Collects NUL-terminated strings, each distinct one only once
+class RSBinaryStringTable
+{
+public:
+    quint32 add(const char *s)
+    {
+        if ( s == NULL ) {
+            return noString;
+        }
+
+        QByteArray string(s);
+        QHash<QByteArray, quint32>::const_iterator it = offsets.find(string);
+        if ( it != offsets.end() ) {
+            return it.value();
+        }
+
+        const quint32 offset = (quint32)data.size();
+        data.append(string.constData(), string.size() + 1);
+        offsets.insert(string, offset);
+        return offset;
+    }
+
+    QByteArray data;
+
+protected:
+    QHash<QByteArray, quint32> offsets;
+};
+
+static rsJobBinaryArgument writeArgument(RSBinaryStringTable &strings, rsArgument *argument)
+{
+    rsJobBinaryArgument result;
+    result.key   = strings.add(argument->key);
+    result.value = strings.add(argument->value);
+    return result;
+}
+
+static bool isValidString(quint32 offset, quint32 stringTableSize, bool optional)
+{
+    return offset < stringTableSize || (optional && offset == noString);
+}
+
+static bool isValidArgument(const rsJobBinaryArgument &argument, quint32 stringTableSize)
+{
+    return isValidString(argument.key, stringTableSize, false)
+        && isValidString(argument.value, stringTableSize, true);
+}
+
+// Job arguments are named by the user, their keys are kept in the arena
+static rsArgument* readArgument(const rsJobBinaryArgument &argument, const char *strings, RSDocumentScope *scope, bool jobArgument)
+{
+    rsArgument *result = (rsArgument*)rsMalloc(sizeof(rsArgument));
+    result->key   = jobArgument ? scope->copyString(strings + argument.key) : scope->copyKey(strings + argument.key);
+    result->value = argument.value == noString ? NULL : scope->copyString(strings + argument.value);
+    return result;
+}
+
+RSJobBinaryCache& RSJobBinaryCache::getInstance()
+{
+    static RSJobBinaryCache instance;
+    return instance;
+}
+
+RSJobBinaryCache::RSJobBinaryCache()
+{
+
+}
+
+bool RSJobBinaryCache::isEnabled()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("jobs/binaryCache", true).toBool();
+}
+
+QString RSJobBinaryCache::getDirectory()
+{
+    QString directory = RSRunHistory::getDataDirectory() + QString("/jobs");
+    QDir().mkpath(directory);
+    return directory;
+}
+
+// One cache file per job file, named after the hash of its absolute path
+QString RSJobBinaryCache::getCachePath(const QString& path)
+{
+    QByteArray p = QFileInfo(path).absoluteFilePath().toUtf8();
+    gchar *name = g_compute_checksum_for_data(G_CHECKSUM_SHA256, (const guchar*)p.data(), p.size());
+    QString result = getDirectory() + QString("/") + QString(name) + QString(".bin");
+    g_free(name);
+    return result;
+}
+
+/*
+ * Builds the job from its cache file if there is a valid one. The job is
+ * created from the empty job template, whose parser is returned as well.
+ * The caller deletes the job and then the parser, just like for a parsed
+ * job file. Returns NULL if the job has to be parsed from its XML instead.
+ */
+RSJob* RSJobBinaryCache::load(const QString& path, RSJobParser*& parser, RSDocumentScope* scope, QString& hash)
+{
+    QFileInfo info(path);
+    if ( ! isEnabled() || ! info.isFile() ) {
+        return NULL;
+    }
+
+    QFile file(getCachePath(path));
+    if ( ! file.open(QIODevice::ReadOnly) ) {
+        return NULL;
+    }
+
+    // the mapping is released together with the file
+    const qint64 fileSize = file.size();
+    if ( fileSize < (qint64)sizeof(rsJobBinaryHeader) ) {
+        return NULL;
+    }
+    const uchar *data = file.map(0, fileSize);
+    if ( data == NULL ) {
+        return NULL;
+    }
+
+    rsJobBinaryHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if ( memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0
+      || header.version != version
+      || header.byteOrder != byteOrderMark ) {
+        return NULL;
+    }
+
+    const qint64 expectedSize = (qint64)sizeof(rsJobBinaryHeader)
+        + (qint64)header.nArguments * sizeof(rsJobBinaryArgument)
+        + (qint64)header.nTasks * sizeof(rsJobBinaryTask)
+        + (qint64)header.nTaskArguments * sizeof(rsJobBinaryArgument)
+        + (qint64)header.stringTableSize;
+    if ( expectedSize != fileSize ) {
+        return NULL;
+    }
+
+    if ( header.mtime != info.lastModified().toMSecsSinceEpoch() || header.size != info.size() ) {
+        // the file may have been touched without being changed, unless
+        // the copy was written without knowing the hash
+        if ( header.hash[0] == '\0' ) {
+            return NULL;
+        }
+        hash = RSTaskCache::hashFileContents(info.absoluteFilePath());
+        QByteArray h = hash.toLatin1();
+        if ( h.size() != (int)sizeof(header.hash) || memcmp(h.constData(), header.hash, sizeof(header.hash)) != 0 ) {
+            return NULL;
+        }
+    }
+
+    const rsJobBinaryArgument *arguments = (const rsJobBinaryArgument*)(data + sizeof(rsJobBinaryHeader));
+    const rsJobBinaryTask *tasks = (const rsJobBinaryTask*)(arguments + header.nArguments);
+    const rsJobBinaryArgument *taskArguments = (const rsJobBinaryArgument*)(tasks + header.nTasks);
+    const char *strings = (const char*)(taskArguments + header.nTaskArguments);
+
+    // every offset has to point into the table and every string has to
+    // end within it before anything is read
+    if ( header.stringTableSize > 0 && strings[header.stringTableSize - 1] != '\0' ) {
+        return NULL;
+    }
+    for ( quint32 i=0; i<header.nArguments; i++ ) {
+        if ( ! isValidArgument(arguments[i], header.stringTableSize) ) {
+            return NULL;
+        }
+    }
+    for ( quint32 i=0; i<header.nTaskArguments; i++ ) {
+        if ( ! isValidArgument(taskArguments[i], header.stringTableSize) ) {
+            return NULL;
+        }
+    }
+    for ( quint32 i=0; i<header.nTasks; i++ ) {
+        const rsJobBinaryTask &task = tasks[i];
+        if ( ! isValidString(task.code, header.stringTableSize, false)
+          || ! isValidString(task.description, header.stringTableSize, true)
+          || task.firstArgument > header.nTaskArguments
+          || task.nArguments > header.nTaskArguments - task.firstArgument ) {
+            return NULL;
+        }
+    }
+
+    parser = rsJobParseEmpty();
+    RSJob *job = parser->getJob();
+
+    for ( quint32 i=0; i<header.nArguments; i++ ) {
+        job->addArgument(readArgument(arguments[i], strings, scope, true));
+    }
+
+    for ( quint32 i=0; i<header.nTasks; i++ ) {
+        const rsJobBinaryTask &t = tasks[i];
+        RSTask *task = RSTask::taskFactory(strings + t.code);
+
+        if ( task == NULL ) {
+            // leave unknown tools to the parser and its error messages
+            scope->detach(job);
+            delete job;
+            delete parser;
+            parser = NULL;
+            return NULL;
+        }
+
+        if ( t.description != noString ) {
+            const char *description = strings + t.description;
+            char *copy = (char*)malloc(sizeof(char)*(strlen(description)+1));
+            strcpy(copy, description);
+            task->setDescription(copy);
+        }
+
+        for ( quint32 a=t.firstArgument; a<t.firstArgument+t.nArguments; a++ ) {
+            task->addArgument(readArgument(taskArguments[a], strings, scope, false));
+        }
+
+        job->addTask(task);
+    }
+
+    // the modification time of a cache file tells when it was last used
+    QByteArray c = QFile::encodeName(file.fileName());
+    utime(c.data(), NULL);
+
+    return job;
+}
+
+/*
+ * Writes the cache file of a job that was just parsed or saved. The file is
+ * not read again for its hash: without one, the copy is only valid as long
+ * as the job file keeps its size and modification time.
+ */
+void RSJobBinaryCache::store(const QString& path, RSJob* job, const QString& hash)
+{
+    if ( ! isEnabled() ) {
+        return;
+    }
+
+    QFileInfo info(path);
+    QByteArray h = hash.toLatin1();
+
+    rsJobBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    if ( h.size() == (int)sizeof(header.hash) ) {
+        memcpy(header.hash, h.constData(), sizeof(header.hash));
+    }
+    header.version   = version;
+    header.byteOrder = byteOrderMark;
+    header.mtime     = info.lastModified().toMSecsSinceEpoch();
+    header.size      = info.size();
+
+    RSBinaryStringTable strings;
+    QVector<rsJobBinaryArgument> arguments;
+    QVector<rsJobBinaryTask> tasks;
+    QVector<rsJobBinaryArgument> taskArguments;
+
+    vector<rsArgument*> jobArguments = job->getArguments();
+    for (vector<rsArgument*>::iterator it = jobArguments.begin(); it != jobArguments.end(); ++it) {
+        arguments << writeArgument(strings, *it);
+    }
+
+    vector<RSTask*> jobTasks = job->getTasks();
+    for (vector<RSTask*>::iterator t = jobTasks.begin(); t != jobTasks.end(); ++t) {
+        rsJobBinaryTask task;
+        task.code          = strings.add((*t)->getCode());
+        task.description   = strings.add((*t)->getDescription());
+        task.firstArgument = (quint32)taskArguments.size();
+
+        vector<rsArgument*> args = (*t)->getArguments();
+        for (vector<rsArgument*>::iterator it = args.begin(); it != args.end(); ++it) {
+            taskArguments << writeArgument(strings, *it);
+        }
+
+        task.nArguments = (quint32)taskArguments.size() - task.firstArgument;
+        tasks << task;
+    }
+
+    header.nArguments      = (quint32)arguments.size();
+    header.nTasks          = (quint32)tasks.size();
+    header.nTaskArguments  = (quint32)taskArguments.size();
+    header.stringTableSize = (quint32)strings.data.size();
+
+    // another thread or editor may be writing the same job at the same time
+    QString cachePath = getCachePath(path);
+    QTemporaryFile file(cachePath + QString(".XXXXXX"));
+    if ( ! file.open() ) {
+        return;
+    }
+
+    bool written =
+        file.write((const char*)&header, sizeof(header)) == (qint64)sizeof(header)
+     && file.write((const char*)arguments.constData(), arguments.size() * sizeof(rsJobBinaryArgument)) == (qint64)(arguments.size() * sizeof(rsJobBinaryArgument))
+     && file.write((const char*)tasks.constData(), tasks.size() * sizeof(rsJobBinaryTask)) == (qint64)(tasks.size() * sizeof(rsJobBinaryTask))
+     && file.write((const char*)taskArguments.constData(), taskArguments.size() * sizeof(rsJobBinaryArgument)) == (qint64)(taskArguments.size() * sizeof(rsJobBinaryArgument))
+     && file.write(strings.data) == (qint64)strings.data.size();
+    file.close();
+
+    if ( ! written ) {
+        return;
+    }
+
+    // replaces an existing copy in one step, readers see the old or the new
+    QByteArray from = QFile::encodeName(file.fileName());
+    QByteArray to = QFile::encodeName(cachePath);
+    if ( ::rename(from.data(), to.data()) == 0 ) {
+        file.setAutoRemove(false);
+    }
+
+    evict();
+}
+
+// Removes the least recently used cache files beyond maxEntries
+void RSJobBinaryCache::evict()
+{
+    QDir directory(getDirectory());
+    QFileInfoList entries = directory.entryInfoList(QStringList() << QString("*.bin"), QDir::Files, QDir::Time);
+
+    // sorted by modification time, the most recently used first
+    for ( int i=maxEntries; i<entries.size(); i++ ) {
+        QFile::remove(entries.at(i).absoluteFilePath());
+    }
+}
+
+}}} // namespace rstools::batch::util
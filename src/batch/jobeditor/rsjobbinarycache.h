@@ -0,0 +1,46 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobbinarycache_h
+#define rstools_rsbatch_jobeditor_rsjobbinarycache_h
+
+#include <QString>
+#include "batch/util/rsjob.hpp"
+#include "batch/util/rstask.hpp"
+#include "batch/util/rsjobparser.hpp"
+#include "rsdocumentscope.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Keeps a compact binary copy of every job that was opened or saved, so
+ * that reopening a large job does not have to parse its XML again. The
+ * copy holds the job and task arguments as offsets into one string table
+ * and is mapped when the job is loaded. It is valid as long as the job
+ * file has the size and modification time it had when the copy was
+ * written, or else still the same content hash if that was known at the
+ * time. Only the most recently used copies are kept, see maxEntries.
+ */
+class RSJobBinaryCache
+{
+public:
+    static RSJobBinaryCache& getInstance();
+
+    RSJob* load(const QString& path, RSJobParser*& parser, RSDocumentScope* scope, QString& hash);
+    void store(const QString& path, RSJob* job, const QString& hash = QString());
+
+    bool isEnabled();
+    QString getCachePath(const QString& path);
+
+    static const quint32 version = 1;
+    static const int maxEntries = 256;
+
+protected:
+    RSJobBinaryCache();
+
+    QString getDirectory();
+    void evict();
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,256 @@
+#include "rsjobcomparison.h"
+#include "rsjobdiff.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobComparison::RSJobComparison(const RSJobSnapshot &from, const RSJobSnapshot &to)
+{
+    this->from = from;
+    this->to = to;
+
+    RSJobDiff diff(from, to);
+    if ( diff.argumentsChanged() ) {
+        arguments = compareArguments(from.getArguments(), to.getArguments());
+    }
+
+    const int n = from.getTaskCount();
+    const int m = to.getTaskCount();
+    QList<int> matches = diff.getMatches();
+    QVector<int> partners(n, -1);
+    QVector<rsTaskChangeType> types(m, TASK_ADDED);
+
+    for ( int j=0; j<m; j++ ) {
+        if ( matches[j] >= 0 ) {
+            partners[matches[j]] = j;
+            types[j] = TASK_UNCHANGED;
+        }
+    }
+
+    // identical tasks that are left over on both sides have been moved
+    QHash<QByteArray, QList<int> > leftOver;
+    for ( int i=0; i<n; i++ ) {
+        if ( partners[i] < 0 ) {
+            leftOver[from.getTask(i).hash] << i;
+        }
+    }
+    for ( int j=0; j<m; j++ ) {
+        if ( types[j] != TASK_ADDED ) {
+            continue;
+        }
+        QHash<QByteArray, QList<int> >::iterator it = leftOver.find(to.getTask(j).hash);
+        if ( it != leftOver.end() && ! it->isEmpty() ) {
+            matches[j] = it->takeFirst();
+            partners[matches[j]] = j;
+            types[j] = TASK_MOVED;
+        }
+    }
+
+    // the tool of a task is never edited, so a task of the same tool between
+    // the same unchanged neighbours is the edited version of the old one
+    QVector<int> next(m + 1, n);
+    for ( int j=m-1; j>=0; j-- ) {
+        next[j] = types[j] == TASK_UNCHANGED ? matches[j] : next[j + 1];
+    }
+
+    int previous = -1;
+    for ( int j=0; j<m; j++ ) {
+        if ( types[j] == TASK_UNCHANGED ) {
+            previous = matches[j];
+            continue;
+        }
+        if ( types[j] != TASK_ADDED ) {
+            continue;
+        }
+        for ( int i=previous+1; i<next[j]; i++ ) {
+            if ( partners[i] < 0 && from.getTask(i).code == to.getTask(j).code ) {
+                matches[j] = i;
+                partners[i] = j;
+                types[j] = TASK_CHANGED;
+                break;
+            }
+        }
+    }
+
+    int removedUpTo = 0;
+    for ( int j=0; j<m; j++ ) {
+        if ( types[j] == TASK_UNCHANGED ) {
+            appendRemoved(partners, removedUpTo, matches[j]);
+            removedUpTo = matches[j] + 1;
+        }
+
+        rsTaskChange change;
+        change.type = types[j];
+        change.from = types[j] == TASK_ADDED ? -1 : matches[j];
+        change.to = j;
+        change.descriptionChanged = false;
+
+        if ( change.type == TASK_CHANGED ) {
+            const rsTaskSnapshot &a = from.getTask(change.from);
+            const rsTaskSnapshot &b = to.getTask(j);
+            change.descriptionChanged = a.description != b.description;
+            change.arguments = compareArguments(a.arguments, b.arguments);
+        }
+
+        tasks << change;
+    }
+    appendRemoved(partners, removedUpTo, n);
+}
+
+void RSJobComparison::appendRemoved(const QVector<int> &partners, int begin, int end)
+{
+    for ( int i=begin; i<end; i++ ) {
+        if ( partners[i] >= 0 ) {
+            continue;
+        }
+        rsTaskChange change;
+        change.type = TASK_REMOVED;
+        change.from = i;
+        change.to = -1;
+        change.descriptionChanged = false;
+        tasks << change;
+    }
+}
+
+bool RSJobComparison::isIdentical() const
+{
+    return arguments.isEmpty() && count(TASK_UNCHANGED) == tasks.size();
+}
+
+int RSJobComparison::count(rsTaskChangeType type) const
+{
+    int result = 0;
+    foreach( const rsTaskChange &change, tasks ) {
+        if ( change.type == type ) {
+            result++;
+        }
+    }
+    return result;
+}
+
+QList<rsTaskChange> RSJobComparison::getTasks() const
+{
+    return tasks;
+}
+
+QList<rsArgumentChange> RSJobComparison::getArgumentChanges() const
+{
+    return arguments;
+}
+
+/*
+ * Arguments by key. A key that is given more than once gets the number of
+ * its occurrence appended, so that repetitions are compared in order.
+ */
+QHash<QString, rsArgumentSnapshot> RSJobComparison::indexArguments(const QList<rsArgumentSnapshot> &arguments, QStringList &ids)
+{
+    QHash<QString, rsArgumentSnapshot> result;
+    QHash<QString, int> occurrences;
+
+    foreach( const rsArgumentSnapshot &argument, arguments ) {
+        int occurrence = occurrences[argument.key]++;
+        QString id = occurrence == 0 ? argument.key : argument.key + QChar(0) + QString::number(occurrence);
+        ids << id;
+        result.insert(id, argument);
+    }
+
+    return result;
+}
+
+// Changed, added and removed arguments in the order of the second list
+QList<rsArgumentChange> RSJobComparison::compareArguments(const QList<rsArgumentSnapshot> &from, const QList<rsArgumentSnapshot> &to)
+{
+    QStringList fromIds, toIds;
+    QHash<QString, rsArgumentSnapshot> a = indexArguments(from, fromIds);
+    QHash<QString, rsArgumentSnapshot> b = indexArguments(to, toIds);
+
+    QStringList ids = toIds;
+    foreach( const QString &id, fromIds ) {
+        if ( ! b.contains(id) ) {
+            ids << id;
+        }
+    }
+
+    QList<rsArgumentChange> changes;
+    foreach( const QString &id, ids ) {
+        rsArgumentChange change;
+        change.inFrom = a.contains(id);
+        change.inTo = b.contains(id);
+        change.from = a.value(id);
+        change.to = b.value(id);
+        change.key = change.inTo ? change.to.key : change.from.key;
+
+        if ( change.inFrom && change.inTo
+          && change.from.hasValue == change.to.hasValue
+          && change.from.value == change.to.value ) {
+            continue;
+        }
+        changes << change;
+    }
+
+    return changes;
+}
+
+QString RSJobComparison::formatValue(bool present, const rsArgumentSnapshot &argument)
+{
+    if ( ! present ) {
+        return QString("(none)");
+    }
+    if ( ! argument.hasValue ) {
+        return QString("(set)");
+    }
+    return QString("\"%1\"").arg(argument.value);
+}
+
+QString RSJobComparison::formatTask(int index, const rsTaskSnapshot &task)
+{
+    return QString("%1. %2 (%3)").arg(index + 1).arg(task.description).arg(task.code);
+}
+
+// One line per change, as printed by rsjobeditor --diff
+QStringList RSJobComparison::toText() const
+{
+    QStringList lines;
+
+    foreach( const rsArgumentChange &argument, arguments ) {
+        lines << QString("* job argument %1: %2 -> %3")
+            .arg(argument.key)
+            .arg(formatValue(argument.inFrom, argument.from))
+            .arg(formatValue(argument.inTo, argument.to));
+    }
+
+    foreach( const rsTaskChange &change, tasks ) {
+        switch ( change.type ) {
+            case TASK_UNCHANGED:
+                break;
+            case TASK_ADDED:
+                lines << QString("+ ") + formatTask(change.to, to.getTask(change.to));
+                break;
+            case TASK_REMOVED:
+                lines << QString("- ") + formatTask(change.from, from.getTask(change.from));
+                break;
+            case TASK_MOVED:
+                lines << QString("> %1, moved from %2").arg(formatTask(change.to, to.getTask(change.to))).arg(change.from + 1);
+                break;
+            case TASK_CHANGED:
+                lines << QString("~ ") + formatTask(change.to, to.getTask(change.to));
+                if ( change.descriptionChanged ) {
+                    lines << QString("    description: \"%1\" -> \"%2\"")
+                        .arg(from.getTask(change.from).description)
+                        .arg(to.getTask(change.to).description);
+                }
+                foreach( const rsArgumentChange &argument, change.arguments ) {
+                    lines << QString("    %1: %2 -> %3")
+                        .arg(argument.key)
+                        .arg(formatValue(argument.inFrom, argument.from))
+                        .arg(formatValue(argument.inTo, argument.to));
+                }
+                break;
+        }
+    }
+
+    return lines;
+}
+
+}}} // namespace rstools::batch::util
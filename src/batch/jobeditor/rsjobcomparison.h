@@ -0,0 +1,75 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobcomparison_h
+#define rstools_rsbatch_jobeditor_rsjobcomparison_h
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef enum {
+    TASK_UNCHANGED = 0,
+    TASK_CHANGED,            // same tool at the same place, other arguments
+    TASK_MOVED,              // identical task at another place
+    TASK_ADDED,
+    TASK_REMOVED
+} rsTaskChangeType;
+
+typedef struct {
+    QString key;
+    bool inFrom;
+    bool inTo;
+    rsArgumentSnapshot from;
+    rsArgumentSnapshot to;
+} rsArgumentChange;
+
+typedef struct {
+    rsTaskChangeType type;
+    int from;                // index in the first job, -1 if added
+    int to;                  // index in the second job, -1 if removed
+    bool descriptionChanged;
+    QList<rsArgumentChange> arguments;
+} rsTaskChange;
+
+/*
+ * What was changed between two versions of a job, on the level of tasks
+ * and their arguments. Builds on the alignment of RSJobDiff: tasks that
+ * are left over on both sides are taken as moved if they are identical
+ * and as changed if they use the same tool between the same unchanged
+ * neighbours. The changes are listed in the order of the second job, with
+ * removed tasks where they used to be.
+ */
+class RSJobComparison
+{
+public:
+    RSJobComparison(const RSJobSnapshot &from, const RSJobSnapshot &to);
+
+    bool isIdentical() const;
+    int count(rsTaskChangeType type) const;
+
+    QList<rsTaskChange> getTasks() const;
+    QList<rsArgumentChange> getArgumentChanges() const;
+    QStringList toText() const;
+
+    static QList<rsArgumentChange> compareArguments(const QList<rsArgumentSnapshot> &from, const QList<rsArgumentSnapshot> &to);
+    static QHash<QString, rsArgumentSnapshot> indexArguments(const QList<rsArgumentSnapshot> &arguments, QStringList &ids);
+    static QString formatValue(bool present, const rsArgumentSnapshot &argument);
+    static QString formatTask(int index, const rsTaskSnapshot &task);
+
+protected:
+    void appendRemoved(const QVector<int> &partners, int begin, int end);
+
+    RSJobSnapshot from;
+    RSJobSnapshot to;
+    QList<rsTaskChange> tasks;
+    QList<rsArgumentChange> arguments;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
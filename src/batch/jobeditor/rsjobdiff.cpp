@@ -0,0 +1,172 @@
+#include "rsjobdiff.h"
+#include <QCryptographicHash>
+#include <QPair>
+#include <QtAlgorithms>
+#include <QVector>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobDiff::RSJobDiff(const RSJobSnapshot &from, const RSJobSnapshot &to)
+{
+    arguments = ! equalArguments(from.getArguments(), to.getArguments());
+
+    QList<QByteArray> fromHashes, toHashes;
+    for ( int i=0; i<from.getTaskCount(); i++ ) {
+        fromHashes << from.getTask(i).hash;
+    }
+    for ( int j=0; j<to.getTaskCount(); j++ ) {
+        toHashes << to.getTask(j).hash;
+    }
+    matches = matchSequences(fromHashes, toHashes);
+
+    const int n = fromHashes.size();
+    QVector<bool> matched(n, false);
+    foreach( int match, matches ) {
+        if ( match >= 0 ) {
+            matched[match] = true;
+        }
+    }
+    for ( int k=0; k<n; k++ ) {
+        if ( ! matched[k] ) {
+            removed << k;
+        }
+    }
+}
+
+bool RSJobDiff::isEmpty() const
+{
+    return ! arguments && removed.isEmpty() && ! matches.contains(-1);
+}
+
+bool RSJobDiff::argumentsChanged() const
+{
+    return arguments;
+}
+
+QList<int> RSJobDiff::getMatches() const
+{
+    return matches;
+}
+
+QList<int> RSJobDiff::getRemovedTasks() const
+{
+    return removed;
+}
+
+QList<int> RSJobDiff::getAddedTasks() const
+{
+    QList<int> added;
+    for ( int j=0; j<matches.size(); j++ ) {
+        if ( matches[j] < 0 ) {
+            added << j;
+        }
+    }
+    return added;
+}
+
+QByteArray RSJobDiff::hashTask(const rsTaskSnapshot &task)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(task.code.toUtf8());
+    hash.addData("", 1);
+    hash.addData(task.description.toUtf8());
+    hash.addData("", 1);
+
+    // the order of the arguments does not matter, only that of repeated
+    // ones with the same key
+    QList<QPair<QString, int> > order;
+    for ( int i=0; i<task.arguments.size(); i++ ) {
+        order << qMakePair(task.arguments[i].key, i);
+    }
+    qSort(order);
+
+    for ( int i=0; i<order.size(); i++ ) {
+        const rsArgumentSnapshot &argument = task.arguments[order[i].second];
+        hash.addData(argument.key.toUtf8());
+        if ( argument.hasValue ) {
+            hash.addData("=", 1);
+            hash.addData(argument.value.toUtf8());
+        }
+        hash.addData("", 1);
+    }
+
+    return hash.result();
+}
+
+/*
+ * For every element of `to`, the index of the element of `from` it is
+ * matched with or -1, following the longest common subsequence of both.
+ */
+QList<int> RSJobDiff::matchSequences(const QList<QByteArray> &from, const QList<QByteArray> &to)
+{
+    QList<int> matches;
+    const int n = from.size();
+    const int m = to.size();
+    for ( int j=0; j<m; j++ ) {
+        matches << -1;
+    }
+
+    // jobs are mostly edited in a few places, so the common beginning and
+    // end are matched right away
+    int prefix = 0;
+    while ( prefix < n && prefix < m && from[prefix] == to[prefix] ) {
+        matches[prefix] = prefix;
+        prefix++;
+    }
+
+    int suffix = 0;
+    while ( suffix < n - prefix && suffix < m - prefix
+         && from[n - 1 - suffix] == to[m - 1 - suffix] ) {
+        matches[m - 1 - suffix] = n - 1 - suffix;
+        suffix++;
+    }
+
+    // longest common subsequence of what is left in between
+    const int rows = n - prefix - suffix;
+    const int columns = m - prefix - suffix;
+    QVector<int> lengths((rows + 1) * (columns + 1), 0);
+
+    for ( int i=rows-1; i>=0; i-- ) {
+        for ( int j=columns-1; j>=0; j-- ) {
+            int &length = lengths[i * (columns + 1) + j];
+            if ( from[prefix + i] == to[prefix + j] ) {
+                length = lengths[(i + 1) * (columns + 1) + j + 1] + 1;
+            } else {
+                length = qMax(lengths[(i + 1) * (columns + 1) + j], lengths[i * (columns + 1) + j + 1]);
+            }
+        }
+    }
+
+    int i = 0, j = 0;
+    while ( i < rows && j < columns ) {
+        if ( from[prefix + i] == to[prefix + j] ) {
+            matches[prefix + j] = prefix + i;
+            i++;
+            j++;
+        } else if ( lengths[(i + 1) * (columns + 1) + j] >= lengths[i * (columns + 1) + j + 1] ) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+
+    return matches;
+}
+
+bool RSJobDiff::equalArguments(const QList<rsArgumentSnapshot> &a, const QList<rsArgumentSnapshot> &b)
+{
+    if ( a.size() != b.size() ) {
+        return false;
+    }
+
+    for ( int i=0; i<a.size(); i++ ) {
+        if ( a[i].key != b[i].key || a[i].hasValue != b[i].hasValue || a[i].value != b[i].value ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}}} // namespace rstools::batch::util
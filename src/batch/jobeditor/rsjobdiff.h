@@ -0,0 +1,43 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobdiff_h
+#define rstools_rsbatch_jobeditor_rsjobdiff_h
+
+#include <QByteArray>
+#include <QList>
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Compares two versions of a job task by task. Tasks are told apart by a
+ * hash of their tool, description and arguments, and the longest sequence
+ * of identical tasks that both versions share in the same order is taken
+ * as unchanged. Everything else counts as removed from the first version
+ * and added to the second one, a changed task being both.
+ */
+class RSJobDiff
+{
+public:
+    RSJobDiff(const RSJobSnapshot &from, const RSJobSnapshot &to);
+
+    bool isEmpty() const;
+    bool argumentsChanged() const;
+
+    QList<int> getMatches() const;
+    QList<int> getRemovedTasks() const;
+    QList<int> getAddedTasks() const;
+
+    static QByteArray hashTask(const rsTaskSnapshot &task);
+    static QList<int> matchSequences(const QList<QByteArray> &from, const QList<QByteArray> &to);
+    static bool equalArguments(const QList<rsArgumentSnapshot> &a, const QList<rsArgumentSnapshot> &b);
+
+protected:
+    QList<int> matches;      // for every task of `to`, the identical one of `from` or -1
+    QList<int> removed;      // tasks of `from` without a match
+    bool arguments;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,301 @@
+#include "rsjobdocument.h"
+#include "rsjobbinarycache.h"
+#include "rsjobdiff.h"
+#include "rstoolindex.h"
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobDocument::RSJobDocument(const char *path, QObject *parent, bool updateCache) : QObject(parent)
+{
+    this->path = QString::fromUtf8(path);
+    revision = 0;
+
+    scope = new RSDocumentScope();
+
+    // the binary copy already holds interned strings
+    RSJobBinaryCache &cache = RSJobBinaryCache::getInstance();
+    QString hash;
+    job = cache.load(this->path, parser, scope, hash);
+
+    if ( job == NULL ) {
+        parser = new RSJobParser((char*)path);
+        parser->parse();
+        job = parser->getJob();
+        scope->adopt(job);
+        if ( updateCache ) {
+            cache.store(this->path, job, hash);
+        }
+    }
+
+    vector<RSTask*> jobTasks = job->getTasks();
+    for ( size_t i=0; i<jobTasks.size(); i++ ) {
+        taskIndices.insert(jobTasks[i], (int)i);
+        tasks << rsTaskSnapshotPointer();
+    }
+
+    savedRevision = revision;
+    saved = snapshot();
+}
+
+/*
+ * Snapshots that are still held by workers stay valid, they do not refer
+ * to anything that is released here.
+ */
+RSJobDocument::~RSJobDocument()
+{
+    if ( job != NULL ) {
+        scope->detach(job);
+        delete job;
+    }
+    delete parser;
+    delete scope;
+}
+
+RSJob* RSJobDocument::getJob()
+{
+    return job;
+}
+
+RSDocumentScope* RSJobDocument::getScope()
+{
+    return scope;
+}
+
+QString RSJobDocument::getPath()
+{
+    return path;
+}
+
+qint64 RSJobDocument::getRevision()
+{
+    return revision;
+}
+
+// Whether there are edits that have not been saved
+bool RSJobDocument::isModified()
+{
+    return revision != savedRevision;
+}
+
+void RSJobDocument::markSaved()
+{
+    savedRevision = revision;
+    saved = snapshot();
+}
+
+RSJobSnapshot RSJobDocument::getSavedSnapshot()
+{
+    return saved;
+}
+
+int RSJobDocument::indexOf(RSTask *task)
+{
+    return taskIndices.value(task, -1);
+}
+
+/*
+ * Sets a task argument, adding it if the task does not have it yet. A draft
+ * value is still being edited and is kept outside the arena, so that it is
+ * freed as soon as the next edit replaces it, see commitTaskArgument().
+ */
+void RSJobDocument::setTaskArgument(RSTask *task, const char *key, const char *value, bool draft)
+{
+    rsArgument* argument = task->getArgument(key);
+    char *copy = draft && value != NULL ? rsString(value) : scope->copyString(value);
+
+    if ( argument != NULL ) {
+        char *old = argument->value;
+        argument->value = copy;
+        scope->releaseString(old);
+    } else {
+        argument = (rsArgument*)rsMalloc(sizeof(rsArgument));
+        argument->key = scope->copyKey(key);
+        argument->value = copy;
+        task->addArgument(argument);
+    }
+
+    taskChanged(task, key);
+}
+
+// Moves a draft value into the arena once it is no longer being edited
+void RSJobDocument::commitTaskArgument(RSTask *task, const char *key)
+{
+    rsArgument* argument = task->getArgument(key);
+    if ( argument == NULL || argument->value == NULL || scope->owns(argument->value) ) {
+        return;
+    }
+
+    // the value itself does not change, neither do the snapshots
+    char *draft = argument->value;
+    argument->value = scope->copyString(draft);
+    scope->releaseString(draft);
+}
+
+// Adds or removes a task argument that does not take a value
+void RSJobDocument::setTaskFlag(RSTask *task, const char *key, bool enabled)
+{
+    rsArgument* argument = task->getArgument(key);
+
+    if ( enabled ) {
+        if ( argument != NULL ) {
+            return;
+        }
+        argument = (rsArgument*)rsMalloc(sizeof(rsArgument));
+        argument->key = scope->copyKey(key);
+        argument->value = NULL;
+        task->addArgument(argument);
+    } else {
+        if ( argument == NULL ) {
+            return;
+        }
+        task->removeArgument(key);
+    }
+
+    taskChanged(task, key);
+}
+
+void RSJobDocument::appendTask(RSTask *task)
+{
+    job->addTask(task);
+
+    const int index = tasks.size();
+    taskIndices.insert(task, index);
+    tasks << rsTaskSnapshotPointer();
+    revision++;
+
+    emit taskAppended(index);
+    emit changed(revision);
+}
+
+// Returns the index of the new job argument
+int RSJobDocument::appendJobArgument(const char *key, const char *value)
+{
+    // job arguments are named by the user, so their keys are not pooled
+    rsArgument* argument = (rsArgument*)rsMalloc(sizeof(rsArgument));
+    argument->key = scope->copyString(key);
+    argument->value = scope->copyString(value);
+    job->addArgument(argument);
+
+    argumentsChanged();
+    return (int)job->getArguments().size() - 1;
+}
+
+void RSJobDocument::setJobArgumentKey(int index, const char *key)
+{
+    rsArgument* argument = job->getArguments().at(index);
+
+    // the replaced string is no longer referenced by anything
+    char *old = argument->key;
+    argument->key = scope->copyString(key);
+    scope->releaseString(old);
+
+    argumentsChanged();
+}
+
+void RSJobDocument::setJobArgumentValue(int index, const char *value)
+{
+    rsArgument* argument = job->getArguments().at(index);
+
+    char *old = argument->value;
+    argument->value = scope->copyString(value);
+    scope->releaseString(old);
+
+    argumentsChanged();
+}
+
+void RSJobDocument::taskChanged(RSTask *task, const char *key)
+{
+    const int index = indexOf(task);
+    if ( index >= 0 ) {
+        tasks[index].clear();
+    }
+    revision++;
+
+    emit taskArgumentChanged(index, QString::fromUtf8(key));
+    emit changed(revision);
+}
+
+void RSJobDocument::argumentsChanged()
+{
+    // every task may refer to the job arguments, but the tasks themselves
+    // did not change and their copies stay shared
+    arguments.clear();
+    revision++;
+
+    emit jobArgumentsChanged();
+    emit changed(revision);
+}
+
+/*
+ * Copies what changed since the last snapshot and shares everything else
+ * with it. Has to be called from the GUI thread like every other method.
+ */
+RSJobSnapshot RSJobDocument::snapshot()
+{
+    if ( arguments.isNull() ) {
+        QList<rsArgumentSnapshot> *copy = new QList<rsArgumentSnapshot>();
+        vector<rsArgument*> jobArguments = job->getArguments();
+        for (vector<rsArgument*>::iterator it = jobArguments.begin(); it != jobArguments.end(); ++it) {
+            *copy << copyArgument(*it);
+        }
+        arguments = rsArgumentsSnapshotPointer(copy);
+    }
+
+    vector<RSTask*> jobTasks = job->getTasks();
+    for ( int i=0; i<tasks.size() && i<(int)jobTasks.size(); i++ ) {
+        if ( tasks[i].isNull() ) {
+            tasks[i] = copyTask(jobTasks[i]);
+        }
+    }
+
+    RSJobSnapshot result;
+    result.revision  = revision;
+    result.path      = path;
+    result.arguments = arguments;
+    result.tasks     = tasks;
+    return result;
+}
+
+// Reads a job only to look at it, e.g. to compare it with another one
+RSJobSnapshot RSJobDocument::read(const QString &path)
+{
+    // the plugins have to be loaded before a job can be parsed
+    RSToolIndex::getInstance().build();
+
+    // jobs that are only read, e.g. to be compared or merged, are not
+    // worth a cache file of their own
+    QByteArray p = path.toUtf8();
+    RSJobDocument document(p.data(), 0, false);
+    return document.snapshot();
+}
+
+rsTaskSnapshotPointer RSJobDocument::copyTask(RSTask *task)
+{
+    rsTaskSnapshot *copy = new rsTaskSnapshot();
+    copy->code = QString::fromUtf8(task->getCode());
+    copy->description = QString::fromUtf8(task->getDescription());
+
+    vector<rsArgument*> taskArguments = task->getArguments();
+    for (vector<rsArgument*>::iterator it = taskArguments.begin(); it != taskArguments.end(); ++it) {
+        copy->arguments << copyArgument(*it);
+    }
+    copy->hash = RSJobDiff::hashTask(*copy);
+
+    return rsTaskSnapshotPointer(copy);
+}
+
+rsArgumentSnapshot RSJobDocument::copyArgument(rsArgument *argument)
+{
+    rsArgumentSnapshot copy;
+    copy.key      = QString::fromUtf8(argument->key);
+    copy.hasValue = argument->value != NULL;
+    copy.value    = QString::fromUtf8(argument->value);
+    return copy;
+}
+
+}}} // namespace rstools::batch::util
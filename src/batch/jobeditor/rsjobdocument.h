@@ -0,0 +1,81 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobdocument_h
+#define rstools_rsbatch_jobeditor_rsjobdocument_h
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "batch/util/rsjob.hpp"
+#include "batch/util/rstask.hpp"
+#include "batch/util/rsjobparser.hpp"
+#include "rsdocumentscope.h"
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * An open job together with its parser and the scope that holds its
+ * strings. All edits of the job go through the document, which counts
+ * them in a revision and tells which task or argument they touched.
+ * The job itself belongs to the GUI thread; background workers are given
+ * a snapshot instead and never see it change underneath them.
+ */
+class RSJobDocument : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RSJobDocument(const char *path, QObject *parent = 0, bool updateCache = true);
+    ~RSJobDocument();
+
+    RSJob* getJob();
+    RSDocumentScope* getScope();
+    QString getPath();
+    qint64 getRevision();
+    bool isModified();
+    void markSaved();
+    RSJobSnapshot getSavedSnapshot();
+    int indexOf(RSTask *task);
+
+    void setTaskArgument(RSTask *task, const char *key, const char *value, bool draft = false);
+    void commitTaskArgument(RSTask *task, const char *key);
+    void setTaskFlag(RSTask *task, const char *key, bool enabled);
+    void appendTask(RSTask *task);
+
+    int appendJobArgument(const char *key, const char *value);
+    void setJobArgumentKey(int index, const char *key);
+    void setJobArgumentValue(int index, const char *value);
+
+    RSJobSnapshot snapshot();
+    static RSJobSnapshot read(const QString &path);
+
+    static rsTaskSnapshotPointer copyTask(RSTask *task);
+    static rsArgumentSnapshot copyArgument(rsArgument *argument);
+
+signals:
+    void taskArgumentChanged(int taskIndex, const QString &key);
+    void taskAppended(int taskIndex);
+    void jobArgumentsChanged();
+    void changed(qint64 revision);
+
+protected:
+    void taskChanged(RSTask *task, const char *key);
+    void argumentsChanged();
+
+    RSJobParser *parser;
+    RSJob *job;
+    RSDocumentScope *scope;
+    QString path;
+    qint64 revision;
+    qint64 savedRevision;
+    RSJobSnapshot saved;                    // as the job was read or last saved
+
+    QHash<RSTask*, int> taskIndices;
+    QList<rsTaskSnapshotPointer> tasks;     // null where changed since the last snapshot
+    rsArgumentsSnapshotPointer arguments;   // null if changed since the last snapshot
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -1,12 +1,38 @@
 #include "rsjobeditorapplication.h"
 #include "ui/ArgumentsModel.h"
+#include "ui/RunQueueWindow.h"
+#include "ui/CachePreviewDialog.h"
+#include "ui/FootprintDialog.h"
+#include "ui/JobGraphDialog.h"
+#include "ui/GenerateJobsDialog.h"
+#include "ui/SweepDialog.h"
+#include "ui/JobDiffDialog.h"
+#include "ui/StudyIndexDialog.h"
+#include "rsjobbinarycache.h"
+#include "rsjobmerge.h"
+#include "rsjobutils.h"
+#include "rsmakefileexport.h"
+#include "rstaskcache.h"
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMessageBox>
 #include <QErrorMessage>
+#include <QStatusBar>
+#include <QTemporaryFile>
+#include <QVector>
+#include <QDir>
 #include <tr1/unordered_map>
+#include <string.h>
 
 using namespace std;
 using namespace rstools::batch::util;
 
+static bool isEmptyJobTemplate(const QString &path)
+{
+    return QFileInfo(path) == QFileInfo(QString(RSTOOLS_DATA_DIR"/rstools/jobs/empty.job"));
+}
+
 void JobEditorWindow::createActions()
 {
     newAct = new QAction(tr("&New"), this);
@@ -20,7 +46,7 @@ void JobEditorWindow::createActions()
     openAct = new QAction(tr("&Open..."), this);
     openAct->setShortcuts(QKeySequence::Open);
     openAct->setStatusTip(tr("Open"));
-    openAct->setShortcutContext(Qt::ApplicationShortcut);
+    openAct->setShortcutContext(Qt::WindowShortcut);
     openAct->setEnabled(true);
     openAct->setAutoRepeat(false);
     addAction(openAct);
@@ -29,20 +55,151 @@ void JobEditorWindow::createActions()
     saveAct = new QAction(tr("&Save"), this);
     saveAct->setShortcuts(QKeySequence::Save);
     saveAct->setStatusTip(tr("Save"));
-    saveAct->setShortcutContext(Qt::ApplicationShortcut);
+    saveAct->setShortcutContext(Qt::WindowShortcut);
     saveAct->setEnabled(true);
     saveAct->setAutoRepeat(false);
     addAction(saveAct);
     connect(saveAct, SIGNAL(triggered()), this, SLOT(save()));
 
+    exportMakefileAct = new QAction(tr("Export as &Makefile..."), this);
+    exportMakefileAct->setStatusTip(tr("Write the job as a Makefile that runs independent tasks in parallel with make -j"));
+    exportMakefileAct->setEnabled(true);
+    exportMakefileAct->setAutoRepeat(false);
+    addAction(exportMakefileAct);
+    connect(exportMakefileAct, SIGNAL(triggered()), this, SLOT(exportMakefile()));
+
+    exportJobFilesMakefileAct = new QAction(tr("Export Job Files as Ma&kefile..."), this);
+    exportJobFilesMakefileAct->setStatusTip(tr("Write several saved jobs, e.g. one per subject, into a single Makefile"));
+    exportJobFilesMakefileAct->setEnabled(true);
+    exportJobFilesMakefileAct->setAutoRepeat(false);
+    addAction(exportJobFilesMakefileAct);
+    connect(exportJobFilesMakefileAct, SIGNAL(triggered()), this, SLOT(exportJobFilesMakefile()));
+
+    generateJobsAct = new QAction(tr("&Generate Jobs from Table..."), this);
+    generateJobsAct->setStatusTip(tr("Write one job per subject from a template job and a CSV or TSV table"));
+    generateJobsAct->setEnabled(true);
+    generateJobsAct->setAutoRepeat(false);
+    addAction(generateJobsAct);
+    connect(generateJobsAct, SIGNAL(triggered()), this, SLOT(generateJobs()));
+
+    sweepAct = new QAction(tr("Parameter S&weep..."), this);
+    sweepAct->setStatusTip(tr("Write and run a variant of this job for every combination of a few argument values"));
+    sweepAct->setEnabled(true);
+    sweepAct->setAutoRepeat(false);
+    addAction(sweepAct);
+    connect(sweepAct, SIGNAL(triggered()), this, SLOT(sweepParameters()));
+
+    compareAct = new QAction(tr("Co&mpare With..."), this);
+    compareAct->setStatusTip(tr("Show side by side which tasks and arguments differ between this job and another one"));
+    compareAct->setEnabled(true);
+    compareAct->setAutoRepeat(false);
+    addAction(compareAct);
+    connect(compareAct, SIGNAL(triggered()), this, SLOT(compareWithFile()));
+
+    mergeAct = new QAction(tr("Merge &Changes..."), this);
+    mergeAct->setStatusTip(tr("Merge what was changed in another job since a common base, e.g. a new version of a template, into a copy of this job"));
+    mergeAct->setEnabled(true);
+    mergeAct->setAutoRepeat(false);
+    addAction(mergeAct);
+    connect(mergeAct, SIGNAL(triggered()), this, SLOT(mergeChanges()));
+
+    searchStudyAct = new QAction(tr("Search &Study..."), this);
+    searchStudyAct->setShortcut(QKeySequence(tr("Ctrl+Shift+F")));
+    searchStudyAct->setStatusTip(tr("Find the jobs below a directory that use a tool or an argument value"));
+    searchStudyAct->setShortcutContext(Qt::WindowShortcut);
+    searchStudyAct->setEnabled(true);
+    searchStudyAct->setAutoRepeat(false);
+    addAction(searchStudyAct);
+    connect(searchStudyAct, SIGNAL(triggered()), this, SLOT(searchStudy()));
+
+    newWindowAct = new QAction(tr("New &Window"), this);
+    newWindowAct->setShortcut(QKeySequence(tr("Ctrl+Shift+N")));
+    newWindowAct->setStatusTip(tr("Open an empty job in a new window"));
+    newWindowAct->setShortcutContext(Qt::WindowShortcut);
+    newWindowAct->setEnabled(true);
+    newWindowAct->setAutoRepeat(false);
+    addAction(newWindowAct);
+    connect(newWindowAct, SIGNAL(triggered()), this, SLOT(newWindow()));
+
+    openInNewWindowAct = new QAction(tr("Open in New W&indow..."), this);
+    openInNewWindowAct->setShortcut(QKeySequence(tr("Ctrl+Shift+O")));
+    openInNewWindowAct->setStatusTip(tr("Open a job in a new window"));
+    openInNewWindowAct->setShortcutContext(Qt::WindowShortcut);
+    openInNewWindowAct->setEnabled(true);
+    openInNewWindowAct->setAutoRepeat(false);
+    addAction(openInNewWindowAct);
+    connect(openInNewWindowAct, SIGNAL(triggered()), this, SLOT(openInNewWindow()));
+
+    closeWindowAct = new QAction(tr("&Close Window"), this);
+    closeWindowAct->setShortcuts(QKeySequence::Close);
+    closeWindowAct->setStatusTip(tr("Close Window"));
+    closeWindowAct->setShortcutContext(Qt::WindowShortcut);
+    closeWindowAct->setEnabled(true);
+    closeWindowAct->setAutoRepeat(false);
+    addAction(closeWindowAct);
+    connect(closeWindowAct, SIGNAL(triggered()), this, SLOT(close()));
+
     exitAct = new QAction(tr("E&xit"), this);
     exitAct->setShortcuts(QKeySequence::Quit);
     exitAct->setStatusTip(tr("Exit"));
-    exitAct->setShortcutContext(Qt::ApplicationShortcut);
+    exitAct->setShortcutContext(Qt::WindowShortcut);
     exitAct->setEnabled(true);
     exitAct->setAutoRepeat(false);
     addAction(exitAct);
-    connect(exitAct, SIGNAL(triggered()), this, SLOT(close()));
+    connect(exitAct, SIGNAL(triggered()), qApp, SLOT(closeAllWindows()));
+
+    quickInsertAct = new QAction(tr("&Quick Insert..."), this);
+    quickInsertAct->setShortcut(QKeySequence(tr("Ctrl+K")));
+    quickInsertAct->setStatusTip(tr("Search all tools and insert one as a new task"));
+    quickInsertAct->setShortcutContext(Qt::WindowShortcut);
+    quickInsertAct->setEnabled(true);
+    quickInsertAct->setAutoRepeat(false);
+    addAction(quickInsertAct);
+    connect(quickInsertAct, SIGNAL(triggered()), this, SLOT(quickInsert()));
+
+    queueJobAct = new QAction(tr("&Queue This Job"), this);
+    queueJobAct->setShortcut(QKeySequence(tr("Ctrl+R")));
+    queueJobAct->setStatusTip(tr("Run the job as it is shown in the editor on this machine"));
+    queueJobAct->setShortcutContext(Qt::WindowShortcut);
+    queueJobAct->setEnabled(true);
+    queueJobAct->setAutoRepeat(false);
+    addAction(queueJobAct);
+    connect(queueJobAct, SIGNAL(triggered()), this, SLOT(queueCurrentJob()));
+
+    queueJobFilesAct = new QAction(tr("Queue Job &Files..."), this);
+    queueJobFilesAct->setStatusTip(tr("Run saved jobs on this machine"));
+    queueJobFilesAct->setEnabled(true);
+    queueJobFilesAct->setAutoRepeat(false);
+    addAction(queueJobFilesAct);
+    connect(queueJobFilesAct, SIGNAL(triggered()), this, SLOT(queueJobFiles()));
+
+    showRunQueueAct = new QAction(tr("Show Run &Queue"), this);
+    showRunQueueAct->setStatusTip(tr("Show the jobs that are queued or running on this machine"));
+    showRunQueueAct->setEnabled(true);
+    showRunQueueAct->setAutoRepeat(false);
+    addAction(showRunQueueAct);
+    connect(showRunQueueAct, SIGNAL(triggered()), this, SLOT(showRunQueue()));
+
+    previewCacheAct = new QAction(tr("Show &Reusable Tasks..."), this);
+    previewCacheAct->setStatusTip(tr("Show which tasks would be skipped because their results are still up to date"));
+    previewCacheAct->setEnabled(true);
+    previewCacheAct->setAutoRepeat(false);
+    addAction(previewCacheAct);
+    connect(previewCacheAct, SIGNAL(triggered()), this, SLOT(previewCache()));
+
+    showGraphAct = new QAction(tr("Show Task &Dependencies..."), this);
+    showGraphAct->setStatusTip(tr("Show which tasks depend on each other and which can run in parallel"));
+    showGraphAct->setEnabled(true);
+    showGraphAct->setAutoRepeat(false);
+    addAction(showGraphAct);
+    connect(showGraphAct, SIGNAL(triggered()), this, SLOT(showTaskGraph()));
+
+    showFootprintAct = new QAction(tr("Estimate Data &Footprint..."), this);
+    showFootprintAct->setStatusTip(tr("Show how much data the tasks read and write and whether there is enough disk space"));
+    showFootprintAct->setEnabled(true);
+    showFootprintAct->setAutoRepeat(false);
+    addAction(showFootprintAct);
+    connect(showFootprintAct, SIGNAL(triggered()), this, SLOT(showFootprint()));
 }
 
 void JobEditorWindow::createMenus()
@@ -67,30 +224,53 @@ void JobEditorWindow::createMenus()
     fileMenu = _menuBar->addMenu(tr("&File"));
     fileMenu->addAction(newAct);
     fileMenu->addAction(openAct);
+    recentFilesMenu = fileMenu->addMenu(tr("Open &Recent"));
+    updateRecentFilesMenu();
     fileMenu->addAction(saveAct);
+    fileMenu->addAction(exportMakefileAct);
+    fileMenu->addAction(exportJobFilesMakefileAct);
+    fileMenu->addAction(generateJobsAct);
+    fileMenu->addAction(sweepAct);
+    fileMenu->addSeparator();
+    fileMenu->addAction(compareAct);
+    fileMenu->addAction(mergeAct);
+    fileMenu->addAction(searchStudyAct);
+    fileMenu->addSeparator();
+    fileMenu->addAction(newWindowAct);
+    fileMenu->addAction(openInNewWindowAct);
+    fileMenu->addAction(closeWindowAct);
+    fileMenu->addSeparator();
     fileMenu->addAction(exitAct);
     
     insertMenu = _menuBar->addMenu(tr("&Insert"));
+    insertMenu->addAction(quickInsertAct);
+    insertMenu->addSeparator();
     
     createInsertTaskMenuItems();
+    
+    runMenu = _menuBar->addMenu(tr("&Run"));
+    runMenu->addAction(queueJobAct);
+    runMenu->addAction(queueJobFilesAct);
+    runMenu->addAction(previewCacheAct);
+    runMenu->addAction(showGraphAct);
+    runMenu->addAction(showFootprintAct);
+    runMenu->addSeparator();
+    runMenu->addAction(showRunQueueAct);
 }
 
 void JobEditorWindow::createInsertTaskMenuItems()
 {
-    // ensure that plugins are loaded
-    PluginManager::getInstance().loadPlugins();
+    // the tool index is shared by all windows and ensures that plugins are loaded
+    RSToolIndex& index = RSToolIndex::getInstance();
+    index.build();
     
     QSignalMapper* signalMapper = new QSignalMapper(this);
     
-    vector<const char*> tools = RSTool::getTools();
-    
     // acquire list of tool categories
     vector<string> categories;
-    for (vector<const char*>::iterator it = tools.begin(); it != tools.end(); ++it) {
+    for ( size_t i=0; i<index.size(); i++ ) {
 
-        char* code   = (char*)*it;
-        rsToolRegistration* reg = RSTool::findRegistration(code);
-        string category = reg->category;
+        string category = index.getEntry(i)->category;
         
         if ( std::find(categories.begin(), categories.end(), category) == categories.end() ) {
             categories.push_back(category);
@@ -114,25 +294,15 @@ void JobEditorWindow::createInsertTaskMenuItems()
     }
     
     // create insert actions
-    size_t i=0;
-    //std::sort(tools.begin(), tools.end());
-    for (vector<const char*>::iterator it = tools.begin(); it != tools.end(); ++it) {
-
-        const char* code   = (char*)*it;
+    for ( size_t i=0; i<index.size(); i++ ) {
 
-        RSTask* task = RSTask::taskFactory(code);
-        const char* name   = task->getName();
+        rsToolIndexEntry* entry = index.getEntry(i);
 
-        QAction *action = new QAction(tr(name), this);
+        QAction *action = new QAction(tr(entry->name.c_str()), this);
         connect(action, SIGNAL(triggered()), signalMapper, SLOT(map()));
-        signalMapper->setMapping(action, i);
+        signalMapper->setMapping(action, entry->toolIndex);
         
-        rsToolRegistration* reg = RSTool::findRegistration(code);
-        string category = reg->category;
-        
-        submenus[category]->addAction(action);
-        
-        i++;
+        submenus[entry->category]->addAction(action);
     }
     
     connect(signalMapper, SIGNAL(mapped(int)), this, SLOT(insertNewTask(int))) ;
@@ -161,39 +331,547 @@ void JobEditorWindow::open()
     }
 }
 
+void JobEditorWindow::openRecentFile(const QString &fileName)
+{
+    try {
+        openJob(rsString(fileName.toUtf8().data()));
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage;
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();        
+    } catch (...) {
+    	QErrorMessage errorMessage;
+    	errorMessage.showMessage("Unknown error while opening the job file");
+    	errorMessage.exec();
+    }
+}
+
+void JobEditorWindow::updateRecentFilesMenu()
+{
+    recentFilesMenu->clear();
+    
+    QStringList files = RSJobPrefetcher::getInstance().getRecentFiles();
+    for ( int i=0; i<files.size(); i++ ) {
+        QAction *action = recentFilesMenu->addAction(QString("&%1 %2").arg(i + 1).arg(QFileInfo(files[i]).fileName()));
+        action->setStatusTip(files[i]);
+        connect(action, SIGNAL(triggered()), recentFilesMapper, SLOT(map()));
+        recentFilesMapper->setMapping(action, files[i]);
+    }
+    
+    recentFilesMenu->setEnabled(! files.isEmpty());
+}
+
+void JobEditorWindow::newWindow()
+{
+    JobEditorWindowManager::getInstance().openJobInNewWindow(QString(RSTOOLS_DATA_DIR"/rstools/jobs/empty.job"));
+}
+
+void JobEditorWindow::openInNewWindow()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Job"), "", tr("Job (*.job)"));
+    if ( fileName != NULL ) {
+        JobEditorWindowManager::getInstance().openJobInNewWindow(fileName);
+    }
+}
+
+/*
+ * The job is queued as it is shown in the editor, so it is written to a
+ * temporary file first instead of running whatever was saved last.
+ */
+void JobEditorWindow::queueCurrentJob()
+{
+    if ( currentJob == NULL ) {
+        return;
+    }
+    
+    try {
+        QTemporaryFile file(QDir::tempPath() + QString("/rsjobeditor-XXXXXX.job"));
+        file.setAutoRemove(false);
+        if ( ! file.open() ) {
+            throw runtime_error("Could not create a temporary file for the job");
+        }
+        QString fileName = file.fileName();
+        file.close();
+        
+        QByteArray f = fileName.toLocal8Bit();
+        rsJobWriteFile(currentJob, f.data());
+        
+        // the queue removes the copy once it is done with it
+        RSJobRunQueue::getInstance().enqueue(fileName, QString::fromUtf8(currentJobPath), true);
+        showRunQueue();
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();
+    }
+}
+
+void JobEditorWindow::queueJobFiles()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, tr("Queue Jobs"), "", tr("Job (*.job)"));
+    foreach( const QString &fileName, fileNames ) {
+        RSJobRunQueue::getInstance().enqueue(fileName);
+    }
+    
+    if ( ! fileNames.isEmpty() ) {
+        showRunQueue();
+    }
+}
+
+void JobEditorWindow::showRunQueue()
+{
+    RunQueueWindow::getInstance()->popup();
+}
+
+void JobEditorWindow::previewCache()
+{
+    if ( currentJob == NULL ) {
+        return;
+    }
+
+    CachePreviewDialog *dialog = new CachePreviewDialog(currentJob, this);
+    dialog->show();
+}
+
+void JobEditorWindow::showFootprint()
+{
+    if ( currentJob == NULL ) {
+        return;
+    }
+
+    FootprintDialog *dialog = new FootprintDialog(document->snapshot(), this);
+    dialog->show();
+}
+
+void JobEditorWindow::showTaskGraph()
+{
+    if ( graphDialog == NULL ) {
+        graphDialog = new JobGraphDialog(graph, this);
+        connect(graphDialog, SIGNAL(taskActivated(int)), this, SLOT(graphTaskActivated(int)));
+    }
+
+    graphDialog->setJob(currentJob);
+    graphDialog->popup();
+}
+
+void JobEditorWindow::graphTaskActivated(int taskIndex)
+{
+    ui.tabWidget->setCurrentWidget(ui.pipeline);
+    ui.pipelineWidget->setCurrentIndex(taskIndex);
+}
+
+/*
+ * Only the settings that refer to one of the changed job arguments are
+ * resolved again, and only their tasks are updated in the graph.
+ */
+void JobEditorWindow::jobArgumentsChanged()
+{
+    if ( currentJob == NULL ) {
+        return;
+    }
+    
+    QSet<QString> changed = resolver.update(currentJob);
+    QSet<RSTask*> tasks;
+    
+    foreach( const QString &key, changed ) {
+        foreach( SettingWidget *setting, settingsByArgument.value(key) ) {
+            setting->setResolvedValue(resolver.resolve(setting->getValue()));
+            tasks.insert(setting->getTask());
+        }
+    }
+    
+    if ( tasks.isEmpty() ) {
+        return;
+    }
+    
+    for ( int i=0; i<ui.pipelineWidget->count(); i++ ) {
+        RSTask *task = ((TaskWidget*)ui.pipelineWidget->widget(i))->getTask();
+        if ( tasks.contains(task) ) {
+            graph->updateTask(i, RSTaskCache::describe(currentJob, task));
+        }
+    }
+}
+
+// Keeps the index of which setting refers to which job arguments current
+void JobEditorWindow::trackSetting(SettingWidget *setting)
+{
+    QString value = setting->getValue();
+    QStringList references = RSArgumentResolver::references(value);
+    QStringList previous = argumentsBySetting.value(setting);
+    
+    if ( references != previous ) {
+        foreach( const QString &key, previous ) {
+            settingsByArgument[key].remove(setting);
+        }
+        foreach( const QString &key, references ) {
+            settingsByArgument[key].insert(setting);
+        }
+        if ( references.isEmpty() ) {
+            argumentsBySetting.remove(setting);
+        } else {
+            argumentsBySetting.insert(setting, references);
+        }
+    }
+    
+    setting->setResolvedValue(resolver.resolve(value));
+}
+
 void JobEditorWindow::openJob(char* jobFile)
 {
     closeCurrentJob();
     currentJobPath = jobFile;
     
-    RSJobParser *parser = new RSJobParser(jobFile);
-    parser->parse();
-    currentJob = parser->getJob();
+    // jobs that were used recently may already have been read in the background
+    RSJobPrefetcher &prefetcher = RSJobPrefetcher::getInstance();
+    const QString path = QString::fromUtf8(jobFile);
+    QList<TaskWidget*> pages;
+    
+    document = prefetcher.take(path, pages);
+    if ( document != NULL ) {
+        document->setParent(this);
+    } else {
+        document = new RSJobDocument(jobFile, this);
+    }
+    connect(document, SIGNAL(jobArgumentsChanged()), this, SLOT(jobArgumentsChanged()));
+    currentJob = document->getJob();
+    
+    prefetcher.documentOpened(path);
+    if ( ! isEmptyJobTemplate(path) ) {
+        prefetcher.addRecentFile(path);
+    }
+    
+    setWindowTitle(QFileInfo(QString::fromUtf8(jobFile)).fileName() + QString(" - ") + tr("RSTools Job Editor"));
+    
+    setupArgumentsTable();
+    resolver.update(currentJob);
+    
+    vector<RSTask*> tasks = currentJob->getTasks();
     
-    ui.argumentsTable->setModel(new ArgumentsModel(currentJob));
+    int inserted = 0;
+    try {
+        for(vector<RSTask*>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+            RSTask* task = (RSTask*)*it;
+            insertTask(task, inserted < pages.size() ? pages[inserted] : NULL);
+            inserted++;
+        }
+    } catch (...) {
+        qDeleteAll(pages.mid(inserted));
+        throw;
+    }
+    
+    updateJobViews();
+    watchJobFile();
+}
+
+void JobEditorWindow::setupArgumentsTable()
+{
+    ArgumentsModel *argumentsModel = new ArgumentsModel(document, this);
+    ui.argumentsTable->setModel(argumentsModel);
     ui.argumentsTable->setSortingEnabled(true);
 #if QT_VERSION >= 0x050000
     ui.argumentsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
 #else
     ui.argumentsTable->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
 #endif
+}
+
+// Brings everything that is derived from the job as a whole up to date
+void JobEditorWindow::updateJobViews()
+{
+    validator->validateJob(document->snapshot());
+    updateProblemsList();
+    updateRunAnnotations();
+    
+    graph->build(currentJob);
+    if ( graphDialog != NULL ) {
+        graphDialog->setJob(currentJob);
+    }
+    
+    updateMemoryReadout();
+}
+
+/*
+ * Watches the file of the open job and remembers its state, so that the
+ * editor's own saves can be told apart from changes by other programs.
+ */
+void JobEditorWindow::watchJobFile()
+{
+    if ( ! jobWatcher->files().isEmpty() ) {
+        jobWatcher->removePaths(jobWatcher->files());
+    }
+    jobFileMtime = -1;
+    jobFileSize = -1;
+    
+    if ( currentJobPath == NULL ) {
+        return;
+    }
+    
+    QString path = QString::fromUtf8(currentJobPath);
+    QFileInfo info(path);
+    if ( ! info.isFile() || isEmptyJobTemplate(path) ) {
+        return;
+    }
+    
+    jobFileMtime = info.lastModified().toMSecsSinceEpoch();
+    jobFileSize = info.size();
+    jobWatcher->addPath(path);
+}
+
+// Scripts tend to write a file in several steps, so it is read once they are done
+void JobEditorWindow::jobFileChanged(const QString & /*path*/)
+{
+    reloadTimer.start(500);
+}
+
+void JobEditorWindow::reloadJobFile()
+{
+    if ( document == NULL || currentJobPath == NULL ) {
+        return;
+    }
+    
+    QString path = QString::fromUtf8(currentJobPath);
+    QFileInfo info(path);
+    if ( ! info.isFile() ) {
+        // replaced by renaming another file, which may not have happened yet
+        reloadTimer.start(2000);
+        return;
+    }
+    
+    // the watch is lost when the file is replaced instead of rewritten
+    if ( ! jobWatcher->files().contains(path) ) {
+        jobWatcher->addPath(path);
+    }
+    
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+    if ( mtime == jobFileMtime && size == jobFileSize ) {
+        return;
+    }
+    jobFileMtime = mtime;
+    jobFileSize = size;
+    
+    try {
+        QByteArray p = path.toUtf8();
+        RSJobDocument *incoming = new RSJobDocument(p.data());
+        RSJobSnapshot changed = incoming->snapshot();
+        RSJobDiff diff(document->snapshot(), changed);
+        
+        if ( diff.isEmpty() ) {
+            // the file holds just what the editor shows
+            document->markSaved();
+            delete incoming;
+            return;
+        }
+        
+        if ( document->isModified() && ! confirmReload(changed) ) {
+            delete incoming;
+            return;
+        }
+        
+        const int rebuilt = diff.getAddedTasks().size();
+        replaceDocument(incoming, diff);
+        statusBar()->showMessage(tr("The job file was changed, %1 of %2 tasks were reloaded").arg(rebuilt).arg(currentJob->getTasks().size()), 5000);
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(tr("The changed job file could not be read: %1").arg(QString::fromUtf8(e.what())));
+    	errorMessage.exec();
+    } catch (...) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage("Unknown error while reading the changed job file");
+    	errorMessage.exec();
+    }
+}
+
+/*
+ * Asks before a changed job file replaces unsaved edits, naming the parts
+ * of the job that were changed both in the file and in the editor since
+ * it was last saved.
+ */
+bool JobEditorWindow::confirmReload(const RSJobSnapshot &changed)
+{
+    RSJobSnapshot base = document->getSavedSnapshot();
+    RSJobDiff local(base, document->snapshot());
+    RSJobDiff remote(base, changed);
+    
+    QStringList conflicts;
+    if ( local.argumentsChanged() && remote.argumentsChanged() ) {
+        conflicts << tr("Job arguments");
+    }
+    QList<int> changedRemotely = remote.getRemovedTasks();
+    foreach( int i, local.getRemovedTasks() ) {
+        if ( changedRemotely.contains(i) ) {
+            conflicts << QString("%1. %2").arg(i + 1).arg(base.getTask(i).description);
+        }
+    }
+    
+    QString text = tr("The job file was changed by another program while there are unsaved changes in the editor.");
+    if ( ! conflicts.isEmpty() ) {
+        text += QString("\n\n") + tr("Changed in both:") + QString("\n") + conflicts.join("\n");
+    }
+    text += QString("\n\n") + tr("Reload the job file and discard the unsaved changes?");
+    
+    return QMessageBox::question(this, tr("Job File Changed"), text, QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::Yes;
+}
+
+/*
+ * Switches over to another version of the open job. The pages of tasks
+ * that are the same in both versions are handed over to their tasks in
+ * the new one and stay as they are, including where they are scrolled to.
+ * Only the pages of changed, added or removed tasks are rebuilt.
+ */
+void JobEditorWindow::replaceDocument(RSJobDocument *incoming, const RSJobDiff &diff)
+{
+    const QList<int> matches = diff.getMatches();
+    const QList<int> removed = diff.getRemovedTasks();
+    
+    QList<TaskWidget*> pages;
+    for ( int i=0; i<ui.pipelineWidget->count(); i++ ) {
+        pages << (TaskWidget*)ui.pipelineWidget->widget(i);
+    }
+    int shownIndex = ui.pipelineWidget->currentIndex();
+    TaskWidget *shown = removed.contains(shownIndex) ? NULL : pages.value(shownIndex, NULL);
+    
+    settingsByArgument.clear();
+    argumentsBySetting.clear();
+    
+    foreach( int i, removed ) {
+        if ( i < pages.size() ) {
+            ui.pipelineWidget->removePage(ui.pipelineWidget->indexOf(pages[i]));
+            delete pages[i];
+        }
+    }
+    
+    QAbstractItemModel *argumentsModel = ui.argumentsTable->model();
+    ui.argumentsTable->setModel(NULL);
+    delete argumentsModel;
+    
+    RSJobPrefetcher &prefetcher = RSJobPrefetcher::getInstance();
+    RSJobDocument *previous = document;
+    prefetcher.documentClosed(previous->getPath());
+    
+    document = incoming;
+    document->setParent(this);
+    connect(document, SIGNAL(jobArgumentsChanged()), this, SLOT(jobArgumentsChanged()));
+    currentJob = document->getJob();
+    prefetcher.documentOpened(document->getPath());
+    
+    setupArgumentsTable();
+    resolver.clear();
+    resolver.update(currentJob);
     
     vector<RSTask*> tasks = currentJob->getTasks();
+    for ( int j=0; j<(int)tasks.size(); j++ ) {
+        if ( matches[j] < 0 || matches[j] >= pages.size() ) {
+            insertTask(tasks[j], NULL, j);
+            continue;
+        }
+        
+        TaskWidget *page = pages[matches[j]];
+        page->rebind(tasks[j], document);
+        
+        int index = ui.pipelineWidget->indexOf(page);
+        if ( index != j ) {
+            ui.pipelineWidget->removePage(index);
+            ui.pipelineWidget->insertPage(j, page, QIcon(), QString(tasks[j]->getDescription()));
+        }
+        for ( size_t i=0; i<page->getSettingWidgetCount(); i++ ) {
+            if ( page->getSettingWidget(i) != NULL ) {
+                trackSetting(page->getSettingWidget(i));
+            }
+        }
+    }
+    
+    // nothing refers to the previous version any more
+    delete previous;
     
-    for(vector<RSTask*>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
-        RSTask* task = (RSTask*)*it;
-        insertTask(task);
+    if ( shown != NULL ) {
+        ui.pipelineWidget->setCurrentIndex(ui.pipelineWidget->indexOf(shown));
     }
+    
+    updateJobViews();
 }
 
+/*
+ * Releases everything that belongs to the open job: the task widgets, the
+ * arguments model and finally the document with the job, its parser and
+ * the arena holding the strings the editor put into the job.
+ */
 void JobEditorWindow::closeCurrentJob()
 {
+    // removing a page does not delete it
+    QList<QWidget*> pages;
+    for ( int i=0; i<ui.pipelineWidget->count(); i++ ) {
+        pages << ui.pipelineWidget->widget(i);
+    }
     ui.pipelineWidget->removeAllPages();
+    qDeleteAll(pages);
+    
+    validator->clear();
+    graph->clear();
+    resolver.clear();
+    settingsByArgument.clear();
+    argumentsBySetting.clear();
+    updateProblemsList();
+    
+    if ( graphDialog != NULL ) {
+        graphDialog->setJob(NULL);
+    }
+    emit jobClosed();
+    
+    QAbstractItemModel *argumentsModel = ui.argumentsTable->model();
+    ui.argumentsTable->setModel(NULL);
+    delete argumentsModel;
+    
+    reloadTimer.stop();
+    if ( ! jobWatcher->files().isEmpty() ) {
+        jobWatcher->removePaths(jobWatcher->files());
+    }
+    
+    if ( document != NULL ) {
+        RSJobPrefetcher::getInstance().documentClosed(document->getPath());
+    }
+    delete document;
+    document = NULL;
+    currentJob = NULL;
     
     if (currentJobPath != NULL)
         rsFree(currentJobPath);
     
     currentJobPath = NULL;
+    
+    updateMemoryReadout();
+}
+
+/*
+ * Shows how much the open jobs hold in their arenas and in the shared string
+ * pool, each next to what one copy per argument would have taken, as well as
+ * the resident memory of the whole process, which should stay flat no
+ * matter how many jobs have been opened and closed before.
+ */
+void JobEditorWindow::updateMemoryReadout()
+{
+    QString text;
+    
+    if ( document != NULL ) {
+        RSDocumentScope *scope = document->getScope();
+        text = tr("Job: %1 values in %2 kB of %3 kB").arg(scope->getStringCount())
+            .arg((scope->getArenaSize() + 1023) / 1024)
+            .arg((scope->getRequestedSize() + 1023) / 1024);
+        text += QString("  ");
+    }
+    
+    RSStringPool &pool = RSStringPool::getInstance();
+    text += tr("All jobs: %1 open, %2 kB").arg(RSDocumentScope::getOpenScopes()).arg((RSDocumentScope::getTotalArenaSize() + 1023) / 1024);
+    text += tr("  Shared: %1 strings in %2 kB of %3 kB").arg(pool.getStringCount())
+        .arg((pool.getSize() + 1023) / 1024)
+        .arg((pool.getRequestedSize() + 1023) / 1024);
+    
+    qint64 resident = RSDocumentScope::getResidentMemory();
+    if ( resident >= 0 ) {
+        text += tr("  Process: %1").arg(RSRunHistory::formatMemory(resident));
+    }
+    
+    memoryLabel->setText(text);
 }
 
 void JobEditorWindow::save()
@@ -223,6 +901,14 @@ void JobEditorWindow::save()
             
             fprintf(f, "%s", jobXml);
             fclose(f);
+            
+            // the hash of what was just written, without reading it back
+            QString hash = RSTaskCache::hashData((const guchar*)jobXml, strlen(jobXml));
+            rsFree(jobXml);
+            
+            RSJobBinaryCache::getInstance().store(fileName, currentJob, hash);
+            document->markSaved();
+            watchJobFile();
         }
     } catch (const exception& e) {
     	QErrorMessage errorMessage(this);
@@ -235,9 +921,150 @@ void JobEditorWindow::save()
     }
 }
 
-void JobEditorWindow::insertNewTask(int taskIndex)
+void JobEditorWindow::exportMakefile()
+{
+    if ( currentJob == NULL ) {
+        return;
+    }
+    
+    try {
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Export Makefile"), "Makefile", tr("Makefile (Makefile *.mk)"));
+        if ( fileName.isEmpty() ) {
+            return;
+        }
+        
+        QString name = currentJobPath == NULL ? QString("job") : QFileInfo(QString::fromUtf8(currentJobPath)).completeBaseName();
+        
+        RSMakefileExport exporter(fileName);
+        exporter.addJob(currentJob, name);
+        exporter.write();
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();
+    }
+}
+
+void JobEditorWindow::exportJobFilesMakefile()
+{
+    try {
+        QStringList jobFiles = QFileDialog::getOpenFileNames(this, tr("Jobs to Export"), "", tr("Job (*.job)"));
+        if ( jobFiles.isEmpty() ) {
+            return;
+        }
+        
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Export Makefile"), "Makefile", tr("Makefile (Makefile *.mk)"));
+        if ( fileName.isEmpty() ) {
+            return;
+        }
+        
+        RSMakefileExport exporter(fileName);
+        foreach( const QString &jobFile, jobFiles ) {
+            exporter.addJobFile(jobFile);
+        }
+        exporter.write();
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();
+    }
+}
+
+void JobEditorWindow::generateJobs()
+{
+    GenerateJobsDialog *dialog = new GenerateJobsDialog(currentJob, this);
+    connect(this, SIGNAL(jobClosed()), dialog, SLOT(jobClosed()));
+    dialog->show();
+}
+
+void JobEditorWindow::sweepParameters()
+{
+    if ( document == NULL ) {
+        return;
+    }
+    
+    SweepDialog *dialog = new SweepDialog(document->snapshot(), this);
+    dialog->show();
+}
+
+void JobEditorWindow::compareWithFile()
+{
+    if ( document == NULL ) {
+        return;
+    }
+    
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Compare With"), "", tr("Job (*.job)"));
+    if ( fileName.isEmpty() ) {
+        return;
+    }
+    
+    try {
+        RSJobSnapshot other = RSJobDocument::read(fileName);
+        JobDiffDialog *dialog = new JobDiffDialog(document->snapshot(), other, windowTitle(), QFileInfo(fileName).fileName(), this);
+        dialog->show();
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();
+    }
+}
+
+/*
+ * Three-way merge with the job as it is shown as "ours". The result is
+ * saved as a new job and opened in another window, next to a comparison
+ * with this job that lists the conflicts.
+ */
+void JobEditorWindow::mergeChanges()
 {
-    const char* code = RSTool::getTools().at(taskIndex);
+    if ( document == NULL ) {
+        return;
+    }
+    
+    QString basePath = QFileDialog::getOpenFileName(this, tr("Common Base of Both Jobs"), "", tr("Job (*.job)"));
+    if ( basePath.isEmpty() ) {
+        return;
+    }
+    QString otherPath = QFileDialog::getOpenFileName(this, tr("Job with the Changes to Merge"), "", tr("Job (*.job)"));
+    if ( otherPath.isEmpty() ) {
+        return;
+    }
+    
+    try {
+        RSJobSnapshot ours = document->snapshot();
+        RSJobMerge merge(RSJobDocument::read(basePath), ours, RSJobDocument::read(otherPath));
+        
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Save Merged Job"), "", tr("Job (*.job)"));
+        if ( fileName.isEmpty() ) {
+            return;
+        }
+        merge.write(fileName);
+        
+        JobDiffDialog *dialog = new JobDiffDialog(ours, merge.getResult(), windowTitle(), QFileInfo(fileName).fileName(), this);
+        dialog->setConflicts(merge.getConflicts());
+        dialog->show();
+        
+        JobEditorWindowManager::getInstance().openJobInNewWindow(fileName);
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();
+    }
+}
+
+void JobEditorWindow::searchStudy()
+{
+    StudyIndexDialog *dialog = new StudyIndexDialog(this);
+    connect(dialog, SIGNAL(jobActivated(const QString&)), &JobEditorWindowManager::getInstance(), SLOT(openJobInNewWindow(const QString&)));
+    dialog->show();
+}
+
+void JobEditorWindow::insertNewTask(int toolIndex)
+{
+    if ( document == NULL ) {
+        return;
+    }
+    
+    const char* code = RSTool::getTools().at(toolIndex);
     RSTask* task = RSTask::taskFactory(code);
     const char *name = task->getName();
     char *description = (char*)malloc(sizeof(char)*(strlen(name)+1));
@@ -245,26 +1072,231 @@ void JobEditorWindow::insertNewTask(int taskIndex)
     task->setDescription(description);
     insertTask(task);
     
-    currentJob->addTask(task);
+    document->appendTask(task);
+    
+    int taskIndex = ui.pipelineWidget->count() - 1;
+    validator->revalidateTask(taskIndex, task);
+    updateValidationMarkers(taskIndex);
+    updateProblemsList();
+    updateRunAnnotations();
+    graph->updateTask(taskIndex, RSTaskCache::describe(currentJob, task));
+}
+
+void JobEditorWindow::quickInsert()
+{
+    if ( quickInsertDialog == NULL ) {
+        quickInsertDialog = new QuickInsertDialog(this);
+        connect(quickInsertDialog, SIGNAL(toolSelected(int)), this, SLOT(insertNewTask(int)));
+    }
+
+    quickInsertDialog->popup();
 }
 
-void JobEditorWindow::insertTask(RSTask* task)
+/*
+ * Adds the page of a task, which may have been created beforehand for
+ * the same task.
+ */
+void JobEditorWindow::insertTask(RSTask* task, TaskWidget *widget, int index)
 {
     const char* code = task->getCode();
-    RSTool* tool = RSTool::toolFactory(code);
-    tool->setTask(task);
+    rsToolIndexEntry* entry = RSToolIndex::getInstance().findEntry(code);
+    if ( entry == NULL ) {
+        throw runtime_error(string("The job contains the unknown tool '") + code + string("'"));
+    }
     const char* name = task->getDescription();
 
-    TaskWidget *widget  = new TaskWidget(tool, ui.pipelineWidget);
+    if ( widget == NULL ) {
+        widget = new TaskWidget(task, entry->ui, document, ui.pipelineWidget);
+    }
     const QString title = QString(name);
+    connect(widget, SIGNAL(settingChanged(TaskWidget*, SettingWidget*)), this, SLOT(settingChanged(TaskWidget*, SettingWidget*)));
+    
+    for ( size_t i=0; i<widget->getSettingWidgetCount(); i++ ) {
+        if ( widget->getSettingWidget(i) != NULL ) {
+            trackSetting(widget->getSettingWidget(i));
+        }
+    }
+    
+    if ( index < 0 ) {
+        ui.pipelineWidget->addPage(widget, QIcon(), title);
+    } else {
+        ui.pipelineWidget->insertPage(index, widget, QIcon(), title);
+    }
+}
+
+void JobEditorWindow::settingChanged(TaskWidget *taskWidget, SettingWidget *setting)
+{
+    int taskIndex = ui.pipelineWidget->indexOf(taskWidget);
+    if ( taskIndex < 0 ) {
+        return;
+    }
+    
+    // only the edited option is checked again
+    validator->revalidate(taskIndex, setting->getTask(), setting->getSetting());
+    
+    string message = validator->getMessage(taskIndex, setting->getSetting()->name);
+    setting->setValidationMessage(QString::fromUtf8(message.c_str()));
+    updateProblemsList();
+    
+    trackSetting(setting);
+    graph->updateTask(taskIndex, RSTaskCache::describe(currentJob, setting->getTask()));
+}
+
+void JobEditorWindow::validationFinished()
+{
+    for ( int i=0; i<ui.pipelineWidget->count(); i++ ) {
+        updateValidationMarkers(i);
+    }
+    updateProblemsList();
+}
+
+void JobEditorWindow::updateValidationMarkers(int taskIndex)
+{
+    TaskWidget *taskWidget = (TaskWidget*)ui.pipelineWidget->widget(taskIndex);
+    
+    for ( size_t i=0; i<taskWidget->getSettingWidgetCount(); i++ ) {
+        SettingWidget *setting = taskWidget->getSettingWidget(i);
+        if ( setting == NULL ) {
+            continue;
+        }
+        string message = validator->getMessage(taskIndex, setting->getSetting()->name);
+        setting->setValidationMessage(QString::fromUtf8(message.c_str()));
+    }
+}
+
+void JobEditorWindow::updateProblemsList()
+{
+    vector<rsValidationIssue> issues = validator->getIssues();
+    
+    ui.problemsList->setUpdatesEnabled(false);
+    ui.problemsList->clear();
     
-    ui.pipelineWidget->addPage(widget, QIcon(), title);
+    for (vector<rsValidationIssue>::iterator it = issues.begin(); it != issues.end(); ++it) {
+        QString taskTitle;
+        TaskWidget *taskWidget = (TaskWidget*)ui.pipelineWidget->widget(it->taskIndex);
+        if ( taskWidget != NULL ) {
+            taskTitle = QString(taskWidget->getTask()->getDescription());
+        }
+        
+        QListWidgetItem *item = new QListWidgetItem(
+            QString("%1. %2 - %3: %4")
+                .arg(it->taskIndex + 1)
+                .arg(taskTitle)
+                .arg(QString::fromUtf8(it->option.c_str()))
+                .arg(QString::fromUtf8(it->message.c_str()))
+        );
+        item->setData(Qt::UserRole, (int)it->taskIndex);
+        item->setData(Qt::UserRole+1, QString::fromUtf8(it->option.c_str()));
+        ui.problemsList->addItem(item);
+    }
+    
+    ui.problemsList->setUpdatesEnabled(true);
+    
+    QString title = validator->isRunning()
+        ? tr("Problems (validating...)")
+        : tr("Problems (%1)").arg(issues.size());
+    ui.tabWidget->setTabText(ui.tabWidget->indexOf(ui.problems), title);
+}
+
+/*
+ * Marks every task in the pipeline with its predicted duration and memory
+ * usage from previous runs. The marker goes from green to red relative to
+ * the most expensive task of the job.
+ */
+void JobEditorWindow::updateRunAnnotations()
+{
+    RSRunHistory &history = RSRunHistory::getInstance();
+    
+    const int n = ui.pipelineWidget->count();
+    QVector<rsRunPrediction> predictions(n);
+    QVector<bool> known(n);
+    qint64 maxWallTime = 0;
+    
+    for ( int i=0; i<n; i++ ) {
+        TaskWidget *taskWidget = (TaskWidget*)ui.pipelineWidget->widget(i);
+        known[i] = history.predict(QString(taskWidget->getTask()->getCode()), predictions[i]);
+        if ( known[i] ) {
+            maxWallTime = qMax(maxWallTime, predictions[i].wallTime);
+        }
+    }
+    
+    for ( int i=0; i<n; i++ ) {
+        if ( ! known[i] ) {
+            ui.pipelineWidget->setPageAnnotation(i, QString(), QColor(), tr("No previous runs of this tool"));
+            continue;
+        }
+        
+        const rsRunPrediction &p = predictions[i];
+        double heat = maxWallTime > 0 ? (double)p.wallTime / (double)maxWallTime : 0.0;
+        QColor color = QColor::fromHsvF((1.0 - heat) / 3.0, 0.8, 0.9);
+        
+        QString annotation = QString("~%1, %2")
+            .arg(RSRunHistory::formatDuration(p.wallTime))
+            .arg(RSRunHistory::formatMemory(p.peakMemory));
+        QString toolTip = tr("Based on %1 previous runs: %2 wall time, %3 cpu time, %4 peak memory")
+            .arg(p.runs)
+            .arg(RSRunHistory::formatDuration(p.wallTime))
+            .arg(RSRunHistory::formatDuration(p.cpuTime))
+            .arg(RSRunHistory::formatMemory(p.peakMemory));
+        
+        ui.pipelineWidget->setPageAnnotation(i, annotation, color, toolTip);
+    }
+}
+
+void JobEditorWindow::problemActivated(QListWidgetItem *item)
+{
+    int taskIndex = item->data(Qt::UserRole).toInt();
+    QByteArray option = item->data(Qt::UserRole+1).toString().toUtf8();
+    
+    ui.tabWidget->setCurrentWidget(ui.pipeline);
+    ui.pipelineWidget->setCurrentIndex(taskIndex);
+    
+    TaskWidget *taskWidget = (TaskWidget*)ui.pipelineWidget->widget(taskIndex);
+    if ( taskWidget == NULL ) {
+        return;
+    }
+    
+    SettingWidget *setting = taskWidget->findSettingWidget(option.data());
+    if ( setting != NULL ) {
+        setting->setFocus();
+    }
 }
 
 JobEditorWindow::JobEditorWindow(QMainWindow *parent) : QMainWindow(parent)
 {
     ui.setupUi(this);
     ui.pipelineWidget->removePage(0);
+    setAttribute(Qt::WA_DeleteOnClose);
+    quickInsertDialog = NULL;
+    graphDialog = NULL;
+    graph = new RSJobGraph(this);
+    
+    currentJobPath = NULL;
+    currentJob = NULL;
+    document = NULL;
+    
+    jobFileMtime = -1;
+    jobFileSize = -1;
+    jobWatcher = new QFileSystemWatcher(this);
+    connect(jobWatcher, SIGNAL(fileChanged(const QString&)), this, SLOT(jobFileChanged(const QString&)));
+    reloadTimer.setSingleShot(true);
+    connect(&reloadTimer, SIGNAL(timeout()), this, SLOT(reloadJobFile()));
+    
+    recentFilesMapper = new QSignalMapper(this);
+    connect(recentFilesMapper, SIGNAL(mapped(const QString&)), this, SLOT(openRecentFile(const QString&)));
+    connect(&RSJobPrefetcher::getInstance(), SIGNAL(recentFilesChanged()), this, SLOT(updateRecentFilesMenu()));
+    
+    memoryLabel = new QLabel();
+    memoryLabel->setStyleSheet("color: #606060");
+    statusBar()->addPermanentWidget(memoryLabel);
+    memoryTimer.setInterval(5000);
+    connect(&memoryTimer, SIGNAL(timeout()), this, SLOT(updateMemoryReadout()));
+    memoryTimer.start();
+    
+    validator = new RSJobValidator(this);
+    connect(validator, SIGNAL(jobValidated()), this, SLOT(validationFinished()));
+    connect(ui.problemsList, SIGNAL(itemActivated(QListWidgetItem*)), this, SLOT(problemActivated(QListWidgetItem*)));
+    connect(&RSRunHistory::getInstance(), SIGNAL(historyChanged()), this, SLOT(updateRunAnnotations()));
     
     try {
         createActions();
@@ -278,11 +1310,66 @@ JobEditorWindow::JobEditorWindow(QMainWindow *parent) : QMainWindow(parent)
         errorMessage.showMessage("Unknown error while intializing the application");
     	errorMessage.exec();
     }
-    currentJobPath = NULL;
-    currentJob = NULL;
 }
 
 JobEditorWindow::~JobEditorWindow()
 {
+    closeCurrentJob();
+}
+JobEditorWindowManager& JobEditorWindowManager::getInstance()
+{
+    static JobEditorWindowManager instance;
+    return instance;
+}
+
+JobEditorWindowManager::JobEditorWindowManager() : QObject(0)
+{}
+
+JobEditorWindow* JobEditorWindowManager::createWindow()
+{
+    JobEditorWindow *window = new JobEditorWindow();
+    windows.append(window);
+    connect(window, SIGNAL(destroyed(QObject*)), this, SLOT(windowDestroyed(QObject*)));
+    return window;
+}
+
+QList<JobEditorWindow*> JobEditorWindowManager::getWindows()
+{
+    return windows;
+}
+
+void JobEditorWindowManager::windowDestroyed(QObject *window)
+{
+    windows.removeAll((JobEditorWindow*)window);
+}
+
+// An empty job file only raises the most recently opened window
+void JobEditorWindowManager::openJobInNewWindow(const QString &jobFile)
+{
+    JobEditorWindow *window = NULL;
+    
+    if ( jobFile.isEmpty() ) {
+        if ( windows.isEmpty() ) {
+            return;
+        }
+        window = windows.last();
+    } else {
+        window = createWindow();
+        try {
+            window->openJob(rsString(jobFile.toUtf8().data()));
+        } catch (const exception& e) {
+            QErrorMessage errorMessage(window);
+            errorMessage.showMessage(e.what());
+            errorMessage.exec();
+        } catch (...) {
+            QErrorMessage errorMessage(window);
+            errorMessage.showMessage("Unknown error while opening the job file");
+            errorMessage.exec();
+        }
+    }
     
-}
\ No newline at end of file
+    window->setWindowState((window->windowState() & ~Qt::WindowMinimized) | Qt::WindowActive);
+    window->show();
+    window->raise();
+    window->activateWindow();
+}
@@ -5,14 +5,29 @@
 #include <QWidget>
 #include <QMenuBar>
 #include <QSignalMapper>
+#include <QLabel>
+#include <QTimer>
+#include <QFileSystemWatcher>
 #include "ui/jobeditor.ui.h"
 #include "ui/TaskWidget.h"
+#include "ui/QuickInsertDialog.h"
+#include "rsjobvalidator.h"
+#include "rstoolindex.h"
+#include "rsjobrunqueue.h"
+#include "rsrunhistory.h"
+#include "rsjobgraph.h"
+#include "rsargumentresolver.h"
+#include "rsjobdocument.h"
+#include "rsjobprefetcher.h"
+#include "rsjobdiff.h"
 #include "batch/util/rstool.hpp"
 #include "batch/util/rstask.hpp"
 #include "batch/util/rsjob.hpp"
 #include "batch/util/pluginmanager.hpp"
 #include "batch/util/rsjobparser.hpp"
 
+class JobGraphDialog;
+
 class JobEditorWindow : public QMainWindow
 {
     Q_OBJECT
@@ -22,18 +37,56 @@ public:
     
     void openJob(char* job);
 
+signals:
+    void jobClosed();
+
 protected slots:
     void newFile();
     void open();
+    void openRecentFile(const QString &fileName);
+    void updateRecentFilesMenu();
+    void newWindow();
+    void openInNewWindow();
+    void queueCurrentJob();
+    void queueJobFiles();
+    void showRunQueue();
+    void previewCache();
+    void showFootprint();
+    void showTaskGraph();
+    void graphTaskActivated(int taskIndex);
+    void jobArgumentsChanged();
     void save();
-    void insertNewTask(int taskIndex);
+    void exportMakefile();
+    void exportJobFilesMakefile();
+    void generateJobs();
+    void sweepParameters();
+    void compareWithFile();
+    void mergeChanges();
+    void searchStudy();
+    void insertNewTask(int toolIndex);
+    void quickInsert();
+    void settingChanged(TaskWidget *taskWidget, SettingWidget *setting);
+    void validationFinished();
+    void problemActivated(QListWidgetItem *item);
+    void updateRunAnnotations();
+    void updateMemoryReadout();
+    void jobFileChanged(const QString &path);
+    void reloadJobFile();
     
 protected:
     void createActions();
     void createMenus();
     void createInsertTaskMenuItems();
-    void insertTask(RSTask* task);
+    void insertTask(RSTask* task, TaskWidget *widget = NULL, int index = -1);
+    void setupArgumentsTable();
+    void updateJobViews();
+    void watchJobFile();
+    bool confirmReload(const RSJobSnapshot &changed);
+    void replaceDocument(RSJobDocument *incoming, const RSJobDiff &diff);
     void closeCurrentJob();
+    void updateValidationMarkers(int taskIndex);
+    void updateProblemsList();
+    void trackSetting(SettingWidget *setting);
     
     
     Ui::JobEditor ui;
@@ -43,13 +96,77 @@ protected:
     QMenu *fileMenu;
     QAction *newAct;
     QAction *openAct;
+    QMenu *recentFilesMenu;
+    QSignalMapper *recentFilesMapper;
     QAction *saveAct;
+    QAction *exportMakefileAct;
+    QAction *exportJobFilesMakefileAct;
+    QAction *generateJobsAct;
+    QAction *sweepAct;
+    QAction *compareAct;
+    QAction *mergeAct;
+    QAction *searchStudyAct;
+    QAction *newWindowAct;
+    QAction *openInNewWindowAct;
+    QAction *closeWindowAct;
     QAction *exitAct;
     
     QMenu *insertMenu;
+    QAction *quickInsertAct;
+    QuickInsertDialog *quickInsertDialog;
+    
+    QMenu *runMenu;
+    QAction *queueJobAct;
+    QAction *queueJobFilesAct;
+    QAction *showRunQueueAct;
+    QAction *previewCacheAct;
+    QAction *showGraphAct;
+    QAction *showFootprintAct;
     
-    RSJob *currentJob;
+    RSJobValidator *validator;
+    RSJobGraph *graph;
+    RSArgumentResolver resolver;
+    QHash<QString, QSet<SettingWidget*> > settingsByArgument;
+    QHash<SettingWidget*, QStringList> argumentsBySetting;
+    JobGraphDialog *graphDialog;
+    
+    RSJobDocument *document;
+    RSJob *currentJob;        // the document's job
     char *currentJobPath;
+    
+    QLabel *memoryLabel;
+    QTimer memoryTimer;
+    
+    QFileSystemWatcher *jobWatcher;
+    QTimer reloadTimer;
+    qint64 jobFileMtime;     // as last read or written by the editor
+    qint64 jobFileSize;
+};
+
+/*
+ * Keeps track of all open job windows. Every window edits its own job,
+ * while plugins, the tool index and the UI descriptors are shared by all
+ * of them.
+ */
+class JobEditorWindowManager : public QObject
+{
+    Q_OBJECT
+public:
+    static JobEditorWindowManager& getInstance();
+    
+    JobEditorWindow* createWindow();
+    QList<JobEditorWindow*> getWindows();
+    
+public slots:
+    void openJobInNewWindow(const QString &jobFile);
+    
+protected slots:
+    void windowDestroyed(QObject *window);
+    
+protected:
+    JobEditorWindowManager();
+    
+    QList<JobEditorWindow*> windows;
 };
 
 #endif
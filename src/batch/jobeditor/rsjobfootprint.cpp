@@ -0,0 +1,166 @@
+#include "rsjobfootprint.h"
+#include "rsrunhistory.h"
+#include <QFileInfo>
+#include <QHash>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    qint64 data;             // uncompressed voxel data in bytes
+    qint64 size;             // on disk
+} rsImageEstimate;
+
+RSJobFootprint::RSJobFootprint(const RSJobSnapshot& job, QObject *parent) : QThread(parent)
+{
+    this->job = job;
+    cancelled = false;
+}
+
+QList<rsTaskFootprint> RSJobFootprint::getTasks()
+{
+    return results;
+}
+
+QList<rsFilesystemFootprint> RSJobFootprint::getFilesystems()
+{
+    return filesystems;
+}
+
+// Stops before the next image header is read, the results are incomplete
+void RSJobFootprint::cancel()
+{
+    cancelled = true;
+}
+
+bool RSJobFootprint::getAvailableSpace(const QString &directory, qint64 &available, qint64 &device)
+{
+    QByteArray p = directory.toLocal8Bit();
+    struct stat buffer;
+    struct statvfs fs;
+
+    if ( ::stat(p.data(), &buffer) != 0 || statvfs(p.data(), &fs) != 0 ) {
+        return false;
+    }
+
+    device    = (qint64)buffer.st_dev;
+    available = (qint64)fs.f_bavail * (qint64)fs.f_frsize;
+    return true;
+}
+
+void RSJobFootprint::run()
+{
+    RSNiftiHeaderCache &cache = RSNiftiHeaderCache::getInstance();
+    QHash<QString, rsImageEstimate> written;
+    QHash<qint64, int> filesystemIndex;
+
+    RSArgumentResolver resolver;
+    resolver.update(job.getArgumentValues());
+
+    QList<rsTaskCacheDescriptor> tasks;
+    for ( int i=0; i<job.getTaskCount(); i++ ) {
+        tasks << RSTaskCache::describe(job.getTask(i), resolver);
+    }
+
+    for ( int i=0; i<tasks.size() && ! cancelled; i++ ) {
+        const rsTaskCacheDescriptor &task = tasks.at(i);
+        rsTaskFootprint result;
+        result.inputSize  = 0;
+        result.inputData  = 0;
+        result.outputSize = 0;
+        result.memory     = 0;
+
+        rsImageEstimate largest;
+        largest.data = 0;
+        largest.size = 0;
+
+        foreach( const QString &input, task.inputs ) {
+            if ( cancelled ) {
+                return;
+            }
+            if ( ! RSNiftiHeaderCache::isNiftiPath(input) ) {
+                QFileInfo info(input);
+                if ( info.isFile() ) {
+                    result.inputSize += info.size();
+                }
+                continue;
+            }
+
+            rsImageEstimate image;
+            QString description;
+
+            if ( written.contains(input) ) {
+                // the file is only going to be written by an earlier task
+                image = written.value(input);
+                description = QObject::tr("written by an earlier task");
+            } else {
+                rsNiftiHeader header = cache.fetch(input);
+                if ( ! header.valid ) {
+                    result.files << QString("%1: %2").arg(input).arg(header.error);
+                    continue;
+                }
+                image.data = RSNiftiHeaderCache::getDataSize(header);
+                image.size = header.fileSize;
+                description = RSNiftiHeaderCache::describe(header);
+            }
+
+            result.inputSize += image.size;
+            result.inputData += image.data;
+            if ( image.data > largest.data ) {
+                largest = image;
+            }
+
+            result.files << QString("%1: %2, %3")
+                .arg(input)
+                .arg(description)
+                .arg(RSRunHistory::formatMemory(image.data / 1024));
+        }
+
+        qint64 outputData = 0;
+        foreach( const QString &output, task.outputs ) {
+            if ( ! RSNiftiHeaderCache::isNiftiPath(output) || largest.data == 0 ) {
+                continue;
+            }
+
+            // compressed outputs shrink about as well as the input did,
+            // uncompressed ones hold the voxels and a NIfTI-1 header
+            rsImageEstimate image = largest;
+            if ( ! output.toLower().endsWith(".gz") ) {
+                image.size = image.data + 352;
+            }
+
+            written.insert(output, image);
+            outputData += image.data;
+            result.outputSize += image.size;
+
+            result.files << QString("%1: about %2")
+                .arg(output)
+                .arg(RSRunHistory::formatMemory(image.size / 1024));
+
+            qint64 available, device;
+            QString directory = QFileInfo(output).absolutePath();
+            if ( ! getAvailableSpace(directory, available, device) ) {
+                continue;
+            }
+
+            if ( ! filesystemIndex.contains(device) ) {
+                rsFilesystemFootprint filesystem;
+                filesystem.directory = directory;
+                filesystem.required  = 0;
+                filesystem.available = available;
+                filesystemIndex.insert(device, filesystems.size());
+                filesystems.append(filesystem);
+            }
+            filesystems[filesystemIndex.value(device)].required += image.size;
+        }
+
+        result.memory = result.inputData + outputData;
+        results.append(result);
+    }
+}
+
+}}} // namespace rstools::batch::util
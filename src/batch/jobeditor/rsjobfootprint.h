@@ -0,0 +1,60 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobfootprint_h
+#define rstools_rsbatch_jobeditor_rsjobfootprint_h
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include "rstaskcache.h"
+#include "rsniftiheader.h"
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    qint64 inputSize;        // on disk, in bytes
+    qint64 inputData;        // uncompressed voxel data of all input images
+    qint64 outputSize;       // estimated size on disk of all outputs
+    qint64 memory;           // estimated voxel data held at once
+    QStringList files;       // one line per file, for tooltips
+} rsTaskFootprint;
+
+typedef struct {
+    QString directory;       // first output directory on that filesystem
+    qint64 required;         // estimated bytes written by the job
+    qint64 available;        // free bytes for unprivileged users
+} rsFilesystemFootprint;
+
+/*
+ * Estimates how much data the tasks of a job read and write, using only
+ * the headers of their image files. Outputs are assumed to be as large as
+ * the largest image that their task reads, and images that are written by
+ * an earlier task count with that estimate once a later task reads them.
+ * The space needed is summed up for every filesystem that is written to.
+ * Works on a snapshot of the job, which may go on being edited meanwhile.
+ */
+class RSJobFootprint : public QThread
+{
+public:
+    RSJobFootprint(const RSJobSnapshot& job, QObject *parent = 0);
+
+    QList<rsTaskFootprint> getTasks();
+    QList<rsFilesystemFootprint> getFilesystems();
+    void cancel();
+
+    static bool getAvailableSpace(const QString &directory, qint64 &available, qint64 &device);
+
+protected:
+    void run();
+
+    RSJobSnapshot job;
+    QList<rsTaskFootprint> results;
+    QList<rsFilesystemFootprint> filesystems;
+    volatile bool cancelled;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
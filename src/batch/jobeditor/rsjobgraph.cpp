@@ -0,0 +1,296 @@
+#include "rsjobgraph.h"
+#include <QTextStream>
+#include <QVector>
+#include <QtAlgorithms>
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobGraph::RSJobGraph(QObject *parent) : QObject(parent)
+{
+    stageCount = 0;
+    branchCount = 0;
+}
+
+RSJobGraph::~RSJobGraph()
+{
+
+}
+
+void RSJobGraph::clear()
+{
+    nodes.clear();
+    accesses.clear();
+    stageCount = 0;
+    branchCount = 0;
+    emit graphChanged();
+}
+
+void RSJobGraph::build(RSJob* job)
+{
+    nodes.clear();
+    accesses.clear();
+
+    vector<RSTask*> tasks = job->getTasks();
+    for ( size_t i=0; i<tasks.size(); i++ ) {
+        rsTaskCacheDescriptor task = RSTaskCache::describe(job, tasks[i]);
+
+        rsJobGraphNode node;
+        node.stage = 0;
+        node.branch = 0;
+        nodes.append(node);
+
+        // all earlier tasks are known, so the dependencies are final
+        setFiles((int)i, task.inputs, task.outputs);
+        computeDependencies((int)i);
+    }
+
+    computeLayout();
+    emit graphChanged();
+}
+
+void RSJobGraph::updateTask(int index, const rsTaskCacheDescriptor& task)
+{
+    if ( index < 0 || index > nodes.size() ) {
+        return;
+    }
+
+    QSet<QString> affected;
+
+    if ( index == nodes.size() ) {
+        rsJobGraphNode node;
+        node.stage = 0;
+        node.branch = 0;
+        nodes.append(node);
+    } else {
+        const rsJobGraphNode &node = nodes.at(index);
+        if ( node.inputs == task.inputs && node.outputs == task.outputs ) {
+            return;
+        }
+        affected += node.inputs.toSet();
+        affected += node.outputs.toSet();
+    }
+
+    affected += task.inputs.toSet();
+    affected += task.outputs.toSet();
+
+    setFiles(index, task.inputs, task.outputs);
+
+    // only later tasks sharing one of the files can depend on this one
+    QSet<int> tasks;
+    tasks.insert(index);
+    foreach( const QString &file, affected ) {
+        foreach( const rsJobGraphAccess &access, accesses.value(file) ) {
+            if ( access.task > index ) {
+                tasks.insert(access.task);
+            }
+        }
+    }
+
+    foreach( int t, tasks ) {
+        computeDependencies(t);
+    }
+
+    computeLayout();
+    emit graphChanged();
+}
+
+void RSJobGraph::setFiles(int index, const QStringList& inputs, const QStringList& outputs)
+{
+    rsJobGraphNode &node = nodes[index];
+
+    QStringList oldFiles = node.inputs + node.outputs;
+    foreach( const QString &file, oldFiles ) {
+        QHash<QString, QList<rsJobGraphAccess> >::iterator it = accesses.find(file);
+        if ( it == accesses.end() ) {
+            continue;
+        }
+        for ( int i=it->size()-1; i>=0; i-- ) {
+            if ( it->at(i).task == index ) {
+                it->removeAt(i);
+            }
+        }
+        if ( it->isEmpty() ) {
+            accesses.erase(it);
+        }
+    }
+
+    node.inputs = inputs;
+    node.outputs = outputs;
+
+    for ( int w=0; w<2; w++ ) {
+        const QStringList &files = w == 0 ? inputs : outputs;
+        foreach( const QString &file, files ) {
+            rsJobGraphAccess access;
+            access.task = index;
+            access.write = w == 1;
+
+            // keep the accesses in task order
+            QList<rsJobGraphAccess> &list = accesses[file];
+            int position = list.size();
+            while ( position > 0 && list.at(position - 1).task > index ) {
+                position--;
+            }
+            list.insert(position, access);
+        }
+    }
+}
+
+void RSJobGraph::computeDependencies(int index)
+{
+    rsJobGraphNode &node = nodes[index];
+    node.dependencies.clear();
+
+    QStringList files = node.inputs + node.outputs;
+    for ( int f=0; f<files.size(); f++ ) {
+        const bool write = f >= node.inputs.size();
+        const QList<rsJobGraphAccess> list = accesses.value(files.at(f));
+
+        // walk back from the task to the last earlier write of the file
+        for ( int i=list.size()-1; i>=0; i-- ) {
+            const rsJobGraphAccess &access = list.at(i);
+            if ( access.task >= index ) {
+                continue;
+            }
+            if ( access.write ) {
+                node.dependencies.insert(access.task);
+                break;
+            }
+            // reads in between only matter if the file is overwritten
+            if ( write ) {
+                node.dependencies.insert(access.task);
+            }
+        }
+    }
+}
+
+/*
+ * Assigns every task to the earliest stage after all of its dependencies
+ * and groups tasks that are connected through dependencies into branches.
+ */
+void RSJobGraph::computeLayout()
+{
+    const int n = nodes.size();
+    QVector<int> parent(n);
+    for ( int i=0; i<n; i++ ) {
+        parent[i] = i;
+    }
+
+    stageCount = 0;
+    for ( int i=0; i<n; i++ ) {
+        rsJobGraphNode &node = nodes[i];
+        node.stage = 0;
+        foreach( int d, node.dependencies ) {
+            node.stage = qMax(node.stage, nodes.at(d).stage + 1);
+
+            int a = i, b = d;
+            while ( parent[a] != a ) a = parent[a];
+            while ( parent[b] != b ) b = parent[b];
+            parent[qMax(a, b)] = qMin(a, b);
+        }
+        stageCount = qMax(stageCount, node.stage + 1);
+    }
+
+    QHash<int, int> branches;
+    for ( int i=0; i<n; i++ ) {
+        int root = i;
+        while ( parent[root] != root ) root = parent[root];
+        if ( ! branches.contains(root) ) {
+            branches.insert(root, branches.size());
+        }
+        nodes[i].branch = branches.value(root);
+    }
+    branchCount = branches.size();
+}
+
+int RSJobGraph::size()
+{
+    return nodes.size();
+}
+
+const rsJobGraphNode& RSJobGraph::getNode(int index)
+{
+    return nodes.at(index);
+}
+
+QList<int> RSJobGraph::getDependents(int index)
+{
+    QList<int> result;
+    for ( int i=index+1; i<nodes.size(); i++ ) {
+        if ( nodes.at(i).dependencies.contains(index) ) {
+            result.append(i);
+        }
+    }
+    return result;
+}
+
+int RSJobGraph::getStageCount()
+{
+    return stageCount;
+}
+
+int RSJobGraph::getBranchCount()
+{
+    return branchCount;
+}
+
+QList<QList<int> > RSJobGraph::getStages()
+{
+    QList<QList<int> > stages;
+    for ( int s=0; s<stageCount; s++ ) {
+        stages.append(QList<int>());
+    }
+    for ( int i=0; i<nodes.size(); i++ ) {
+        stages[nodes.at(i).stage].append(i);
+    }
+    return stages;
+}
+
+/*
+ * Plain text execution plan: one block per stage listing the tasks that
+ * can be run concurrently once the previous stages are done.
+ */
+QString RSJobGraph::toPlan(RSJob* job)
+{
+    vector<RSTask*> tasks = job->getTasks();
+
+    QString plan;
+    QTextStream out(&plan);
+
+    out << "# " << nodes.size() << " tasks in " << stageCount << " stages and " << branchCount << " independent branches\n";
+    out << "# tasks within a stage do not depend on each other and can run at the same time\n";
+
+    QList<QList<int> > stages = getStages();
+    for ( int s=0; s<stages.size(); s++ ) {
+        out << "\nstage " << (s + 1) << "\n";
+
+        foreach( int i, stages.at(s) ) {
+            QStringList dependencies;
+            QList<int> sorted = nodes.at(i).dependencies.toList();
+            qSort(sorted);
+            foreach( int d, sorted ) {
+                dependencies << QString::number(d + 1);
+            }
+
+            out << "  task " << (i + 1)
+                << "\tbranch " << (nodes.at(i).branch + 1);
+            if ( i < (int)tasks.size() ) {
+                out << "\t" << tasks[i]->getCode()
+                    << "\t" << QString::fromUtf8(tasks[i]->getDescription());
+            }
+            if ( ! dependencies.isEmpty() ) {
+                out << "\tafter " << dependencies.join(", ");
+            }
+            out << "\n";
+        }
+    }
+
+    out.flush();
+    return plan;
+}
+
+}}} // namespace rstools::batch::util
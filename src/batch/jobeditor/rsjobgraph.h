@@ -0,0 +1,74 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobgraph_h
+#define rstools_rsbatch_jobeditor_rsjobgraph_h
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include "rstaskcache.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    QStringList inputs;
+    QStringList outputs;
+    QSet<int> dependencies;  // earlier tasks that have to be done first
+    int stage;               // tasks of the same stage can run in parallel
+    int branch;              // tasks connected through files share a branch
+} rsJobGraphNode;
+
+typedef struct {
+    int task;
+    bool write;
+} rsJobGraphAccess;
+
+/*
+ * Data dependencies between the tasks of a job, derived from the files
+ * they read and write. A task depends on the last earlier task that writes
+ * one of its inputs, and it also has to wait for earlier tasks that read
+ * or write any of the files it overwrites.
+ *
+ * Changing a single task only recomputes the dependencies of the tasks
+ * that share a file with the old or the new version of it.
+ */
+class RSJobGraph : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RSJobGraph(QObject *parent = 0);
+    ~RSJobGraph();
+
+    void build(RSJob* job);
+    void clear();
+    void updateTask(int index, const rsTaskCacheDescriptor& task);
+
+    int size();
+    const rsJobGraphNode& getNode(int index);
+    QList<int> getDependents(int index);
+    int getStageCount();
+    int getBranchCount();
+    QList<QList<int> > getStages();
+
+    QString toPlan(RSJob* job);
+
+signals:
+    void graphChanged();
+
+protected:
+    void setFiles(int index, const QStringList& inputs, const QStringList& outputs);
+    void computeDependencies(int index);
+    void computeLayout();
+
+    QList<rsJobGraphNode> nodes;
+    QHash<QString, QList<rsJobGraphAccess> > accesses;   // by file, in task order
+    int stageCount;
+    int branchCount;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
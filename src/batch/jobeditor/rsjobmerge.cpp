@@ -0,0 +1,246 @@
+#include "rsjobmerge.h"
+#include "rsjobdiff.h"
+#include "rsjobutils.h"
+#include <QVector>
+#include <stdexcept>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    rsTaskSnapshotPointer task;
+    int theirs;              // index in "theirs", -1 if only ours has it
+} rsMergedTask;
+
+static bool sameArgument(bool inA, const rsArgumentSnapshot &a, bool inB, const rsArgumentSnapshot &b)
+{
+    if ( inA != inB ) {
+        return false;
+    }
+    return ! inA || (a.hasValue == b.hasValue && a.value == b.value);
+}
+
+static int findTheirs(const QList<rsMergedTask> &merged, int theirs)
+{
+    for ( int i=0; i<merged.size(); i++ ) {
+        if ( merged[i].theirs == theirs ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+RSJobMerge::RSJobMerge(const RSJobSnapshot &base, const RSJobSnapshot &ours, const RSJobSnapshot &theirs)
+{
+    const int n = base.getTaskCount();
+    QVector<int> ourOf(n, -1), theirOf(n, -1);
+    QVector<bool> ourChanged(n, false), theirChanged(n, false);
+    QVector<bool> ourMoved(n, false), theirMoved(n, false);
+    QVector<int> baseOfOurs(ours.getTaskCount(), -1), baseOfTheirs(theirs.getTaskCount(), -1);
+
+    foreach( const rsTaskChange &change, RSJobComparison(base, ours).getTasks() ) {
+        if ( change.from >= 0 && change.to >= 0 ) {
+            ourOf[change.from] = change.to;
+            ourChanged[change.from] = change.type == TASK_CHANGED;
+            ourMoved[change.from] = change.type == TASK_MOVED;
+            baseOfOurs[change.to] = change.from;
+        }
+    }
+    foreach( const rsTaskChange &change, RSJobComparison(base, theirs).getTasks() ) {
+        if ( change.from >= 0 && change.to >= 0 ) {
+            theirOf[change.from] = change.to;
+            theirChanged[change.from] = change.type == TASK_CHANGED;
+            theirMoved[change.from] = change.type == TASK_MOVED;
+            baseOfTheirs[change.to] = change.from;
+        }
+    }
+
+    // everything that ours kept or added, in its order
+    QList<rsMergedTask> merged;
+    for ( int k=0; k<ours.getTaskCount(); k++ ) {
+        const int i = baseOfOurs[k];
+        rsMergedTask item;
+        item.task = ours.getTaskPointer(k);
+        item.theirs = -1;
+
+        if ( i >= 0 ) {
+            const int t = theirOf[i];
+            if ( t < 0 ) {
+                if ( ! ourChanged[i] ) {
+                    continue;
+                }
+                conflicts << QString("%1 was changed here but removed there")
+                    .arg(RSJobComparison::formatTask(k, ours.getTask(k)));
+            } else {
+                item.theirs = t;
+                if ( ourChanged[i] && theirChanged[i] ) {
+                    item.task = rsTaskSnapshotPointer(new rsTaskSnapshot(mergeTask(base.getTask(i), ours.getTask(k), theirs.getTask(t), k)));
+                } else if ( theirChanged[i] ) {
+                    item.task = theirs.getTaskPointer(t);
+                }
+            }
+        }
+
+        merged << item;
+    }
+
+    // then what theirs added or moved, after the task it follows there
+    for ( int t=0; t<theirs.getTaskCount(); t++ ) {
+        const int i = baseOfTheirs[t];
+
+        if ( i < 0 ) {
+            // both sides may have added the same task
+            bool added = false;
+            for ( int m=0; m<merged.size() && ! added; m++ ) {
+                if ( merged[m].theirs < 0 && merged[m].task->hash == theirs.getTask(t).hash ) {
+                    merged[m].theirs = t;
+                    added = true;
+                }
+            }
+            if ( added ) {
+                continue;
+            }
+        } else if ( ourOf[i] < 0 ) {
+            if ( ! theirChanged[i] ) {
+                continue;
+            }
+            conflicts << QString("%1 was removed here but changed there")
+                .arg(RSJobComparison::formatTask(t, theirs.getTask(t)));
+        } else if ( theirMoved[i] && ! ourMoved[i] ) {
+            int current = findTheirs(merged, t);
+            if ( current >= 0 ) {
+                merged.removeAt(current);
+            }
+        } else {
+            continue;
+        }
+
+        int position = 0;
+        for ( int p=t-1; p>=0; p-- ) {
+            int m = findTheirs(merged, p);
+            if ( m >= 0 ) {
+                position = m + 1;
+                break;
+            }
+        }
+
+        rsMergedTask item;
+        item.task = theirs.getTaskPointer(t);
+        item.theirs = t;
+        merged.insert(position, item);
+    }
+
+    result.revision = 0;
+    result.arguments = rsArgumentsSnapshotPointer(new QList<rsArgumentSnapshot>(
+        mergeArguments(base.getArguments(), ours.getArguments(), theirs.getArguments(), QString("Job arguments"))
+    ));
+    foreach( const rsMergedTask &item, merged ) {
+        result.tasks << item.task;
+    }
+}
+
+bool RSJobMerge::hasConflicts() const
+{
+    return ! conflicts.isEmpty();
+}
+
+QStringList RSJobMerge::getConflicts() const
+{
+    return conflicts;
+}
+
+RSJobSnapshot RSJobMerge::getResult() const
+{
+    return result;
+}
+
+rsTaskSnapshot RSJobMerge::mergeTask(const rsTaskSnapshot &base, const rsTaskSnapshot &ours, const rsTaskSnapshot &theirs, int index)
+{
+    const QString context = RSJobComparison::formatTask(index, ours);
+
+    rsTaskSnapshot task;
+    task.code = ours.code;
+    task.description = ours.description;
+    if ( ours.description == base.description ) {
+        task.description = theirs.description;
+    } else if ( theirs.description != base.description && theirs.description != ours.description ) {
+        conflicts << QString("%1: the description is \"%2\" here and \"%3\" there")
+            .arg(context)
+            .arg(ours.description)
+            .arg(theirs.description);
+    }
+
+    task.arguments = mergeArguments(base.arguments, ours.arguments, theirs.arguments, context);
+    task.hash = RSJobDiff::hashTask(task);
+    return task;
+}
+
+// Arguments in the order of ours, followed by those that only theirs added
+QList<rsArgumentSnapshot> RSJobMerge::mergeArguments(const QList<rsArgumentSnapshot> &base, const QList<rsArgumentSnapshot> &ours, const QList<rsArgumentSnapshot> &theirs, const QString &context)
+{
+    QStringList baseIds, ourIds, theirIds;
+    QHash<QString, rsArgumentSnapshot> b = RSJobComparison::indexArguments(base, baseIds);
+    QHash<QString, rsArgumentSnapshot> o = RSJobComparison::indexArguments(ours, ourIds);
+    QHash<QString, rsArgumentSnapshot> t = RSJobComparison::indexArguments(theirs, theirIds);
+
+    QStringList ids = ourIds;
+    foreach( const QString &id, theirIds ) {
+        if ( ! o.contains(id) ) {
+            ids << id;
+        }
+    }
+
+    QList<rsArgumentSnapshot> merged;
+    foreach( const QString &id, ids ) {
+        const bool inBase = b.contains(id), inOurs = o.contains(id), inTheirs = t.contains(id);
+        const rsArgumentSnapshot ourArgument = o.value(id), theirArgument = t.value(id);
+        bool takeTheirs = false;
+
+        if ( sameArgument(inOurs, ourArgument, inTheirs, theirArgument) ) {
+            takeTheirs = false;
+        } else if ( sameArgument(inOurs, ourArgument, inBase, b.value(id)) ) {
+            takeTheirs = true;
+        } else if ( ! sameArgument(inTheirs, theirArgument, inBase, b.value(id)) ) {
+            conflicts << QString("%1: %2 is %3 here and %4 there")
+                .arg(context)
+                .arg(inOurs ? ourArgument.key : theirArgument.key)
+                .arg(RSJobComparison::formatValue(inOurs, ourArgument))
+                .arg(RSJobComparison::formatValue(inTheirs, theirArgument));
+        }
+
+        if ( takeTheirs ? inTheirs : inOurs ) {
+            merged << (takeTheirs ? theirArgument : ourArgument);
+        }
+    }
+
+    return merged;
+}
+
+// Writes the merged job as a job file (throws a runtime_error on failure)
+void RSJobMerge::write(const QString &path) const
+{
+    QList<rsTaskSnapshot> tasks;
+    for ( int i=0; i<result.getTaskCount(); i++ ) {
+        tasks << result.getTask(i);
+    }
+
+    RSJobParser *parser = NULL;
+    RSJob *job = rsJobCreateFromSnapshot(result.getArguments(), tasks, parser);
+
+    QByteArray p = path.toUtf8();
+    try {
+        rsJobWriteFile(job, p.data());
+    } catch (...) {
+        delete job;
+        delete parser;
+        throw;
+    }
+
+    delete job;
+    delete parser;
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,48 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobmerge_h
+#define rstools_rsbatch_jobeditor_rsjobmerge_h
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "rsjobsnapshot.h"
+#include "rsjobcomparison.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Three-way merge of two jobs that were both derived from the same base,
+ * e.g. a subject's job and a new version of the template it was created
+ * from. Tasks are paired through RSJobComparison, so a task that one side
+ * edited and the other one left alone gets the edit, and arguments of a
+ * task that both sides edited are merged one by one. The order of the
+ * tasks follows "ours", with the tasks that "theirs" added or moved placed
+ * after the task they follow there.
+ *
+ * Whatever was changed differently on both sides is listed as a conflict
+ * and resolved in favour of "ours", or of the edited version if the other
+ * side removed the task.
+ */
+class RSJobMerge
+{
+public:
+    RSJobMerge(const RSJobSnapshot &base, const RSJobSnapshot &ours, const RSJobSnapshot &theirs);
+
+    bool hasConflicts() const;
+    QStringList getConflicts() const;
+    RSJobSnapshot getResult() const;
+
+    void write(const QString &path) const;
+
+protected:
+    QList<rsArgumentSnapshot> mergeArguments(const QList<rsArgumentSnapshot> &base, const QList<rsArgumentSnapshot> &ours, const QList<rsArgumentSnapshot> &theirs, const QString &context);
+    rsTaskSnapshot mergeTask(const rsTaskSnapshot &base, const rsTaskSnapshot &ours, const rsTaskSnapshot &theirs, int index);
+
+    RSJobSnapshot result;
+    QStringList conflicts;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,375 @@
+#include "rsjobprefetcher.h"
+#include "rsjobbinarycache.h"
+#include "rsjobutils.h"
+#include "rstoolindex.h"
+#include "ui/TaskWidget.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QEvent>
+#include <QFileInfo>
+#include <QSettings>
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobPrefetchThread::RSJobPrefetchThread(const QString &path, const QString &cachePath, QObject *parent) : QThread(parent)
+{
+    this->path = path;
+    this->cachePath = cachePath;
+    readable = false;
+}
+
+QString RSJobPrefetchThread::getPath()
+{
+    return path;
+}
+
+bool RSJobPrefetchThread::isReadable()
+{
+    return readable;
+}
+
+void RSJobPrefetchThread::run()
+{
+    readable = rsJobPrefetchFile(path);
+
+    // there may be no binary copy yet
+    if ( readable && ! cachePath.isEmpty() ) {
+        rsJobPrefetchFile(cachePath);
+    }
+}
+
+RSJobPrefetcher& RSJobPrefetcher::getInstance()
+{
+    static RSJobPrefetcher instance;
+    return instance;
+}
+
+RSJobPrefetcher::RSJobPrefetcher() : QObject(0)
+{
+    worker = NULL;
+    isIdle = false;
+
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(idleDelay);
+    connect(&idleTimer, SIGNAL(timeout()), this, SLOT(idle()));
+
+    documentTimer.setSingleShot(true);
+    documentTimer.setInterval(0);
+    connect(&documentTimer, SIGNAL(timeout()), this, SLOT(createDocument()));
+
+    pageTimer.setInterval(0);
+    connect(&pageTimer, SIGNAL(timeout()), this, SLOT(createPage()));
+
+    // pages are widgets and have to go before the application does
+    QCoreApplication *application = QCoreApplication::instance();
+    application->installEventFilter(this);
+    connect(application, SIGNAL(aboutToQuit()), this, SLOT(clear()));
+
+    idleTimer.start();
+}
+
+RSJobPrefetcher::~RSJobPrefetcher()
+{
+    clear();
+}
+
+void RSJobPrefetcher::clear()
+{
+    idleTimer.stop();
+    documentTimer.stop();
+    pageTimer.stop();
+    fetched.clear();
+
+    if ( worker != NULL ) {
+        disconnect(worker, SIGNAL(finished()), this, SLOT(threadFinished()));
+        worker->wait();
+        delete worker;
+        worker = NULL;
+    }
+
+    foreach( const QString &path, prefetched.keys() ) {
+        discard(path);
+    }
+}
+
+QString RSJobPrefetcher::normalize(const QString &path)
+{
+    return QFileInfo(path).absoluteFilePath();
+}
+
+bool RSJobPrefetcher::getFileState(const QString &path, qint64 &mtime, qint64 &size)
+{
+    QFileInfo info(path);
+    if ( ! info.isFile() ) {
+        return false;
+    }
+    mtime = info.lastModified().toMSecsSinceEpoch();
+    size  = info.size();
+    return true;
+}
+
+// Most recently opened first
+QStringList RSJobPrefetcher::getRecentFiles()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("recent/files").toStringList();
+}
+
+void RSJobPrefetcher::addRecentFile(const QString &path)
+{
+    QString file = normalize(path);
+    QStringList files = getRecentFiles();
+
+    files.removeAll(file);
+    files.prepend(file);
+    while ( files.size() > maxRecentFiles ) {
+        discard(files.takeLast());
+    }
+
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("recent/files", files);
+
+    emit recentFilesChanged();
+}
+
+// Memory that prefetched jobs may take, in MB
+int RSJobPrefetcher::getMemoryLimit()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("recent/prefetchMemory", 64).toInt();
+}
+
+bool RSJobPrefetcher::isPrefetchingPages()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("recent/prefetchPages", false).toBool();
+}
+
+// Open jobs are not read again in the background
+void RSJobPrefetcher::documentOpened(const QString &path)
+{
+    openCounts[normalize(path)]++;
+}
+
+void RSJobPrefetcher::documentClosed(const QString &path)
+{
+    QString file = normalize(path);
+    if ( --openCounts[file] <= 0 ) {
+        openCounts.remove(file);
+    }
+}
+
+/*
+ * Hands a prefetched job over to a window, together with the pages that
+ * were already created for its first tasks. Returns NULL if the job was
+ * not prefetched or has changed since.
+ */
+RSJobDocument* RSJobPrefetcher::take(const QString &path, QList<TaskWidget*> &pages)
+{
+    QString file = normalize(path);
+    if ( ! prefetched.contains(file) ) {
+        return NULL;
+    }
+
+    qint64 mtime, size;
+    const rsPrefetchedJob &job = prefetched[file];
+    if ( ! getFileState(file, mtime, size) || mtime != job.mtime || size != job.size ) {
+        discard(file);
+        return NULL;
+    }
+
+    rsPrefetchedJob result = prefetched.take(file);
+    pages = result.pages;
+    return result.document;
+}
+
+void RSJobPrefetcher::discard(const QString &path)
+{
+    if ( ! prefetched.contains(path) ) {
+        return;
+    }
+
+    rsPrefetchedJob job = prefetched.take(path);
+    qDeleteAll(job.pages);
+    delete job.document;
+}
+
+bool RSJobPrefetcher::eventFilter(QObject *watched, QEvent *event)
+{
+    switch ( event->type() ) {
+        case QEvent::KeyPress:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseMove:
+        case QEvent::Wheel:
+            // back off as long as someone is working with the editor
+            isIdle = false;
+            documentTimer.stop();
+            pageTimer.stop();
+            idleTimer.start();
+            break;
+        default:
+            break;
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void RSJobPrefetcher::idle()
+{
+    isIdle = true;
+
+    // drop what has been changed on disk in the meantime
+    foreach( const QString &path, prefetched.keys() ) {
+        qint64 mtime, size;
+        if ( ! getFileState(path, mtime, size) || mtime != prefetched[path].mtime || size != prefetched[path].size ) {
+            discard(path);
+        }
+    }
+
+    if ( fetched.isEmpty() ) {
+        prefetchNext();
+    } else {
+        documentTimer.start();
+    }
+
+    if ( isPrefetchingPages() ) {
+        pageTimer.start();
+    }
+}
+
+// Reads the next recent job from disk, one job at a time
+void RSJobPrefetcher::prefetchNext()
+{
+    if ( worker != NULL || ! fetched.isEmpty() || ! isIdle ) {
+        return;
+    }
+
+    const qint64 limit = (qint64)getMemoryLimit() * 1024 * 1024;
+    qint64 used = 0;
+    foreach( const rsPrefetchedJob &job, prefetched ) {
+        used += job.size;
+    }
+
+    foreach( const QString &path, getRecentFiles() ) {
+        if ( prefetched.contains(path) || openCounts.contains(path) || failed.contains(path) ) {
+            continue;
+        }
+
+        // a parsed job takes about as much memory as its file
+        qint64 mtime, size;
+        if ( ! getFileState(path, mtime, size) || used + size > limit ) {
+            continue;
+        }
+
+        QString cachePath;
+        RSJobBinaryCache &cache = RSJobBinaryCache::getInstance();
+        if ( cache.isEnabled() ) {
+            cachePath = cache.getCachePath(path);
+        }
+
+        worker = new RSJobPrefetchThread(path, cachePath, this);
+        connect(worker, SIGNAL(finished()), this, SLOT(threadFinished()));
+        worker->start(QThread::LowestPriority);
+        return;
+    }
+}
+
+void RSJobPrefetcher::threadFinished()
+{
+    RSJobPrefetchThread *thread = worker;
+    worker = NULL;
+
+    QString path = thread->getPath();
+    if ( thread->isReadable() ) {
+        fetched << path;
+    } else {
+        // not tried again before the editor is restarted
+        failed.insert(path);
+    }
+    thread->deleteLater();
+
+    if ( isIdle ) {
+        documentTimer.start();
+    }
+}
+
+/*
+ * Parses a job that was read from disk before. This happens in the GUI
+ * thread, which may parse jobs of its own at any time, one job per idle
+ * moment so that the editor stays responsive.
+ */
+void RSJobPrefetcher::createDocument()
+{
+    if ( ! isIdle ) {
+        return;
+    }
+
+    if ( fetched.isEmpty() ) {
+        prefetchNext();
+        return;
+    }
+
+    QString path = fetched.takeFirst();
+    if ( ! prefetched.contains(path) && ! openCounts.contains(path) && getRecentFiles().contains(path) ) {
+        RSToolIndex::getInstance().build();
+
+        QByteArray p = path.toUtf8();
+        try {
+            rsPrefetchedJob job;
+            job.document = new RSJobDocument(p.data());
+            job.mtime = 0;
+            job.size = 0;
+            getFileState(path, job.mtime, job.size);
+            prefetched.insert(path, job);
+        } catch (...) {
+            // the error is reported once the job is opened for real
+            failed.insert(path);
+        }
+    }
+
+    // the next job is read before it is parsed in another idle moment
+    documentTimer.start();
+}
+
+/*
+ * Creates the next missing page of the most recent prefetched job. Runs
+ * whenever the event loop has nothing else to do until there is input.
+ */
+void RSJobPrefetcher::createPage()
+{
+    if ( ! isIdle || ! isPrefetchingPages() ) {
+        pageTimer.stop();
+        return;
+    }
+
+    foreach( const QString &path, getRecentFiles() ) {
+        if ( ! prefetched.contains(path) ) {
+            continue;
+        }
+
+        rsPrefetchedJob &job = prefetched[path];
+        vector<RSTask*> tasks = job.document->getJob()->getTasks();
+        if ( job.pages.size() >= (int)tasks.size() ) {
+            continue;
+        }
+
+        RSTask *task = tasks[job.pages.size()];
+        rsToolIndexEntry* entry = RSToolIndex::getInstance().findEntry(task->getCode());
+        if ( entry == NULL ) {
+            // the window reports the unknown tool when the job is opened
+            continue;
+        }
+
+        job.pages << new TaskWidget(task, entry->ui, job.document);
+        return;
+    }
+
+    pageTimer.stop();
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,111 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobprefetcher_h
+#define rstools_rsbatch_jobeditor_rsjobprefetcher_h
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include "rsjobdocument.h"
+
+class TaskWidget;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Reads a job file and its binary copy into the page cache in the
+ * background. The job is parsed in the GUI thread afterwards, as neither
+ * the parser nor the task factory are known to be thread-safe.
+ */
+class RSJobPrefetchThread : public QThread
+{
+public:
+    RSJobPrefetchThread(const QString &path, const QString &cachePath, QObject *parent = 0);
+
+    QString getPath();
+    bool isReadable();
+
+protected:
+    void run();
+
+    QString path;
+    QString cachePath;
+    bool readable;
+};
+
+typedef struct {
+    RSJobDocument *document;
+    QList<TaskWidget*> pages;   // the first pages of its tasks, if any
+    qint64 mtime;               // of the job file when it was read
+    qint64 size;
+} rsPrefetchedJob;
+
+/*
+ * The list of recently opened jobs, shared by all windows. Whenever the
+ * editor has not seen any input for a while, the recent jobs that are not
+ * open are read from disk in a low priority thread, one at a time, then
+ * parsed in an idle moment of the GUI thread and kept until they are
+ * opened again, they change or the memory limit is reached. If
+ * enabled, the pages of their tasks are created as well, one per idle
+ * moment, so that opening such a job only has to show them.
+ */
+class RSJobPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    static RSJobPrefetcher& getInstance();
+
+    QStringList getRecentFiles();
+    void addRecentFile(const QString &path);
+
+    void documentOpened(const QString &path);
+    void documentClosed(const QString &path);
+    RSJobDocument* take(const QString &path, QList<TaskWidget*> &pages);
+
+    int getMemoryLimit();
+    bool isPrefetchingPages();
+
+    static const int maxRecentFiles = 8;
+    static const int idleDelay = 3000;     // ms without input
+
+signals:
+    void recentFilesChanged();
+
+protected slots:
+    void idle();
+    void threadFinished();
+    void createDocument();
+    void createPage();
+    void clear();
+
+protected:
+    RSJobPrefetcher();
+    ~RSJobPrefetcher();
+
+    bool eventFilter(QObject *watched, QEvent *event);
+
+    void prefetchNext();
+    void discard(const QString &path);
+
+    static QString normalize(const QString &path);
+    static bool getFileState(const QString &path, qint64 &mtime, qint64 &size);
+
+    QHash<QString, rsPrefetchedJob> prefetched;
+    QHash<QString, int> openCounts;
+    QSet<QString> failed;
+    QStringList fetched;        // read from disk, waiting to be parsed
+    RSJobPrefetchThread *worker;
+    QTimer idleTimer;
+    QTimer documentTimer;
+    QTimer pageTimer;
+    bool isIdle;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,643 @@
+#include "rsjobrunqueue.h"
+#include "rsjobutils.h"
+#include "rsrunhistory.h"
+#include "utils/rsstring.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+#include <QProcessEnvironment>
+#include <stdexcept>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobRunQueue& RSJobRunQueue::getInstance()
+{
+    static RSJobRunQueue instance;
+    return instance;
+}
+
+RSJobRunQueue::RSJobRunQueue() : QObject(0)
+{
+    nextId = 1;
+    
+    // output is announced in batches, not for every chunk that is read
+    notificationTimer.setSingleShot(true);
+    notificationTimer.setInterval(100);
+    connect(&notificationTimer, SIGNAL(timeout()), this, SLOT(flushNotifications()));
+
+    // resource usage of the running tasks for the run history
+    sampleTimer.setInterval(500);
+    connect(&sampleTimer, SIGNAL(timeout()), this, SLOT(sampleProcesses()));
+}
+
+RSJobRunQueue::~RSJobRunQueue()
+{
+    for (QHash<QProcess*, rsRunQueueJob*>::iterator it = processes.begin(); it != processes.end(); ++it) {
+        it.key()->kill();
+        it.key()->waitForFinished(1000);
+    }
+    for (QHash<RSTaskCacheCheck*, rsRunQueueJob*>::iterator it = checks.begin(); it != checks.end(); ++it) {
+        it.key()->wait();
+    }
+    foreach( rsRunQueueJob *job, jobs ) {
+        if ( job->ownsFile ) {
+            QFile::remove(job->path);
+        }
+    }
+}
+
+qint64 RSJobRunQueue::getPhysicalMemory()
+{
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if ( pages <= 0 || pageSize <= 0 ) {
+        return 0;
+    }
+    return (qint64)pages * (qint64)pageSize / (1024 * 1024);
+}
+
+int RSJobRunQueue::getMaxJobs()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return qMax(1, settings.value("runqueue/maxJobs", QThread::idealThreadCount()).toInt());
+}
+
+void RSJobRunQueue::setMaxJobs(int maxJobs)
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("runqueue/maxJobs", qMax(1, maxJobs));
+    QTimer::singleShot(0, this, SLOT(schedule()));
+}
+
+qint64 RSJobRunQueue::getMemoryLimit()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("runqueue/memoryLimit", getPhysicalMemory() * 4 / 5).toLongLong();
+}
+
+void RSJobRunQueue::setMemoryLimit(qint64 megabytes)
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("runqueue/memoryLimit", megabytes);
+    QTimer::singleShot(0, this, SLOT(schedule()));
+}
+
+qint64 RSJobRunQueue::getDefaultMemoryEstimate()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("runqueue/defaultMemoryEstimate", 2048).toLongLong();
+}
+
+void RSJobRunQueue::setDefaultMemoryEstimate(qint64 megabytes)
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("runqueue/defaultMemoryEstimate", megabytes);
+}
+
+// The tools are parallelized with OpenMP themselves, so the cores are split
+// between the concurrently running jobs
+int RSJobRunQueue::getThreadsPerJob()
+{
+    return qMax(1, QThread::idealThreadCount() / getMaxJobs());
+}
+
+QString RSJobRunQueue::getRunnerProgram()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("runqueue/program", "rsbatch").toString();
+}
+
+// %1 is replaced with the path of the job file
+QString RSJobRunQueue::getRunnerArguments()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("runqueue/arguments", "--jobfile=%1").toString();
+}
+
+int RSJobRunQueue::getLogLines()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return qMax(100, settings.value("runqueue/logLines", 10000).toInt());
+}
+
+bool RSJobRunQueue::getSpillLogs()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("runqueue/spillLogs", false).toBool();
+}
+
+void RSJobRunQueue::setSpillLogs(bool spill)
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("runqueue/spillLogs", spill);
+}
+
+qint64 RSJobRunQueue::getUsedMemory()
+{
+    qint64 used = 0;
+    foreach( rsRunQueueJob *job, jobs ) {
+        if ( job->state == RS_RUN_RUNNING ) {
+            used += job->memoryEstimate;
+        }
+    }
+    return used;
+}
+
+int RSJobRunQueue::getRunningCount()
+{
+    int running = 0;
+    foreach( rsRunQueueJob *job, jobs ) {
+        if ( job->state == RS_RUN_RUNNING ) {
+            running++;
+        }
+    }
+    return running;
+}
+
+QList<int> RSJobRunQueue::getJobIds()
+{
+    return order;
+}
+
+rsRunQueueJob* RSJobRunQueue::getJob(int id)
+{
+    return jobs.value(id, NULL);
+}
+
+/*
+ * Adds a job file to the queue. If the queue owns the file, it removes it
+ * once the job has finished successfully or is removed from the queue.
+ */
+int RSJobRunQueue::enqueue(const QString &path, const QString &name, bool ownsFile)
+{
+    rsRunQueueJob *job = new rsRunQueueJob;
+    job->id             = nextId++;
+    job->path           = path;
+    job->ownsFile       = ownsFile;
+    job->name           = name.isEmpty() ? path : name;
+    job->state          = RS_RUN_QUEUED;
+    job->memoryEstimate = getDefaultMemoryEstimate();
+    job->currentTask    = 0;
+    job->taskCount      = 0;
+    job->exitCode       = 0;
+    job->process        = NULL;
+    job->elapsed        = 0;
+    job->taskCpuTime    = 0;
+    job->taskPeakMemory = 0;
+    job->cacheCheck     = NULL;
+    job->reusedTasks    = 0;
+    job->log            = new RSLogBuffer(getLogLines());
+
+    jobs.insert(job->id, job);
+    order.append(job->id);
+
+    emit jobAdded(job->id);
+    QTimer::singleShot(0, this, SLOT(schedule()));
+
+    return job->id;
+}
+
+void RSJobRunQueue::cancel(int id)
+{
+    rsRunQueueJob *job = getJob(id);
+    if ( job == NULL ) {
+        return;
+    }
+
+    if ( job->state == RS_RUN_QUEUED ) {
+        finish(job, RS_RUN_CANCELLED);
+    } else if ( job->state == RS_RUN_RUNNING ) {
+        finish(job, RS_RUN_CANCELLED);
+        if ( job->process != NULL ) {
+            job->process->kill();
+        }
+    }
+}
+
+void RSJobRunQueue::clearFinished()
+{
+    QList<int> remaining;
+    foreach( int id, order ) {
+        rsRunQueueJob *job = jobs.value(id);
+        if ( job->state == RS_RUN_QUEUED || job->state == RS_RUN_RUNNING || job->process != NULL || job->cacheCheck != NULL ) {
+            remaining.append(id);
+        } else {
+            jobs.remove(id);
+            if ( job->ownsFile ) {
+                QFile::remove(job->path);
+            }
+            delete job->log;
+            delete job;
+        }
+    }
+    order = remaining;
+}
+
+/*
+ * Starts queued jobs in order as long as there are free job slots. Jobs
+ * whose memory estimate does not fit anymore are skipped in favor of
+ * smaller ones further down the queue, a single job is always allowed to
+ * run though.
+ */
+void RSJobRunQueue::schedule()
+{
+    const int maxJobs = getMaxJobs();
+    const qint64 memoryLimit = getMemoryLimit();
+
+    int running = getRunningCount();
+    qint64 used = getUsedMemory();
+
+    foreach( int id, order ) {
+        if ( running >= maxJobs ) {
+            break;
+        }
+
+        rsRunQueueJob *job = jobs.value(id);
+        if ( job->state != RS_RUN_QUEUED ) {
+            continue;
+        }
+
+        if ( running > 0 && used + job->memoryEstimate > memoryLimit ) {
+            continue;
+        }
+
+        start(job);
+
+        if ( job->state == RS_RUN_RUNNING ) {
+            running++;
+            used += job->memoryEstimate;
+        }
+    }
+}
+
+/*
+ * Splits the job into single-task jobs within a temporary directory. The
+ * single-task jobs are files once written, so the parsed job and all the
+ * jobs built from it are released again before the job starts.
+ */
+bool RSJobRunQueue::prepare(rsRunQueueJob *job)
+{
+    RSJobParser *parser = NULL;
+    RSJob *source = NULL;
+    RSJobParser *taskParser = NULL;
+    RSJob *taskJob = NULL;
+    bool prepared = false;
+
+    try {
+        QByteArray path = job->path.toLocal8Bit();
+        parser = new RSJobParser(rsString(path.data()));
+        parser->parse();
+        source = parser->getJob();
+
+        QByteArray directoryTemplate = (QDir::tempPath() + QString("/rsjobeditor-run-XXXXXX")).toLocal8Bit();
+        char *directory = mkdtemp(directoryTemplate.data());
+        if ( directory == NULL ) {
+            throw runtime_error("Could not create a temporary directory for the job");
+        }
+        job->workDirectory = QString::fromLocal8Bit(directory);
+
+        if ( getSpillLogs() ) {
+            job->log->spillTo(job->workDirectory + QString(".log"));
+        }
+
+        vector<RSTask*> tasks = source->getTasks();
+        for ( size_t i=0; i<tasks.size(); i++ ) {
+            taskJob = rsJobCopyForTask(source, tasks[i], taskParser);
+            QString file = job->workDirectory + QString("/%1-%2.job")
+                .arg((int)i+1, 3, 10, QChar('0'))
+                .arg(QString(tasks[i]->getCode()));
+            QByteArray f = file.toLocal8Bit();
+            rsJobWriteFile(taskJob, f.data());
+            delete taskJob;
+            delete taskParser;
+            taskJob = NULL;
+            taskParser = NULL;
+            job->taskJobs << file;
+            job->taskCodes << QString(tasks[i]->getCode());
+            job->taskDescriptors << RSTaskCache::describe(source, tasks[i]);
+        }
+        job->taskCount = (int)tasks.size();
+
+        // a known peak memory replaces the default estimate for the
+        // remaining scheduling decisions
+        qint64 peakMemory = 0;
+        bool predicted = job->taskCount > 0;
+        foreach( const QString &code, job->taskCodes ) {
+            rsRunPrediction prediction;
+            if ( ! RSRunHistory::getInstance().predict(code, prediction) ) {
+                predicted = false;
+                break;
+            }
+            peakMemory = qMax(peakMemory, prediction.peakMemory);
+        }
+        if ( predicted ) {
+            job->memoryEstimate = qMax((qint64)1, peakMemory * 5 / 4 / 1024);
+        }
+
+        prepared = true;
+    } catch (const exception& e) {
+        job->message = QString::fromUtf8(e.what());
+    } catch (...) {
+        job->message = tr("Unknown error while preparing the job");
+    }
+
+    delete taskJob;
+    delete taskParser;
+    delete source;
+    delete parser;
+
+    return prepared;
+}
+
+void RSJobRunQueue::start(rsRunQueueJob *job)
+{
+    job->state = RS_RUN_RUNNING;
+    job->timer.start();
+
+    if ( ! prepare(job) ) {
+        finish(job, RS_RUN_FAILED);
+        return;
+    }
+
+    if ( job->taskCount == 0 ) {
+        finish(job, RS_RUN_FINISHED);
+        return;
+    }
+
+    job->currentTask = 0;
+    startTask(job);
+    emit jobChanged(job->id);
+}
+
+/*
+ * Looks the task up in the result cache first (in the background, as the
+ * input files have to be hashed) unless caching is turned off.
+ */
+void RSJobRunQueue::startTask(rsRunQueueJob *job)
+{
+    job->taskKey = QString();
+
+    if ( ! RSTaskCache::getInstance().isEnabled() ) {
+        launchTask(job);
+        return;
+    }
+
+    QList<rsTaskCacheDescriptor> tasks;
+    tasks << job->taskDescriptors.at(job->currentTask);
+
+    job->cacheCheck = new RSTaskCacheCheck(tasks, false, this);
+    checks.insert(job->cacheCheck, job);
+    connect(job->cacheCheck, SIGNAL(finished()), this, SLOT(cacheChecked()));
+    job->cacheCheck->start();
+}
+
+void RSJobRunQueue::cacheChecked()
+{
+    RSTaskCacheCheck *check = (RSTaskCacheCheck*)sender();
+    rsRunQueueJob *job = checks.take(check);
+    check->deleteLater();
+
+    if ( job == NULL ) {
+        return;
+    }
+
+    job->cacheCheck = NULL;
+
+    if ( job->state != RS_RUN_RUNNING ) {
+        return;
+    }
+
+    rsTaskCacheResult result = check->getResults().first();
+
+    if ( result.hit ) {
+        job->reusedTasks++;
+        addOutput(job, QStringList() << tr("Task %1 (%2) skipped: %3")
+            .arg(job->currentTask + 1)
+            .arg(job->taskCodes.at(job->currentTask))
+            .arg(result.reason));
+        nextTask(job);
+        return;
+    }
+
+    job->taskKey = result.key;
+    launchTask(job);
+}
+
+void RSJobRunQueue::nextTask(rsRunQueueJob *job)
+{
+    job->currentTask++;
+
+    if ( job->currentTask < job->taskCount ) {
+        startTask(job);
+        emit jobChanged(job->id);
+    } else {
+        finish(job, RS_RUN_FINISHED);
+    }
+}
+
+void RSJobRunQueue::launchTask(rsRunQueueJob *job)
+{
+    QProcess *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("OMP_NUM_THREADS", QString::number(getThreadsPerJob()));
+    process->setProcessEnvironment(environment);
+
+    connect(process, SIGNAL(readyReadStandardOutput()), this, SLOT(readOutput()));
+    connect(process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(processFinished(int, QProcess::ExitStatus)));
+    connect(process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(processError(QProcess::ProcessError)));
+
+    job->process = process;
+    processes.insert(process, job);
+
+    job->taskCpuTime = 0;
+    job->taskPeakMemory = 0;
+    job->taskTimer.start();
+    if ( ! sampleTimer.isActive() ) {
+        sampleTimer.start();
+    }
+
+    QStringList arguments;
+    foreach( const QString &argument, getRunnerArguments().split(' ', QString::SkipEmptyParts) ) {
+        arguments << QString(argument).replace("%1", job->taskJobs.at(job->currentTask));
+    }
+
+    process->start(getRunnerProgram(), arguments);
+}
+
+void RSJobRunQueue::readOutput()
+{
+    QProcess *process = (QProcess*)sender();
+    rsRunQueueJob *job = processes.value(process, NULL);
+
+    if ( job != NULL ) {
+        collectOutput(job, process, false);
+    }
+}
+
+/*
+ * Moves complete lines (or, once the process is done, everything) from
+ * the process into the job's log buffer.
+ */
+void RSJobRunQueue::collectOutput(rsRunQueueJob *job, QProcess *process, bool all)
+{
+    QStringList lines;
+
+    while ( process->canReadLine() ) {
+        lines << QString::fromLocal8Bit(process->readLine()).trimmed();
+    }
+
+    if ( all && process->bytesAvailable() > 0 ) {
+        lines << QString::fromLocal8Bit(process->readAll()).trimmed();
+    }
+
+    if ( ! lines.isEmpty() ) {
+        addOutput(job, lines);
+    }
+}
+
+void RSJobRunQueue::addOutput(rsRunQueueJob *job, const QStringList &lines)
+{
+    job->log->append(lines);
+
+    for ( int i=lines.size()-1; i>=0; i-- ) {
+        if ( ! lines.at(i).isEmpty() ) {
+            job->lastLine = lines.at(i);
+            break;
+        }
+    }
+
+    pendingNotifications.insert(job->id);
+    if ( ! notificationTimer.isActive() ) {
+        notificationTimer.start();
+    }
+}
+
+void RSJobRunQueue::flushNotifications()
+{
+    QSet<int> ids = pendingNotifications;
+    pendingNotifications.clear();
+
+    foreach( int id, ids ) {
+        if ( jobs.contains(id) ) {
+            emit jobOutput(id);
+            emit jobChanged(id);
+        }
+    }
+}
+
+/*
+ * The values can only be read while the process is alive, so the last
+ * sample taken before a task ends is what goes into the history.
+ */
+void RSJobRunQueue::sampleProcesses()
+{
+    if ( processes.isEmpty() ) {
+        sampleTimer.stop();
+        return;
+    }
+
+    for (QHash<QProcess*, rsRunQueueJob*>::iterator it = processes.begin(); it != processes.end(); ++it) {
+        pid_t pid = (pid_t)it.key()->pid();
+        if ( pid > 0 ) {
+            RSRunHistory::sampleProcess(pid, it.value()->taskCpuTime, it.value()->taskPeakMemory);
+        }
+    }
+}
+
+void RSJobRunQueue::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess *process = (QProcess*)sender();
+    rsRunQueueJob *job = processes.take(process);
+    process->deleteLater();
+
+    if ( job == NULL ) {
+        return;
+    }
+
+    job->process = NULL;
+    collectOutput(job, process, true);
+
+    if ( job->state != RS_RUN_RUNNING ) {
+        return;
+    }
+
+    job->exitCode = exitCode;
+
+    if ( exitStatus != QProcess::NormalExit || exitCode != 0 ) {
+        job->message = exitStatus == QProcess::NormalExit
+            ? tr("Task %1 failed").arg(job->currentTask + 1)
+            : tr("Task %1 crashed").arg(job->currentTask + 1);
+        finish(job, RS_RUN_FAILED);
+        return;
+    }
+
+    RSRunHistory::getInstance().record(
+        job->taskCodes.at(job->currentTask),
+        job->taskTimer.elapsed(),
+        job->taskCpuTime,
+        job->taskPeakMemory
+    );
+
+    if ( ! job->taskKey.isEmpty() ) {
+        RSTaskCache::getInstance().store(job->taskKey, job->taskDescriptors.at(job->currentTask));
+    }
+
+    nextTask(job);
+}
+
+void RSJobRunQueue::processError(QProcess::ProcessError error)
+{
+    // all other errors are followed by finished()
+    if ( error != QProcess::FailedToStart ) {
+        return;
+    }
+
+    QProcess *process = (QProcess*)sender();
+    rsRunQueueJob *job = processes.take(process);
+    process->deleteLater();
+
+    if ( job == NULL ) {
+        return;
+    }
+
+    job->process = NULL;
+    job->message = tr("Could not start '%1'").arg(getRunnerProgram());
+
+    if ( job->state == RS_RUN_RUNNING ) {
+        finish(job, RS_RUN_FAILED);
+    }
+}
+
+void RSJobRunQueue::finish(rsRunQueueJob *job, rsRunState state)
+{
+    job->state = state;
+    job->elapsed = job->timer.isValid() ? job->timer.elapsed() : 0;
+
+    // the single-task jobs are kept for inspection if something went wrong
+    if ( state == RS_RUN_FINISHED && ! job->workDirectory.isEmpty() ) {
+        foreach( const QString &file, job->taskJobs ) {
+            QFile::remove(file);
+        }
+        QDir().rmdir(job->workDirectory);
+    }
+    if ( state == RS_RUN_FINISHED && job->ownsFile ) {
+        QFile::remove(job->path);
+    }
+
+    emit jobChanged(job->id);
+    QTimer::singleShot(0, this, SLOT(schedule()));
+}
+
+}}} // namespace rstools::batch::util
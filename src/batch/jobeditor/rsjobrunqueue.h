@@ -0,0 +1,133 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobrunqueue_h
+#define rstools_rsbatch_jobeditor_rsjobrunqueue_h
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTimer>
+#include "rslogbuffer.h"
+#include "rstaskcache.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef enum {
+    RS_RUN_QUEUED,
+    RS_RUN_RUNNING,
+    RS_RUN_FINISHED,
+    RS_RUN_FAILED,
+    RS_RUN_CANCELLED
+} rsRunState;
+
+typedef struct {
+    int id;
+    QString path;            // job file that is executed
+    bool ownsFile;           // the job file is a temporary copy of the queue
+    QString name;            // what is shown to the user
+    rsRunState state;
+    qint64 memoryEstimate;   // in MB
+    int currentTask;
+    int taskCount;
+    int exitCode;
+    QString lastLine;
+    RSLogBuffer *log;
+    QString message;
+    QString workDirectory;
+    QStringList taskJobs;    // one single-task job file per task
+    QStringList taskCodes;   // tool code of every task
+    QList<rsTaskCacheDescriptor> taskDescriptors;
+    QString taskKey;         // cache key of the running task, if any
+    RSTaskCacheCheck *cacheCheck;
+    int reusedTasks;
+    QProcess *process;
+    QElapsedTimer timer;
+    qint64 elapsed;          // in ms, once the job is done
+    QElapsedTimer taskTimer;
+    qint64 taskCpuTime;      // in ms, as last sampled
+    qint64 taskPeakMemory;   // in kB, as last sampled
+} rsRunQueueJob;
+
+/*
+ * Executes saved jobs as child processes of the RSTools batch runner. Every
+ * task is run as a single-task job of its own, so that the progress of a
+ * job is known. The number of concurrently running jobs as well as their
+ * summed up memory estimate are limited.
+ */
+class RSJobRunQueue : public QObject
+{
+    Q_OBJECT
+public:
+    static RSJobRunQueue& getInstance();
+
+    int enqueue(const QString &path, const QString &name = QString(), bool ownsFile = false);
+    void cancel(int id);
+    void clearFinished();
+
+    QList<int> getJobIds();
+    rsRunQueueJob* getJob(int id);
+
+    int getMaxJobs();
+    void setMaxJobs(int maxJobs);
+    qint64 getMemoryLimit();
+    void setMemoryLimit(qint64 megabytes);
+    qint64 getDefaultMemoryEstimate();
+    void setDefaultMemoryEstimate(qint64 megabytes);
+    int getThreadsPerJob();
+    int getLogLines();
+    bool getSpillLogs();
+    void setSpillLogs(bool spill);
+
+    QString getRunnerProgram();
+    QString getRunnerArguments();
+
+    qint64 getUsedMemory();
+    int getRunningCount();
+
+    static qint64 getPhysicalMemory();
+
+signals:
+    void jobAdded(int id);
+    void jobChanged(int id);
+    void jobOutput(int id);
+
+protected slots:
+    void schedule();
+    void readOutput();
+    void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void processError(QProcess::ProcessError error);
+    void flushNotifications();
+    void sampleProcesses();
+    void cacheChecked();
+
+protected:
+    RSJobRunQueue();
+    ~RSJobRunQueue();
+
+    bool prepare(rsRunQueueJob *job);
+    void start(rsRunQueueJob *job);
+    void startTask(rsRunQueueJob *job);
+    void launchTask(rsRunQueueJob *job);
+    void nextTask(rsRunQueueJob *job);
+    void finish(rsRunQueueJob *job, rsRunState state);
+    void collectOutput(rsRunQueueJob *job, QProcess *process, bool all);
+    void addOutput(rsRunQueueJob *job, const QStringList &lines);
+
+    QList<int> order;
+    QHash<int, rsRunQueueJob*> jobs;
+    QHash<QProcess*, rsRunQueueJob*> processes;
+    QHash<RSTaskCacheCheck*, rsRunQueueJob*> checks;
+    QSet<int> pendingNotifications;
+    QTimer notificationTimer;
+    QTimer sampleTimer;
+    int nextId;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,64 @@
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobSnapshot::RSJobSnapshot()
+{
+    revision = -1;
+}
+
+bool RSJobSnapshot::isNull() const
+{
+    return revision < 0;
+}
+
+qint64 RSJobSnapshot::getRevision() const
+{
+    return revision;
+}
+
+QString RSJobSnapshot::getPath() const
+{
+    return path;
+}
+
+QList<rsArgumentSnapshot> RSJobSnapshot::getArguments() const
+{
+    if ( arguments.isNull() ) {
+        return QList<rsArgumentSnapshot>();
+    }
+    return *arguments;
+}
+
+// Job arguments by key, as RSArgumentResolver takes them
+QHash<QString, QString> RSJobSnapshot::getArgumentValues() const
+{
+    QHash<QString, QString> values;
+    if ( arguments.isNull() ) {
+        return values;
+    }
+
+    foreach( const rsArgumentSnapshot &argument, *arguments ) {
+        values.insert(argument.key, argument.value);
+    }
+    return values;
+}
+
+int RSJobSnapshot::getTaskCount() const
+{
+    return tasks.size();
+}
+
+const rsTaskSnapshot& RSJobSnapshot::getTask(int index) const
+{
+    return *tasks.at(index);
+}
+
+rsTaskSnapshotPointer RSJobSnapshot::getTaskPointer(int index) const
+{
+    return tasks.at(index);
+}
+
+}}} // namespace rstools::batch::util
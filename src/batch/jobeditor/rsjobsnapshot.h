@@ -0,0 +1,65 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobsnapshot_h
+#define rstools_rsbatch_jobeditor_rsjobsnapshot_h
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    QString key;
+    QString value;
+    bool hasValue;           // false for flags
+} rsArgumentSnapshot;
+
+typedef struct {
+    QString code;
+    QString description;
+    QList<rsArgumentSnapshot> arguments;
+    QByteArray hash;         // of all of the above, see RSJobDiff
+} rsTaskSnapshot;
+
+typedef QSharedPointer<const rsTaskSnapshot> rsTaskSnapshotPointer;
+typedef QSharedPointer<const QList<rsArgumentSnapshot> > rsArgumentsSnapshotPointer;
+
+/*
+ * Immutable copy of a job as it was at one revision of its RSJobDocument.
+ * Tasks that did not change between two revisions are shared by their
+ * snapshots, so taking one only copies what was edited since the last one
+ * and copying a snapshot only copies pointers. Snapshots hold no reference
+ * to the job itself and may be read from any thread.
+ */
+class RSJobSnapshot
+{
+public:
+    RSJobSnapshot();
+
+    bool isNull() const;
+    qint64 getRevision() const;
+    QString getPath() const;
+
+    QList<rsArgumentSnapshot> getArguments() const;
+    QHash<QString, QString> getArgumentValues() const;
+
+    int getTaskCount() const;
+    const rsTaskSnapshot& getTask(int index) const;
+    rsTaskSnapshotPointer getTaskPointer(int index) const;
+
+protected:
+    friend class RSJobDocument;
+    friend class RSJobMerge;
+
+    qint64 revision;
+    QString path;
+    rsArgumentsSnapshotPointer arguments;
+    QList<rsTaskSnapshotPointer> tasks;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
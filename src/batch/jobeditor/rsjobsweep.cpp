@@ -0,0 +1,437 @@
+#include "rsjobsweep.h"
+#include "rsargumentresolver.h"
+#include "rsjobtemplate.h"
+#include "rsjobutils.h"
+#include "rstoolindex.h"
+#include "rsuioptionutils.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <glib.h>
+#include <math.h>
+#include <stdexcept>
+#include <string.h>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+static bool isOutput(rsUIInterface* I, const QString& key)
+{
+    QByteArray k = key.toUtf8();
+    for ( size_t i=0; i<I->nOptions; i++ ) {
+        if ( strcmp(I->options[i]->name, k.data()) == 0 ) {
+            return rsUIOptionIsOutput(I->options[i]);
+        }
+    }
+    return false;
+}
+
+// Sets the first argument with the key, adding it if there is none
+static void setValue(QList<rsArgumentSnapshot>& arguments, const QString& key, const QString& value)
+{
+    for ( int i=0; i<arguments.size(); i++ ) {
+        if ( arguments[i].key == key ) {
+            arguments[i].value = value;
+            arguments[i].hasValue = true;
+            return;
+        }
+    }
+
+    rsArgumentSnapshot argument;
+    argument.key = key;
+    argument.value = value;
+    argument.hasValue = true;
+    arguments << argument;
+}
+
+RSJobSweep::RSJobSweep(const RSJobSnapshot &job)
+{
+    this->job = job;
+    sampleSize = 0;
+    seed = 1;
+}
+
+void RSJobSweep::addDimension(const rsSweepDimension &dimension)
+{
+    QByteArray key = dimension.key.toUtf8();
+
+    if ( dimension.key.isEmpty() ) {
+        throw runtime_error("An argument to sweep has no name");
+    }
+    if ( dimension.task < -1 || dimension.task >= job.getTaskCount() ) {
+        throw runtime_error(string("The job has no task ") + QString::number(dimension.task + 1).toUtf8().data() + string(" to sweep '") + key.data() + string("' in"));
+    }
+    if ( dimension.values.isEmpty() ) {
+        throw runtime_error(string("No values were given for '") + key.data() + string("'"));
+    }
+    if ( isSwept(dimension.task, dimension.key) ) {
+        throw runtime_error(string("The argument '") + key.data() + string("' is swept twice"));
+    }
+    foreach( const QString &value, dimension.values ) {
+        checkPlaceholders(value, QString("a value of '%1'").arg(dimension.key));
+    }
+
+    // the combinations are numbered by a qint64 and sampled by that number
+    qint64 combinations = dimension.values.size();
+    foreach( const rsSweepDimension &other, dimensions ) {
+        combinations *= other.values.size();
+        if ( combinations > maxCombinations ) {
+            throw runtime_error(
+                string("The sweep has more than ") + QString::number(maxCombinations).toUtf8().data()
+                + string(" combinations, please sweep fewer values")
+            );
+        }
+    }
+
+    dimensions << dimension;
+}
+
+QList<rsSweepDimension> RSJobSweep::getDimensions() const
+{
+    return dimensions;
+}
+
+// At most maxCombinations, addDimension() refuses more
+qint64 RSJobSweep::getCombinationCount() const
+{
+    if ( dimensions.isEmpty() ) {
+        return 0;
+    }
+
+    qint64 result = 1;
+    foreach( const rsSweepDimension &dimension, dimensions ) {
+        result *= dimension.values.size();
+    }
+    return result;
+}
+
+/*
+ * Generates a random sample of the given size instead of all combinations,
+ * the same seed always picks the same combinations. 0 for all of them.
+ */
+void RSJobSweep::setSampleSize(int size, unsigned int seed)
+{
+    sampleSize = qMax(0, size);
+    this->seed = seed;
+}
+
+qint64 RSJobSweep::getVariantCount() const
+{
+    const qint64 combinations = getCombinationCount();
+    return sampleSize > 0 ? qMin((qint64)sampleSize, combinations) : combinations;
+}
+
+bool RSJobSweep::isSwept(int task, const QString &key) const
+{
+    foreach( const rsSweepDimension &dimension, dimensions ) {
+        if ( dimension.task == task && dimension.key == key ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The values of the swept arguments for every variant, in order of the combinations
+QList<QStringList> RSJobSweep::expand() const
+{
+    const qint64 combinations = getCombinationCount();
+    const qint64 count = getVariantCount();
+
+    if ( count > maxVariants ) {
+        throw runtime_error(
+            string("The sweep has ") + QString::number(count).toUtf8().data()
+            + string(" variants, but at most ") + QString::number(maxVariants).toUtf8().data()
+            + string(" can be generated. Please sample a subset of them.")
+        );
+    }
+
+    QList<qint64> indices;
+    if ( count == combinations ) {
+        for ( qint64 i=0; i<count; i++ ) {
+            indices << i;
+        }
+    } else {
+        // Floyd's algorithm draws distinct combinations without listing all of them
+        QSet<qint64> chosen;
+        GRand *random = g_rand_new_with_seed(seed);
+        for ( qint64 j=combinations-count; j<combinations; j++ ) {
+            const qint64 t = qMin(j, (qint64)g_rand_double_range(random, 0, (gdouble)(j + 1)));
+            chosen.insert(chosen.contains(t) ? j : t);
+        }
+        g_rand_free(random);
+
+        indices = chosen.toList();
+        qSort(indices);
+    }
+
+    // the last dimension changes fastest
+    QList<QStringList> result;
+    foreach( qint64 index, indices ) {
+        QStringList values;
+        for ( int d=dimensions.size()-1; d>=0; d-- ) {
+            const QStringList &v = dimensions[d].values;
+            values.prepend(v[(int)(index % v.size())]);
+            index /= v.size();
+        }
+        result << values;
+    }
+
+    return result;
+}
+
+// RSJobTemplate would take "{{" for the start of a placeholder
+void RSJobSweep::checkPlaceholders(const QString &text, const QString &where)
+{
+    if ( text.contains(QString("{{")) ) {
+        throw runtime_error(
+            string("'{{' in ") + where.toUtf8().data() + string(" cannot be written by a sweep: '")
+            + text.toUtf8().data() + string("'")
+        );
+    }
+}
+
+/*
+ * Numbered so that the variants sort in the order they were generated,
+ * followed by the swept values. Paths only contribute their file name.
+ */
+QString RSJobSweep::variantName(int index, int count, const QStringList &values) const
+{
+    QString name = QString("%1").arg(index + 1, QString::number(count).size(), 10, QChar('0'));
+
+    for ( int d=0; d<dimensions.size(); d++ ) {
+        QString value = values[d].mid(values[d].lastIndexOf('/') + 1).left(40);
+        QString part = dimensions[d].key + QString("-") + value;
+        for ( int i=0; i<part.size(); i++ ) {
+            if ( ! part[i].isLetterOrNumber() && part[i] != QChar('.') && part[i] != QChar('-') ) {
+                part[i] = QChar('_');
+            }
+        }
+        name += QString("_") + part;
+    }
+
+    return name;
+}
+
+/*
+ * The job with a {{sweepN}} placeholder for every swept argument and
+ * every output file moved into a {{variant}} directory next to it.
+ * Outputs are written resolved, so that an output directory given as a
+ * job argument is split correctly. Arguments of later tasks that read one
+ * of the outputs are moved along with it.
+ */
+void RSJobSweep::createTemplate(QList<rsArgumentSnapshot> &arguments, QList<rsTaskSnapshot> &tasks, QStringList &outputDirectories) const
+{
+    arguments = job.getArguments();
+    tasks.clear();
+    for ( int i=0; i<job.getTaskCount(); i++ ) {
+        tasks << job.getTask(i);
+    }
+
+    foreach( const rsArgumentSnapshot &argument, arguments ) {
+        checkPlaceholders(argument.key, QString("the job arguments"));
+        checkPlaceholders(argument.value, QString("the job arguments"));
+    }
+    for ( int t=0; t<tasks.size(); t++ ) {
+        const QString where = QString("task %1").arg(t + 1);
+        checkPlaceholders(tasks[t].code, where);
+        checkPlaceholders(tasks[t].description, where);
+        foreach( const rsArgumentSnapshot &argument, tasks[t].arguments ) {
+            checkPlaceholders(argument.key, where);
+            checkPlaceholders(argument.value, where);
+        }
+    }
+
+    RSArgumentResolver resolver;
+    resolver.update(job.getArgumentValues());
+
+    // resolved output paths and where they were moved to
+    QHash<QString, QString> movedOutputs;
+
+    for ( int t=0; t<tasks.size(); t++ ) {
+        QByteArray code = tasks[t].code.toUtf8();
+        rsToolIndexEntry* entry = RSToolIndex::getInstance().findEntry(code.data());
+        rsUIInterface* I = entry == NULL ? NULL : entry->ui;
+        if ( I == NULL ) {
+            continue;
+        }
+
+        for ( int a=0; a<tasks[t].arguments.size(); a++ ) {
+            rsArgumentSnapshot &argument = tasks[t].arguments[a];
+            if ( ! argument.hasValue || argument.value.isEmpty() || isSwept(t, argument.key) || ! isOutput(I, argument.key) ) {
+                continue;
+            }
+
+            const QString path = resolver.resolve(argument.value);
+            const int slash = path.lastIndexOf('/');
+            outputDirectories << (slash < 0 ? QString(".") : slash == 0 ? QString("/") : path.left(slash));
+            argument.value = path.left(slash + 1) + QString("{{variant}}/") + path.mid(slash + 1);
+            movedOutputs.insert(path, argument.value);
+        }
+    }
+    outputDirectories.removeDuplicates();
+
+    // inputs that refer to an output have to follow it into the variant
+    for ( int t=0; t<tasks.size() && ! movedOutputs.isEmpty(); t++ ) {
+        for ( int a=0; a<tasks[t].arguments.size(); a++ ) {
+            rsArgumentSnapshot &argument = tasks[t].arguments[a];
+            if ( ! argument.hasValue || argument.value.isEmpty() || isSwept(t, argument.key) ) {
+                continue;
+            }
+
+            QHash<QString, QString>::const_iterator moved = movedOutputs.constFind(resolver.resolve(argument.value));
+            if ( moved != movedOutputs.constEnd() ) {
+                argument.value = moved.value();
+            }
+        }
+    }
+
+    for ( int d=0; d<dimensions.size(); d++ ) {
+        const QString placeholder = QString("{{sweep%1}}").arg(d);
+        if ( dimensions[d].task < 0 ) {
+            setValue(arguments, dimensions[d].key, placeholder);
+        } else {
+            setValue(tasks[dimensions[d].task].arguments, dimensions[d].key, placeholder);
+        }
+    }
+}
+
+/*
+ * Writes one job per variant into the directory, named after the job and
+ * the variant, and creates the output directories of every variant.
+ * Returns the paths of the written jobs.
+ */
+QStringList RSJobSweep::generate(const QString &directory)
+{
+    if ( dimensions.isEmpty() ) {
+        throw runtime_error("No arguments to sweep were given");
+    }
+
+    // the plugins have to be loaded to know which arguments are outputs
+    RSToolIndex::getInstance().build();
+
+    const QList<QStringList> variants = expand();
+
+    QList<rsArgumentSnapshot> arguments;
+    QList<rsTaskSnapshot> tasks;
+    QStringList outputDirectories;
+    createTemplate(arguments, tasks, outputDirectories);
+
+    RSJobParser *parser = NULL;
+    RSJob *templateJob = rsJobCreateFromSnapshot(arguments, tasks, parser);
+    RSJobTemplate jobTemplate;
+    jobTemplate.setJob(templateJob);
+    delete templateJob;
+    delete parser;
+
+    QStringList columns;
+    columns << QString("variant");
+    for ( int d=0; d<dimensions.size(); d++ ) {
+        columns << QString("sweep%1").arg(d);
+    }
+
+    QList<QStringList> rows;
+    for ( int i=0; i<variants.size(); i++ ) {
+        const QString name = variantName(i, variants.size(), variants[i]);
+        rows << (QStringList() << name << variants[i]);
+
+        foreach( const QString &output, outputDirectories ) {
+            const QString path = output + QString("/") + name;
+            if ( ! QDir().mkpath(path) ) {
+                throw runtime_error(string("The directory '") + path.toLocal8Bit().data() + string("' could not be created"));
+            }
+        }
+    }
+    jobTemplate.setRows(columns, rows);
+
+    QString baseName = QFileInfo(job.getPath()).completeBaseName();
+    if ( baseName.isEmpty() ) {
+        baseName = QString("job");
+    }
+    checkPlaceholders(baseName, QString("the name of the job"));
+
+    return jobTemplate.generate(directory, baseName + QString("_{{variant}}.job"));
+}
+
+/*
+ * Parses "TASK:KEY=VALUES" for an argument of the task with the given
+ * number, counted from 1, or "KEY=VALUES" and "job:KEY=VALUES" for a job
+ * argument. See parseValues() for the values.
+ */
+rsSweepDimension RSJobSweep::parseDimension(const QString &spec)
+{
+    const int equals = spec.indexOf('=');
+    if ( equals < 0 ) {
+        throw runtime_error(string("'") + spec.toUtf8().data() + string("' does not assign values to an argument, e.g. 2:fwhm=4,6,8"));
+    }
+
+    QString head = spec.left(equals).trimmed();
+    rsSweepDimension result;
+    result.task = -1;
+    result.key = head;
+
+    const int colon = head.indexOf(':');
+    if ( colon >= 0 ) {
+        const QString task = head.left(colon).trimmed();
+        result.key = head.mid(colon + 1).trimmed();
+
+        if ( task != QString("job") ) {
+            bool ok = false;
+            result.task = task.toInt(&ok) - 1;
+            if ( ! ok || result.task < 0 ) {
+                throw runtime_error(string("'") + task.toUtf8().data() + string("' is neither a task number nor 'job'"));
+            }
+        }
+    }
+
+    result.values = parseValues(spec.mid(equals + 1));
+    return result;
+}
+
+/*
+ * Either a comma-separated list of values or a numeric range given as
+ * START:STEP:END that includes its end, e.g. 0.01:0.01:0.05.
+ */
+QStringList RSJobSweep::parseValues(const QString &values)
+{
+    QStringList result;
+    const QStringList range = values.trimmed().split(':');
+
+    if ( range.size() == 3 ) {
+        bool okStart, okStep, okEnd;
+        const double start = range[0].toDouble(&okStart);
+        const double step = range[1].toDouble(&okStep);
+        const double end = range[2].toDouble(&okEnd);
+
+        if ( okStart && okStep && okEnd ) {
+            const double steps = step == 0 ? -1 : (end - start) / step;
+            if ( steps < 0 || steps >= maxVariants ) {
+                throw runtime_error(string("The range '") + values.toUtf8().data() + string("' does not reach its end in a sensible number of steps"));
+            }
+
+            // tolerate the rounding of steps like 0.1
+            const int n = (int)floor(steps + 1e-9) + 1;
+            for ( int i=0; i<n; i++ ) {
+                result << QString::number(start + i * step, 'g', 12);
+            }
+            return result;
+        }
+    }
+
+    foreach( const QString &value, values.split(',') ) {
+        if ( ! value.trimmed().isEmpty() ) {
+            result << value.trimmed();
+        }
+    }
+
+    if ( result.isEmpty() ) {
+        throw runtime_error(string("No values were given in '") + values.toUtf8().data() + string("'"));
+    }
+
+    return result;
+}
+
+}}} // namespace rstools::batch::util
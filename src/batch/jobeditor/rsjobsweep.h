@@ -0,0 +1,65 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobsweep_h
+#define rstools_rsbatch_jobeditor_rsjobsweep_h
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    int task;                // index of the task, -1 for a job argument
+    QString key;
+    QStringList values;
+} rsSweepDimension;
+
+/*
+ * Generates the variants of a job that differ in a few of its arguments,
+ * e.g. every combination of three smoothing kernels and four bandpass
+ * filters, or a random sample of the combinations if there are too many.
+ * The job is compiled once into an RSJobTemplate with a placeholder for
+ * every swept argument, so writing a variant only means concatenating
+ * strings. Every output file of the job is moved into a directory of the
+ * variant's own, so that the variants can run at the same time. Neither
+ * the job nor the swept values may contain "{{", which would be taken
+ * for the start of a placeholder.
+ */
+class RSJobSweep
+{
+public:
+    explicit RSJobSweep(const RSJobSnapshot &job);
+
+    void addDimension(const rsSweepDimension &dimension);
+    QList<rsSweepDimension> getDimensions() const;
+    qint64 getCombinationCount() const;
+
+    void setSampleSize(int size, unsigned int seed = 1);
+    qint64 getVariantCount() const;
+
+    QStringList generate(const QString &directory);
+
+    static rsSweepDimension parseDimension(const QString &spec);
+    static QStringList parseValues(const QString &values);
+
+    static const int maxVariants = 100000;
+    static const qint64 maxCombinations = Q_INT64_C(1) << 40;
+
+protected:
+    QList<QStringList> expand() const;
+    void createTemplate(QList<rsArgumentSnapshot> &arguments, QList<rsTaskSnapshot> &tasks, QStringList &outputDirectories) const;
+    bool isSwept(int task, const QString &key) const;
+    static void checkPlaceholders(const QString &text, const QString &where);
+    QString variantName(int index, int count, const QStringList &values) const;
+
+    RSJobSnapshot job;
+    QList<rsSweepDimension> dimensions;
+    int sampleSize;          // 0 for all combinations
+    unsigned int seed;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
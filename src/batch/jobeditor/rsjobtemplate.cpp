@@ -0,0 +1,319 @@
+#include "rsjobtemplate.h"
+#include "rstoolindex.h"
+#include "utils/rsstring.h"
+#include "batch/util/rsjobparser.hpp"
+#include <QFile>
+#include <QDir>
+#include <QSet>
+#include <stdexcept>
+#include <stdio.h>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobTemplate::RSJobTemplate()
+{
+
+}
+
+void RSJobTemplate::load(const QString& path)
+{
+    // the plugins have to be loaded before a job can be parsed
+    RSToolIndex::getInstance().build();
+
+    QByteArray p = path.toLocal8Bit();
+    RSJobParser *parser = new RSJobParser(rsString(p.data()));
+    RSJob *parsed = NULL;
+
+    try {
+        parser->parse();
+        parsed = parser->getJob();
+        setJob(parsed);
+    } catch (...) {
+        delete parsed;
+        delete parser;
+        throw;
+    }
+
+    // only the compiled XML is kept
+    delete parsed;
+    delete parser;
+}
+
+void RSJobTemplate::setJob(RSJob* job)
+{
+    char *xml = job->toXml();
+    this->job = compile(string(xml));
+    rsFree(xml);
+}
+
+rsTemplateText RSJobTemplate::compile(const string& text)
+{
+    rsTemplateText result;
+    size_t position = 0;
+
+    while ( true ) {
+        size_t start = text.find("{{", position);
+        size_t end = start == string::npos ? string::npos : text.find("}}", start + 2);
+
+        if ( end == string::npos ) {
+            result.literals.push_back(text.substr(position));
+            break;
+        }
+
+        result.literals.push_back(text.substr(position, start - position));
+        result.names.push_back(text.substr(start + 2, end - start - 2));
+        result.columns.push_back(-1);
+        position = end + 2;
+    }
+
+    return result;
+}
+
+// Looks up the column of every placeholder, unknown ones are an error
+void RSJobTemplate::bind(rsTemplateText& text)
+{
+    for ( size_t i=0; i<text.names.size(); i++ ) {
+        text.columns[i] = -1;
+        for ( size_t c=0; c<columns.size(); c++ ) {
+            if ( columns[c] == text.names[i] ) {
+                text.columns[i] = (int)c;
+                break;
+            }
+        }
+        if ( text.columns[i] < 0 ) {
+            throw runtime_error(string("The table has no column '") + text.names[i] + string("'"));
+        }
+    }
+}
+
+string RSJobTemplate::escapeXml(const string& value)
+{
+    string result;
+    result.reserve(value.size());
+    for ( size_t i=0; i<value.size(); i++ ) {
+        switch ( value[i] ) {
+            case '&':  result += "&amp;";  break;
+            case '<':  result += "&lt;";   break;
+            case '>':  result += "&gt;";   break;
+            case '"':  result += "&quot;"; break;
+            case '\'': result += "&apos;"; break;
+            default:   result += value[i];
+        }
+    }
+    return result;
+}
+
+string RSJobTemplate::expand(const rsTemplateText& text, const vector<string>& row, bool xml)
+{
+    size_t length = 0;
+    for ( size_t i=0; i<text.literals.size(); i++ ) {
+        length += text.literals[i].size();
+    }
+
+    string result;
+    result.reserve(length + 64 * text.names.size());
+
+    for ( size_t i=0; i<text.names.size(); i++ ) {
+        result += text.literals[i];
+        const int c = text.columns[i];
+        if ( c < (int)row.size() ) {
+            result += xml ? escapeXml(row[c]) : row[c];
+        }
+    }
+    result += text.literals.back();
+
+    return result;
+}
+
+/*
+ * Reads a table with a header row. Fields are separated by tabs if the
+ * header contains one and by commas otherwise, double quotes may enclose
+ * fields that contain separators, quotes or line breaks.
+ */
+void RSJobTemplate::readTable(const QString& path)
+{
+    QFile file(path);
+    if ( ! file.open(QIODevice::ReadOnly) ) {
+        throw runtime_error(string("The table '") + path.toLocal8Bit().data() + string("' could not be read"));
+    }
+    QByteArray data = file.readAll();
+
+    int headerEnd = data.indexOf('\n');
+    const char separator = data.left(headerEnd < 0 ? data.size() : headerEnd).contains('\t') ? '\t' : ',';
+
+    vector<vector<string> > table;
+    vector<string> row;
+    string field;
+    bool quoted = false;
+    bool fieldStarted = false;
+
+    for ( int i=0; i<=data.size(); i++ ) {
+        const bool atEnd = i == data.size();
+        const char c = atEnd ? '\n' : data.at(i);
+
+        if ( quoted && ! atEnd ) {
+            if ( c == '"' ) {
+                if ( i + 1 < data.size() && data.at(i + 1) == '"' ) {
+                    field += '"';
+                    i++;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field += c;
+            }
+            continue;
+        }
+
+        if ( c == '"' && field.empty() ) {
+            quoted = true;
+            fieldStarted = true;
+        } else if ( c == separator ) {
+            row.push_back(field);
+            field.clear();
+            fieldStarted = true;
+        } else if ( c == '\n' ) {
+            if ( fieldStarted || ! field.empty() || ! row.empty() ) {
+                row.push_back(field);
+                table.push_back(row);
+            }
+            row.clear();
+            field.clear();
+            fieldStarted = false;
+        } else if ( c != '\r' ) {
+            field += c;
+            fieldStarted = true;
+        }
+    }
+
+    if ( table.empty() ) {
+        throw runtime_error(string("The table '") + path.toLocal8Bit().data() + string("' is empty"));
+    }
+
+    columns = table.front();
+    for ( size_t c=0; c<columns.size(); c++ ) {
+        columns[c] = QString::fromUtf8(columns[c].c_str()).trimmed().toUtf8().data();
+    }
+    rows.assign(table.begin() + 1, table.end());
+}
+
+// Uses the given rows instead of a table, e.g. the variants of an RSJobSweep
+void RSJobTemplate::setRows(const QStringList& columns, const QList<QStringList>& rows)
+{
+    this->columns.clear();
+    foreach( const QString &column, columns ) {
+        this->columns.push_back(column.toUtf8().data());
+    }
+
+    this->rows.clear();
+    this->rows.reserve(rows.size());
+    foreach( const QStringList &row, rows ) {
+        vector<string> values;
+        foreach( const QString &value, row ) {
+            values.push_back(value.toUtf8().data());
+        }
+        this->rows.push_back(values);
+    }
+}
+
+QStringList RSJobTemplate::getPlaceholders()
+{
+    QStringList result;
+    for ( size_t i=0; i<job.names.size(); i++ ) {
+        QString name = QString::fromUtf8(job.names[i].c_str());
+        if ( ! result.contains(name) ) {
+            result << name;
+        }
+    }
+    return result;
+}
+
+QStringList RSJobTemplate::getColumns()
+{
+    QStringList result;
+    for ( size_t c=0; c<columns.size(); c++ ) {
+        result << QString::fromUtf8(columns[c].c_str());
+    }
+    return result;
+}
+
+int RSJobTemplate::getRowCount()
+{
+    return (int)rows.size();
+}
+
+/*
+ * Writes one job per row into the directory and returns the paths of the
+ * written jobs. The file name is the name pattern expanded with the row,
+ * e.g. "{{subject}}.job".
+ */
+QStringList RSJobTemplate::generate(const QString& directory, const QString& namePattern)
+{
+    if ( job.literals.empty() ) {
+        throw runtime_error("No template job has been loaded");
+    }
+
+    if ( ! QDir().mkpath(directory) ) {
+        throw runtime_error(string("The directory '") + directory.toLocal8Bit().data() + string("' could not be created"));
+    }
+
+    rsTemplateText name = compile(string(namePattern.toUtf8().data()));
+    bind(job);
+    bind(name);
+
+    const string prefix = string(QDir(directory).absolutePath().toLocal8Bit().data()) + "/";
+    const long n = (long)rows.size();
+    vector<string> paths(n);
+    vector<char> failed(n, 0);
+
+    // two rows must not end up in the same file
+    QSet<QString> unique;
+    for ( long r=0; r<n; r++ ) {
+        string fileName = expand(name, rows[r], false);
+        for ( size_t i=0; i<fileName.size(); i++ ) {
+            if ( fileName[i] == '/' ) {
+                fileName[i] = '_';
+            }
+        }
+        paths[r] = prefix + fileName;
+
+        QString path = QString::fromLocal8Bit(paths[r].c_str());
+        if ( unique.contains(path) ) {
+            throw runtime_error(string("Several rows would be written to '") + paths[r] + string("', please use a name pattern that is unique for every row"));
+        }
+        unique.insert(path);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for ( long r=0; r<n; r++ ) {
+        const string content = expand(job, rows[r], true);
+
+        FILE *f = fopen(paths[r].c_str(), "w");
+        if ( f == NULL ) {
+            failed[r] = 1;
+            continue;
+        }
+        if ( fwrite(content.data(), 1, content.size(), f) != content.size() ) {
+            failed[r] = 1;
+        }
+        if ( fclose(f) != 0 ) {
+            failed[r] = 1;
+        }
+    }
+
+    QStringList result;
+    for ( long r=0; r<n; r++ ) {
+        if ( failed[r] ) {
+            throw runtime_error(string("File '") + paths[r] + string("' could not be written. Please ensure that the proper writing permissions are granted."));
+        }
+        result << QString::fromLocal8Bit(paths[r].c_str());
+    }
+
+    return result;
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,59 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobtemplate_h
+#define rstools_rsbatch_jobeditor_rsjobtemplate_h
+
+#include <string>
+#include <vector>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "batch/util/rsjob.hpp"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+// Text split at its {{column}} placeholders: literals[i] is followed by
+// the placeholder names[i], the last literal ends the text
+typedef struct {
+    std::vector<std::string> literals;
+    std::vector<std::string> names;
+    std::vector<int> columns;
+} rsTemplateText;
+
+/*
+ * Generates one job per row of a CSV or TSV table from a template job whose
+ * arguments contain {{column}} placeholders. The template is parsed once
+ * and its XML is split at the placeholders, so that writing a job only
+ * means concatenating strings. Rows are written in parallel.
+ */
+class RSJobTemplate
+{
+public:
+    RSJobTemplate();
+
+    void load(const QString& path);
+    void setJob(RSJob* job);
+    void readTable(const QString& path);
+    void setRows(const QStringList& columns, const QList<QStringList>& rows);
+
+    QStringList getPlaceholders();
+    QStringList getColumns();
+    int getRowCount();
+
+    QStringList generate(const QString& directory, const QString& namePattern);
+
+    static std::string escapeXml(const std::string& value);
+
+protected:
+    static rsTemplateText compile(const std::string& text);
+    void bind(rsTemplateText& text);
+    static std::string expand(const rsTemplateText& text, const std::vector<std::string>& row, bool xml);
+
+    rsTemplateText job;
+    std::vector<std::string> columns;
+    std::vector<std::vector<std::string> > rows;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,183 @@
+#include "rsjobutils.h"
+#include "utils/rsstring.h"
+#include <QFile>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <tr1/unordered_map>
+
+using namespace std;
+
+RSJobParser* rsJobParseEmpty()
+{
+    RSJobParser *parser = new RSJobParser(rsString(RSTOOLS_DATA_DIR"/rstools/jobs/empty.job"));
+    parser->parse();
+    return parser;
+}
+
+static rsArgument* copyArgument(const rsArgument* argument)
+{
+    rsArgument *result = (rsArgument*)rsMalloc(sizeof(rsArgument));
+    result->key   = argument->key == NULL ? NULL : rsString(argument->key);
+    result->value = argument->value == NULL ? NULL : rsString(argument->value);
+    return result;
+}
+
+RSJob* rsJobCopyForTask(RSJob* job, RSTask* task, RSJobParser*& parser)
+{
+    RSTask *copy = RSTask::taskFactory(task->getCode());
+    if ( copy == NULL ) {
+        throw runtime_error(string("The job uses the unknown tool '") + task->getCode() + string("'."));
+    }
+
+    const char *description = task->getDescription();
+    if ( description != NULL ) {
+        char *d = (char*)malloc(sizeof(char)*(strlen(description)+1));
+        strcpy(d, description);
+        copy->setDescription(d);
+    }
+
+    vector<rsArgument*> arguments = task->getArguments();
+    for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+        copy->addArgument(copyArgument(*it));
+    }
+
+    parser = rsJobParseEmpty();
+    RSJob* result = parser->getJob();
+
+    arguments = job->getArguments();
+    for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+        result->addArgument(copyArgument(*it));
+    }
+
+    result->addTask(copy);
+
+    return result;
+}
+
+static rsArgument* createArgument(const rsArgumentSnapshot& argument)
+{
+    QByteArray key = argument.key.toUtf8();
+    QByteArray value = argument.value.toUtf8();
+
+    rsArgument *result = (rsArgument*)rsMalloc(sizeof(rsArgument));
+    result->key   = rsString(key.data());
+    result->value = argument.hasValue ? rsString(value.data()) : NULL;
+    return result;
+}
+
+RSJob* rsJobCreateFromSnapshot(const QList<rsArgumentSnapshot>& arguments, const QList<rsTaskSnapshot>& tasks, RSJobParser*& parser)
+{
+    parser = rsJobParseEmpty();
+    RSJob *job = parser->getJob();
+
+    foreach( const rsArgumentSnapshot &argument, arguments ) {
+        job->addArgument(createArgument(argument));
+    }
+
+    foreach( const rsTaskSnapshot &t, tasks ) {
+        QByteArray code = t.code.toUtf8();
+        RSTask *task = RSTask::taskFactory(code.data());
+
+        if ( task == NULL ) {
+            delete job;
+            delete parser;
+            parser = NULL;
+            throw runtime_error(string("The job uses the unknown tool '") + code.data() + string("'."));
+        }
+
+        QByteArray description = t.description.toUtf8();
+        char *copy = (char*)malloc(sizeof(char)*(description.size()+1));
+        strcpy(copy, description.data());
+        task->setDescription(copy);
+
+        foreach( const rsArgumentSnapshot &argument, t.arguments ) {
+            task->addArgument(createArgument(argument));
+        }
+
+        job->addTask(task);
+    }
+
+    return job;
+}
+
+bool rsJobPrefetchFile(const QString& path)
+{
+    QFile file(path);
+    if ( ! file.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+
+    char buffer[65536];
+    qint64 n;
+    while ( (n = file.read(buffer, sizeof(buffer))) > 0 ) {
+    }
+    return n == 0;
+}
+
+void rsJobWriteFile(RSJob* job, const char* path)
+{
+    FILE *f = fopen(path, "w");
+
+    if ( f == NULL ) {
+        throw runtime_error(string("File '") + path + string("' could not be written. Please ensure that the proper writing permissions are granted."));
+    }
+
+    char *jobXml = job->toXml();
+
+    fprintf(f, "%s", jobXml);
+    fclose(f);
+    rsFree(jobXml);
+}
+
+string rsJobResolveValue(RSJob* job, const char* value)
+{
+    if ( value == NULL ) {
+        return string();
+    }
+
+    string result(value);
+    if ( result.find("${") == string::npos ) {
+        return result;
+    }
+
+    tr1::unordered_map<string, string> arguments;
+    vector<rsArgument*> args = job->getArguments();
+    for (vector<rsArgument*>::iterator it = args.begin(); it != args.end(); ++it) {
+        if ( (*it)->key != NULL ) {
+            arguments[(*it)->key] = (*it)->value == NULL ? "" : (*it)->value;
+        }
+    }
+
+    // arguments may refer to other arguments, but not endlessly
+    for ( int depth=0; depth<8; depth++ ) {
+        bool replaced = false;
+        size_t start = 0;
+
+        while ( (start = result.find("${", start)) != string::npos ) {
+            size_t end = result.find('}', start + 2);
+            if ( end == string::npos ) {
+                break;
+            }
+
+            tr1::unordered_map<string, string>::iterator it = arguments.find(result.substr(start + 2, end - start - 2));
+            if ( it == arguments.end() ) {
+                start = end + 1;
+                continue;
+            }
+
+            result.replace(start, end - start + 1, it->second);
+            start += it->second.size();
+            replaced = true;
+        }
+
+        if ( ! replaced ) {
+            break;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobutils_h
+#define rstools_rsbatch_jobeditor_rsjobutils_h
+
+#include <string>
+#include "batch/util/rsjob.hpp"
+#include "batch/util/rstask.hpp"
+#include "batch/util/rsjobparser.hpp"
+#include "rsjobsnapshot.h"
+
+using namespace rstools::batch::util;
+
+/*
+ * Ownership of parsed jobs: RSJobParser::parse() creates the job and
+ * getJob() hands it out, but the parser never deletes it. The caller
+ * deletes the job first and its parser afterwards, as every function below
+ * that returns a parser expects.
+ */
+
+/*
+ * Creates a new job from the empty job template that holds copies of the
+ * job arguments of the given job and of the given task only. It can be
+ * deleted on its own, together with its parser, as soon as it has been
+ * written.
+ */
+RSJob* rsJobCopyForTask(RSJob* job, RSTask* task, RSJobParser*& parser);
+
+// Parses the empty job template, the caller deletes its job and the parser
+RSJobParser* rsJobParseEmpty();
+
+/*
+ * Builds a job with the given arguments and tasks on top of the empty job
+ * template. The caller deletes both the job and its parser, a task of an
+ * unknown tool is a runtime_error.
+ */
+RSJob* rsJobCreateFromSnapshot(const QList<rsArgumentSnapshot>& arguments, const QList<rsTaskSnapshot>& tasks, RSJobParser*& parser);
+
+/*
+ * Reads a file and throws its contents away, so that it is found in the
+ * page cache when it is parsed afterwards. Unlike parsing, this is safe to
+ * do from any thread. Returns false if the file could not be read.
+ */
+bool rsJobPrefetchFile(const QString& path);
+
+// Writes the job's XML to the given file (throws a runtime_error on failure)
+void rsJobWriteFile(RSJob* job, const char* path);
+
+/*
+ * Replaces every ${key} within the value by the job argument of that name.
+ * References to unknown arguments are left as they are.
+ */
+std::string rsJobResolveValue(RSJob* job, const char* value);
+
+#endif
@@ -0,0 +1,320 @@
+#include "rsjobvalidator.h"
+#include "rstoolindex.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSJobValidationThread::RSJobValidationThread(const RSJobSnapshot& job, QObject *parent) : QThread(parent)
+{
+    this->job = job;
+}
+
+map<rsValidationKey, string> RSJobValidationThread::getResults()
+{
+    return results;
+}
+
+void RSJobValidationThread::run()
+{
+    for ( int i=0; i<job.getTaskCount(); i++ ) {
+        RSJobValidator::validateTask((size_t)i, RSJobValidator::copyTask(job.getTask(i)), results);
+    }
+}
+
+RSJobValidator::RSJobValidator(QObject *parent) : QObject(parent)
+{
+    worker = NULL;
+}
+
+RSJobValidator::~RSJobValidator()
+{
+    if ( worker != NULL ) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+bool RSJobValidator::isRunning()
+{
+    return worker != NULL;
+}
+
+void RSJobValidator::clear()
+{
+    if ( worker != NULL ) {
+        // let the outdated run finish on its own, its results are dropped.
+        // A finished() that is already queued is caught in threadFinished().
+        disconnect(worker, SIGNAL(finished()), this, SLOT(threadFinished()));
+        if ( worker->isFinished() ) {
+            worker->deleteLater();
+        } else {
+            connect(worker, SIGNAL(finished()), worker, SLOT(deleteLater()));
+        }
+        worker = NULL;
+    }
+
+    issues.clear();
+    touched.clear();
+}
+
+void RSJobValidator::validateJob(const RSJobSnapshot& job)
+{
+    clear();
+
+    // the option descriptors are shared with the worker thread and have
+    // to be created in the GUI thread beforehand
+    RSToolIndex::getInstance().build();
+
+    worker = new RSJobValidationThread(job);
+    connect(worker, SIGNAL(finished()), this, SLOT(threadFinished()));
+    worker->start(QThread::LowPriority);
+}
+
+void RSJobValidator::threadFinished()
+{
+    // an outdated run whose signal was queued before clear()
+    RSJobValidationThread *thread = (RSJobValidationThread*)sender();
+    if ( thread != worker ) {
+        thread->deleteLater();
+        return;
+    }
+
+    map<rsValidationKey, string> results = worker->getResults();
+    worker->deleteLater();
+    worker = NULL;
+
+    // options that were edited in the meantime have already been checked
+    // against their new value
+    for (map<rsValidationKey, string>::iterator it = results.begin(); it != results.end(); ++it) {
+        if ( touched.find(it->first) == touched.end() ) {
+            issues[it->first] = it->second;
+        }
+    }
+    touched.clear();
+
+    emit jobValidated();
+}
+
+void RSJobValidator::revalidate(size_t taskIndex, RSTask* task, rsUIOption* option)
+{
+    rsValidationKey key(taskIndex, string(option->name));
+    rsArgument* argument = task->getArgument(option->name);
+    string message;
+
+    if ( argument == NULL ) {
+        validateValue(option, NULL, false, message);
+    } else {
+        validateValue(option, argument->value, true, message);
+    }
+
+    setMessage(key, message);
+}
+
+void RSJobValidator::revalidateTask(size_t taskIndex, RSTask* task)
+{
+    map<rsValidationKey, string> results;
+    validateTask(taskIndex, copyTask(task), results);
+
+    // drop all previous messages of the task before adding the new ones
+    map<rsValidationKey, string>::iterator it = issues.lower_bound(rsValidationKey(taskIndex, string()));
+    while ( it != issues.end() && it->first.first == taskIndex ) {
+        if ( worker != NULL ) {
+            touched.insert(it->first);
+        }
+        issues.erase(it++);
+    }
+
+    for (it = results.begin(); it != results.end(); ++it) {
+        setMessage(it->first, it->second);
+    }
+}
+
+void RSJobValidator::setMessage(const rsValidationKey& key, const string& message)
+{
+    if ( worker != NULL ) {
+        touched.insert(key);
+    }
+
+    if ( message.empty() ) {
+        issues.erase(key);
+    } else {
+        issues[key] = message;
+    }
+}
+
+string RSJobValidator::getMessage(size_t taskIndex, const char* option)
+{
+    map<rsValidationKey, string>::iterator it = issues.find(rsValidationKey(taskIndex, string(option)));
+    if ( it == issues.end() ) {
+        return string();
+    }
+    return it->second;
+}
+
+vector<rsValidationIssue> RSJobValidator::getIssues()
+{
+    vector<rsValidationIssue> result;
+    for (map<rsValidationKey, string>::iterator it = issues.begin(); it != issues.end(); ++it) {
+        rsValidationIssue issue;
+        issue.taskIndex = it->first.first;
+        issue.option    = it->first.second;
+        issue.message   = it->second;
+        result.push_back(issue);
+    }
+    return result;
+}
+
+rsValidationTask RSJobValidator::copyTask(RSTask* task)
+{
+    rsValidationTask copy;
+    copy.code = task->getCode();
+
+    vector<rsArgument*> arguments = task->getArguments();
+    for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+        rsValidationArgument argument;
+        argument.key      = (*it)->key;
+        argument.hasValue = (*it)->value != NULL;
+        argument.value    = argument.hasValue ? (*it)->value : "";
+        copy.arguments.push_back(argument);
+    }
+
+    return copy;
+}
+
+rsValidationTask RSJobValidator::copyTask(const rsTaskSnapshot& task)
+{
+    rsValidationTask copy;
+    copy.code = task.code.toUtf8().data();
+
+    foreach( const rsArgumentSnapshot &a, task.arguments ) {
+        rsValidationArgument argument;
+        argument.key      = a.key.toUtf8().data();
+        argument.hasValue = a.hasValue;
+        argument.value    = a.value.toUtf8().data();
+        copy.arguments.push_back(argument);
+    }
+
+    return copy;
+}
+
+void RSJobValidator::validateTask(size_t taskIndex, const rsValidationTask& task, map<rsValidationKey, string>& results)
+{
+    rsToolIndexEntry* entry = RSToolIndex::getInstance().findEntry(task.code.c_str());
+
+    if ( entry == NULL ) {
+        results[rsValidationKey(taskIndex, string())] = string("Unknown tool '") + task.code + string("'");
+        return;
+    }
+
+    rsUIInterface* I = entry->ui;
+    set<string> known;
+
+    for ( size_t i=0; i<I->nOptions; i++ ) {
+        rsUIOption* option = I->options[i];
+        known.insert(string(option->name));
+
+        const rsValidationArgument* argument = NULL;
+        for (vector<rsValidationArgument>::const_iterator it = task.arguments.begin(); it != task.arguments.end(); ++it) {
+            if ( it->key == option->name ) {
+                argument = &(*it);
+                break;
+            }
+        }
+
+        string message;
+        if ( argument == NULL ) {
+            validateValue(option, NULL, false, message);
+        } else {
+            validateValue(option, argument->hasValue ? argument->value.c_str() : NULL, true, message);
+        }
+
+        if ( ! message.empty() ) {
+            results[rsValidationKey(taskIndex, string(option->name))] = message;
+        }
+    }
+
+    for (vector<rsValidationArgument>::const_iterator it = task.arguments.begin(); it != task.arguments.end(); ++it) {
+        if ( known.find(it->key) == known.end() ) {
+            results[rsValidationKey(taskIndex, it->key)] = string("Unknown option '") + it->key + string("'");
+        }
+    }
+}
+
+/*
+ * Checks a single value against its option. Options that are not present
+ * are always valid, as rsUIOption does not carry a required flag. Options
+ * that are present, however, require a value unless they are switches.
+ */
+bool RSJobValidator::validateValue(rsUIOption* option, const char* value, bool present, string& message)
+{
+    message.clear();
+
+    if ( ! present || option->type == G_OPTION_ARG_NONE ) {
+        return true;
+    }
+
+    if ( value == NULL || value[0] == '\0' ) {
+        message = "A value is required";
+        return false;
+    }
+
+    // values that reference job arguments are only known at run time
+    if ( strstr(value, "${") != NULL ) {
+        return true;
+    }
+
+    if ( option->allowedValues != NULL ) {
+        rsUIOptionValue** values = option->allowedValues;
+        for (size_t i=0; values[i] != NULL; i++ ) {
+            if ( ! strcmp(value, values[i]->name) ) {
+                return true;
+            }
+        }
+        message = string("'") + value + string("' is not one of the allowed values");
+        return false;
+    }
+
+    char *end = NULL;
+    errno = 0;
+
+    switch ( option->type ) {
+        case G_OPTION_ARG_INT:
+            {
+                long v = strtol(value, &end, 10);
+                if ( *end != '\0' || end == value ) {
+                    message = string("'") + value + string("' is not an integer");
+                } else if ( errno == ERANGE || v > INT_MAX || v < INT_MIN ) {
+                    message = string("'") + value + string("' is out of range");
+                }
+            }
+            break;
+        case G_OPTION_ARG_INT64:
+            strtoll(value, &end, 10);
+            if ( *end != '\0' || end == value ) {
+                message = string("'") + value + string("' is not an integer");
+            } else if ( errno == ERANGE ) {
+                message = string("'") + value + string("' is out of range");
+            }
+            break;
+        case G_OPTION_ARG_DOUBLE:
+            strtod(value, &end);
+            if ( *end != '\0' || end == value ) {
+                message = string("'") + value + string("' is not a number");
+            } else if ( errno == ERANGE ) {
+                message = string("'") + value + string("' is out of range");
+            }
+            break;
+        default:
+            break;
+    }
+
+    return message.empty();
+}
+
+}}} // namespace rstools::batch::util
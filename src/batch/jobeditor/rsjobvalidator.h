@@ -0,0 +1,100 @@
+#ifndef rstools_rsbatch_jobeditor_rsjobvalidator_h
+#define rstools_rsbatch_jobeditor_rsjobvalidator_h
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <QObject>
+#include <QThread>
+#include "batch/util/rsjob.hpp"
+#include "batch/util/rstask.hpp"
+#include "utils/rsui.h"
+#include "rsjobsnapshot.h"
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    size_t taskIndex;
+    string option;
+    string message;
+} rsValidationIssue;
+
+typedef pair<size_t, string> rsValidationKey;
+
+typedef struct {
+    string key;
+    string value;
+    bool hasValue;
+} rsValidationArgument;
+
+typedef struct {
+    string code;
+    vector<rsValidationArgument> arguments;
+} rsValidationTask;
+
+/*
+ * Worker thread that validates a snapshot of the job, so that the job
+ * itself can be edited while it is running.
+ */
+class RSJobValidationThread : public QThread
+{
+public:
+    RSJobValidationThread(const RSJobSnapshot& job, QObject *parent = 0);
+
+    map<rsValidationKey, string> getResults();
+
+protected:
+    void run();
+
+    RSJobSnapshot job;
+    map<rsValidationKey, string> results;
+};
+
+/*
+ * Checks every task argument against its rsUIOption. A full pass runs in
+ * the background when a job is opened, afterwards only the options that
+ * were edited are checked again.
+ */
+class RSJobValidator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RSJobValidator(QObject *parent = 0);
+    ~RSJobValidator();
+
+    void validateJob(const RSJobSnapshot& job);
+    void revalidate(size_t taskIndex, RSTask* task, rsUIOption* option);
+    void revalidateTask(size_t taskIndex, RSTask* task);
+    void clear();
+
+    bool isRunning();
+    string getMessage(size_t taskIndex, const char* option);
+    vector<rsValidationIssue> getIssues();
+
+    static bool validateValue(rsUIOption* option, const char* value, bool present, string& message);
+    static void validateTask(size_t taskIndex, const rsValidationTask& task, map<rsValidationKey, string>& results);
+    static rsValidationTask copyTask(RSTask* task);
+    static rsValidationTask copyTask(const rsTaskSnapshot& task);
+
+signals:
+    void jobValidated();
+
+protected slots:
+    void threadFinished();
+
+protected:
+    void setMessage(const rsValidationKey& key, const string& message);
+
+    RSJobValidationThread *worker;
+    map<rsValidationKey, string> issues;
+    set<rsValidationKey> touched;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,107 @@
+#include "rslogbuffer.h"
+#include <QFile>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSLogBuffer::RSLogBuffer(int capacity)
+{
+    lines.resize(qMax(1, capacity));
+    first = 0;
+    count = 0;
+    total = 0;
+    spill = NULL;
+}
+
+RSLogBuffer::~RSLogBuffer()
+{
+    if ( spill != NULL ) {
+        spill->close();
+        delete spill;
+    }
+}
+
+void RSLogBuffer::append(const QString &line)
+{
+    const int cap = lines.size();
+
+    if ( count < cap ) {
+        lines[(first + count) % cap] = line;
+        count++;
+    } else {
+        // overwrite the oldest line
+        lines[first] = line;
+        first = (first + 1) % cap;
+    }
+    total++;
+
+    if ( spill != NULL ) {
+        spill->write(line.toLocal8Bit());
+        spill->write("\n", 1);
+    }
+}
+
+void RSLogBuffer::append(const QStringList &newLines)
+{
+    foreach( const QString &l, newLines ) {
+        append(l);
+    }
+    if ( spill != NULL ) {
+        spill->flush();
+    }
+}
+
+int RSLogBuffer::size() const
+{
+    return count;
+}
+
+int RSLogBuffer::capacity() const
+{
+    return lines.size();
+}
+
+qint64 RSLogBuffer::totalLines() const
+{
+    return total;
+}
+
+qint64 RSLogBuffer::droppedLines() const
+{
+    return total - count;
+}
+
+// i=0 is the oldest line that is still held
+QString RSLogBuffer::line(int i) const
+{
+    if ( i < 0 || i >= count ) {
+        return QString();
+    }
+    return lines[(first + i) % lines.size()];
+}
+
+bool RSLogBuffer::spillTo(const QString &path)
+{
+    if ( spill != NULL ) {
+        spill->close();
+        delete spill;
+        spill = NULL;
+    }
+
+    QFile *file = new QFile(path);
+    if ( ! file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text) ) {
+        delete file;
+        return false;
+    }
+
+    spill = file;
+    return true;
+}
+
+QString RSLogBuffer::spillPath() const
+{
+    return spill == NULL ? QString() : spill->fileName();
+}
+
+}}} // namespace rstools::batch::util
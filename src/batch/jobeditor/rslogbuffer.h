@@ -0,0 +1,49 @@
+#ifndef rstools_rsbatch_jobeditor_rslogbuffer_h
+#define rstools_rsbatch_jobeditor_rslogbuffer_h
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QFile;
+QT_END_NAMESPACE
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Fixed-size ring buffer holding the most recent lines of a job's output.
+ * Optionally, every line is also written to a spill file so that nothing
+ * is lost once it falls out of the buffer.
+ */
+class RSLogBuffer
+{
+public:
+    explicit RSLogBuffer(int capacity = 10000);
+    ~RSLogBuffer();
+
+    void append(const QString &line);
+    void append(const QStringList &newLines);
+
+    int size() const;
+    int capacity() const;
+    qint64 totalLines() const;
+    qint64 droppedLines() const;
+    QString line(int i) const;
+
+    bool spillTo(const QString &path);
+    QString spillPath() const;
+
+protected:
+    QVector<QString> lines;
+    int first;
+    int count;
+    qint64 total;
+    QFile *spill;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
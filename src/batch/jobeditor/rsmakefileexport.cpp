@@ -0,0 +1,231 @@
+#include "rsmakefileexport.h"
+#include "rsjobgraph.h"
+#include "rsjobrunqueue.h"
+#include "rsjobutils.h"
+#include "rstoolindex.h"
+#include "utils/rsstring.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSMakefileExport::RSMakefileExport(const QString& makefile)
+{
+    this->makefile = QFileInfo(makefile).absoluteFilePath();
+    this->directory = QFileInfo(this->makefile).absolutePath();
+}
+
+QString RSMakefileExport::uniqueName(const QString& name)
+{
+    QString result;
+    for ( int i=0; i<name.size(); i++ ) {
+        QChar c = name.at(i);
+        result += c.isLetterOrNumber() || c == '-' || c == '_' || c == '.' ? c : QChar('_');
+    }
+    if ( result.isEmpty() ) {
+        result = QString("job");
+    }
+
+    QString unique = result;
+    for ( int i=2; jobNames.contains(unique); i++ ) {
+        unique = result + QString("-%1").arg(i);
+    }
+    return unique;
+}
+
+/*
+ * make escapes spaces, comments, pattern characters and colons, which would
+ * end the list of targets, with a backslash and variables with a second
+ * dollar
+ */
+QString RSMakefileExport::escapePath(const QString& path)
+{
+    QString result = path;
+    result.replace("$", "$$");
+    result.replace(" ", "\\ ");
+    result.replace("#", "\\#");
+    result.replace("%", "\\%");
+    result.replace(":", "\\:");
+    return result;
+}
+
+QString RSMakefileExport::quoteArgument(const QString& argument)
+{
+    QString result = argument;
+    result.replace("'", "'\\''");
+    result.replace("$", "$$");
+    return QString("'") + result + QString("'");
+}
+
+/*
+ * Task job files are only rewritten when their content changed, so that
+ * exporting again does not make make rerun every task.
+ */
+bool RSMakefileExport::writeIfChanged(const QString& path, const QByteArray& content)
+{
+    QFile existing(path);
+    if ( existing.open(QIODevice::ReadOnly) ) {
+        if ( existing.readAll() == content ) {
+            return true;
+        }
+        existing.close();
+    }
+
+    QFile file(path);
+    if ( ! file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+        return false;
+    }
+    return file.write(content) == content.size();
+}
+
+void RSMakefileExport::addJobFile(const QString& path)
+{
+    // the plugins have to be loaded before a job can be parsed
+    RSToolIndex::getInstance().build();
+
+    QByteArray p = path.toLocal8Bit();
+    RSJobParser *parser = new RSJobParser(rsString(p.data()));
+    RSJob *job = NULL;
+
+    try {
+        parser->parse();
+        job = parser->getJob();
+        addJob(job, QFileInfo(path).completeBaseName());
+    } catch (...) {
+        delete job;
+        delete parser;
+        throw;
+    }
+
+    delete job;
+    delete parser;
+}
+
+void RSMakefileExport::addJob(RSJob* job, const QString& name)
+{
+    const QString jobName = uniqueName(name);
+    const QString taskDirectory = directory + QString("/") + jobName + QString(".tasks");
+    if ( ! QDir().mkpath(taskDirectory) ) {
+        throw runtime_error(string("The directory '") + taskDirectory.toLocal8Bit().data() + string("' could not be created"));
+    }
+    jobNames << jobName;
+
+    RSJobGraph graph;
+    graph.build(job);
+
+    const QString arguments = RSJobRunQueue::getInstance().getRunnerArguments();
+
+    vector<RSTask*> tasks = job->getTasks();
+    QStringList taskTargets;
+    QTextStream out(&rules);
+
+    out << "\n# " << jobName << "\n";
+
+    for ( size_t i=0; i<tasks.size(); i++ ) {
+        const rsJobGraphNode &node = graph.getNode((int)i);
+        const QString prefix = taskDirectory + QString("/%1-%2").arg((int)i+1, 3, 10, QChar('0')).arg(QString(tasks[i]->getCode()));
+        const QString taskJobFile = prefix + QString(".job");
+
+        RSJobParser *taskParser = NULL;
+        RSJob *taskJob = rsJobCopyForTask(job, tasks[i], taskParser);
+        char *taskXml = taskJob->toXml();
+        const bool written = writeIfChanged(taskJobFile, QByteArray(taskXml));
+        rsFree(taskXml);
+        delete taskJob;
+        delete taskParser;
+
+        if ( ! written ) {
+            throw runtime_error(string("The task job '") + taskJobFile.toLocal8Bit().data() + string("' could not be written"));
+        }
+
+        // tasks that write nothing or whose output was claimed by an
+        // earlier task are tracked through a stamp file
+        const bool stamp = node.outputs.isEmpty() || targets.contains(node.outputs.first());
+        const QString target = stamp ? prefix + QString(".done") : node.outputs.first();
+        targets.insert(target);
+        taskTargets << target;
+
+        QStringList prerequisites;
+        prerequisites << escapePath(taskJobFile);
+        foreach( const QString &input, node.inputs ) {
+            prerequisites << escapePath(input);
+        }
+
+        // dependencies that are not visible through the inputs only
+        // determine the order
+        QStringList orderOnly;
+        foreach( int d, node.dependencies ) {
+            const rsJobGraphNode &dependency = graph.getNode(d);
+            bool throughInput = false;
+            foreach( const QString &output, dependency.outputs ) {
+                if ( node.inputs.contains(output) ) {
+                    throughInput = true;
+                    break;
+                }
+            }
+            if ( ! throughInput ) {
+                orderOnly << escapePath(taskTargets.at(d));
+            }
+        }
+
+        out << escapePath(target) << ": " << prerequisites.join(" ");
+        if ( ! orderOnly.isEmpty() ) {
+            out << " | " << orderOnly.join(" ");
+        }
+        out << "\n";
+
+        QStringList command;
+        command << QString("$(RSBATCH)");
+        foreach( const QString &argument, arguments.split(' ', QString::SkipEmptyParts) ) {
+            command << quoteArgument(QString(argument).replace("%1", taskJobFile));
+        }
+        out << "\t" << command.join(" ") << "\n";
+        if ( stamp ) {
+            out << "\ttouch $@\n";
+        }
+
+        // further outputs are brought up to date along with the first one
+        for ( int o=1; o<node.outputs.size(); o++ ) {
+            if ( stamp || targets.contains(node.outputs.at(o)) ) {
+                continue;
+            }
+            targets.insert(node.outputs.at(o));
+            out << escapePath(node.outputs.at(o)) << ": " << escapePath(target) << " ;\n";
+        }
+    }
+
+    QStringList escapedTargets;
+    foreach( const QString &target, taskTargets ) {
+        escapedTargets << escapePath(target);
+    }
+    out << jobName << ": " << escapedTargets.join(" ") << "\n";
+    out.flush();
+}
+
+void RSMakefileExport::write()
+{
+    QFile file(makefile);
+    if ( ! file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) ) {
+        throw runtime_error(string("File '") + makefile.toLocal8Bit().data() + string("' could not be written. Please ensure that the proper writing permissions are granted."));
+    }
+
+    QTextStream out(&file);
+    out << "# Generated by rsjobeditor. Run with `make -j N` to execute independent\n";
+    out << "# tasks in parallel, or `make <job>` to run a single job.\n\n";
+    out << "RSBATCH ?= " << RSJobRunQueue::getInstance().getRunnerProgram() << "\n\n";
+    out << ".DELETE_ON_ERROR:\n";
+    out << ".PHONY: all " << jobNames.join(" ") << "\n\n";
+    out << "all: " << jobNames.join(" ") << "\n";
+    out << rules;
+}
+
+}}} // namespace rstools::batch::util
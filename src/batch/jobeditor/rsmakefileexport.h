@@ -0,0 +1,45 @@
+#ifndef rstools_rsbatch_jobeditor_rsmakefileexport_h
+#define rstools_rsbatch_jobeditor_rsmakefileexport_h
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include "batch/util/rsjob.hpp"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Writes jobs as a Makefile, so that `make -j` runs independent tasks and
+ * jobs concurrently and only reruns tasks whose inputs or settings are
+ * newer than their outputs. Every task becomes a single-task job file in
+ * a directory next to the Makefile; its first output file is the target
+ * and its input files are the prerequisites.
+ */
+class RSMakefileExport
+{
+public:
+    explicit RSMakefileExport(const QString& makefile);
+
+    void addJob(RSJob* job, const QString& name);
+    void addJobFile(const QString& path);
+    void write();
+
+protected:
+    QString uniqueName(const QString& name);
+    bool writeIfChanged(const QString& path, const QByteArray& content);
+
+    static QString escapePath(const QString& path);
+    static QString quoteArgument(const QString& argument);
+
+    QString makefile;
+    QString directory;
+    QStringList jobNames;
+    QString rules;
+    QSet<QString> targets;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,381 @@
+#include "rsniftiheader.h"
+#include <QMutexLocker>
+#include <QStringList>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+// a NIfTI-2 header is 540 bytes long, a NIfTI-1 header 348
+static const size_t headerLength = 540;
+
+RSNiftiHeaderTask::RSNiftiHeaderTask(RSNiftiHeaderCache *cache, const QString &path)
+{
+    this->cache = cache;
+    this->path  = path;
+}
+
+void RSNiftiHeaderTask::run()
+{
+    cache->fetch(path);
+    emit cache->headerReady(path);
+}
+
+RSNiftiHeaderCache& RSNiftiHeaderCache::getInstance()
+{
+    static RSNiftiHeaderCache instance;
+    return instance;
+}
+
+RSNiftiHeaderCache::RSNiftiHeaderCache() : QObject(0)
+{
+    pool.setMaxThreadCount(2);
+    clock.start();
+}
+
+RSNiftiHeaderCache::~RSNiftiHeaderCache()
+{
+    pool.waitForDone();
+}
+
+bool RSNiftiHeaderCache::lookup(const QString &path, rsNiftiHeader &header)
+{
+    QMutexLocker locker(&mutex);
+    QHash<QString, rsNiftiHeader>::const_iterator it = headers.constFind(path);
+
+    if ( it == headers.constEnd() || clock.elapsed() - it.value().fetched >= timeToLive ) {
+        return false;
+    }
+
+    header = it.value();
+    return true;
+}
+
+void RSNiftiHeaderCache::request(const QString &path)
+{
+    QMutexLocker locker(&mutex);
+
+    if ( pending.contains(path) ) {
+        return;
+    }
+
+    pending.insert(path);
+    pool.start(new RSNiftiHeaderTask(this, path));
+}
+
+/*
+ * Returns the header of the given file, reading it only if the file changed
+ * since it was last read. Blocks, so it must not be called from the GUI
+ * thread.
+ */
+rsNiftiHeader RSNiftiHeaderCache::fetch(const QString &path)
+{
+    QString headerPath;
+    qint64 size, mtime;
+    bool exists = statImage(path, headerPath, size, mtime);
+
+    rsNiftiHeader header;
+    bool known = false;
+    {
+        QMutexLocker locker(&mutex);
+        QHash<QString, rsNiftiHeader>::const_iterator it = headers.constFind(path);
+        if ( exists && it != headers.constEnd() && it.value().valid
+          && it.value().mtime == mtime && it.value().fileSize == size ) {
+            header = it.value();
+            known = true;
+        }
+    }
+
+    if ( ! known ) {
+        readHeader(path, header);
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+        header.fetched = clock.elapsed();
+        headers.insert(path, header);
+        pending.remove(path);
+    }
+
+    return header;
+}
+
+bool RSNiftiHeaderCache::isNiftiPath(const QString &path)
+{
+    QString p = path.toLower();
+    if ( p.endsWith(".gz") ) {
+        p.chop(3);
+    }
+    return p.endsWith(".nii") || p.endsWith(".hdr") || p.endsWith(".img");
+}
+
+// The file that holds the voxels, which is the .img of a pair
+QString RSNiftiHeaderCache::getDataPath(const QString &path)
+{
+    bool compressed = path.toLower().endsWith(".gz");
+    QString base = compressed ? path.left(path.length() - 3) : path;
+
+    if ( base.toLower().endsWith(".hdr") ) {
+        return base.left(base.length() - 4) + QString(".img") + (compressed ? path.right(3) : QString());
+    }
+    return path;
+}
+
+/*
+ * Finds the file that holds the header of an image and sums up the size of
+ * all of its files. For Analyze-style pairs the header is in the .hdr while
+ * the voxels are in the .img.
+ */
+bool RSNiftiHeaderCache::statImage(const QString &path, QString &headerPath, qint64 &size, qint64 &mtime)
+{
+    bool compressed = path.toLower().endsWith(".gz");
+    QString base = compressed ? path.left(path.length() - 3) : path;
+    QString suffix = compressed ? path.right(3) : QString();
+    QString dataPath;
+
+    headerPath = path;
+    if ( base.toLower().endsWith(".hdr") ) {
+        dataPath = base.left(base.length() - 4) + QString(".img") + suffix;
+    } else if ( base.toLower().endsWith(".img") ) {
+        dataPath = path;
+        headerPath = base.left(base.length() - 4) + QString(".hdr") + suffix;
+    }
+
+    size  = 0;
+    mtime = 0;
+
+    struct stat buffer;
+    QByteArray p = headerPath.toLocal8Bit();
+    if ( ::stat(p.data(), &buffer) != 0 ) {
+        return false;
+    }
+    size  = (qint64)buffer.st_size;
+    mtime = (qint64)buffer.st_mtime;
+
+    if ( ! dataPath.isEmpty() && dataPath != headerPath ) {
+        QByteArray d = dataPath.toLocal8Bit();
+        if ( ::stat(d.data(), &buffer) == 0 ) {
+            size += (qint64)buffer.st_size;
+            mtime = qMax(mtime, (qint64)buffer.st_mtime);
+        }
+    }
+
+    return true;
+}
+
+// Reads and parses the header of an image without any caching
+bool RSNiftiHeaderCache::readHeader(const QString &path, rsNiftiHeader &header)
+{
+    memset(header.dim, 0, sizeof(header.dim));
+    header.valid       = false;
+    header.error       = QString();
+    header.version     = 0;
+    header.compressed  = path.toLower().endsWith(".gz");
+    header.swapped     = false;
+    header.datatype    = 0;
+    header.bitpix      = 0;
+    header.voxelOffset = 0;
+    header.fetched     = 0;
+
+    QString headerPath;
+    if ( ! statImage(path, headerPath, header.fileSize, header.mtime) ) {
+        header.error = QString("The file does not exist");
+        return false;
+    }
+
+    char bytes[headerLength];
+    size_t read = 0;
+    if ( ! readBytes(headerPath, header.compressed, bytes, headerLength, read) ) {
+        header.error = QString("The header could not be read");
+        return false;
+    }
+
+    if ( ! parse(bytes, read, header) ) {
+        header.error = QString("This is not a NIfTI image");
+        return false;
+    }
+
+    header.valid = true;
+    return true;
+}
+
+/*
+ * Reads at most length bytes from the start of a file. Uncompressed files
+ * are mapped so that only the pages holding the header are ever loaded,
+ * compressed files are inflated only until the requested length is reached.
+ */
+bool RSNiftiHeaderCache::readBytes(const QString &path, bool compressed, char *buffer, size_t length, size_t &read)
+{
+    QByteArray p = path.toLocal8Bit();
+    read = 0;
+
+    if ( compressed ) {
+        gzFile file = gzopen(p.data(), "rb");
+        if ( file == NULL ) {
+            return false;
+        }
+        int n = gzread(file, buffer, (unsigned int)length);
+        gzclose(file);
+        if ( n < 0 ) {
+            return false;
+        }
+        read = (size_t)n;
+        return true;
+    }
+
+    int fd = open(p.data(), O_RDONLY);
+    if ( fd < 0 ) {
+        return false;
+    }
+
+    struct stat buffer2;
+    if ( fstat(fd, &buffer2) != 0 || buffer2.st_size <= 0 ) {
+        close(fd);
+        return false;
+    }
+
+    read = qMin(length, (size_t)buffer2.st_size);
+    void *data = mmap(NULL, read, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if ( data == MAP_FAILED ) {
+        read = 0;
+        return false;
+    }
+
+    memcpy(buffer, data, read);
+    munmap(data, read);
+    return true;
+}
+
+template <typename T>
+static T readValue(const char *buffer, size_t offset, bool swap)
+{
+    T value;
+    char *bytes = (char*)&value;
+    memcpy(bytes, buffer + offset, sizeof(T));
+    if ( swap ) {
+        for ( size_t i=0; i<sizeof(T)/2; i++ ) {
+            char c = bytes[i];
+            bytes[i] = bytes[sizeof(T)-1-i];
+            bytes[sizeof(T)-1-i] = c;
+        }
+    }
+    return value;
+}
+
+bool RSNiftiHeaderCache::parse(const char *buffer, size_t length, rsNiftiHeader &header)
+{
+    if ( length < 348 ) {
+        return false;
+    }
+
+    // the header size tells the version as well as the byte order
+    bool swap = false;
+    qint32 size = readValue<qint32>(buffer, 0, false);
+    if ( size != 348 && size != 540 ) {
+        swap = true;
+        size = readValue<qint32>(buffer, 0, true);
+    }
+
+    header.swapped = swap;
+
+    if ( size == 348 ) {
+        header.version = 1;
+        for ( int i=0; i<8; i++ ) {
+            header.dim[i] = readValue<qint16>(buffer, 40 + 2*i, swap);
+        }
+        header.datatype    = readValue<qint16>(buffer, 70, swap);
+        header.bitpix      = readValue<qint16>(buffer, 72, swap);
+        header.voxelOffset = (qint64)readValue<float>(buffer, 108, swap);
+    } else if ( size == 540 && length >= 540 && ( memcmp(buffer + 4, "n+2", 3) == 0 || memcmp(buffer + 4, "ni2", 3) == 0 ) ) {
+        header.version = 2;
+        header.datatype = readValue<qint16>(buffer, 12, swap);
+        header.bitpix   = readValue<qint16>(buffer, 14, swap);
+        for ( int i=0; i<8; i++ ) {
+            header.dim[i] = readValue<qint64>(buffer, 16 + 8*i, swap);
+        }
+        header.voxelOffset = readValue<qint64>(buffer, 168, swap);
+    } else {
+        return false;
+    }
+
+    return header.dim[0] >= 1 && header.dim[0] <= 7;
+}
+
+qint64 RSNiftiHeaderCache::getVoxelsPerVolume(const rsNiftiHeader &header)
+{
+    qint64 voxels = 1;
+    for ( int i=1; i<=3 && i<=header.dim[0]; i++ ) {
+        voxels *= qMax((qint64)1, header.dim[i]);
+    }
+    return voxels;
+}
+
+qint64 RSNiftiHeaderCache::getVolumes(const rsNiftiHeader &header)
+{
+    qint64 volumes = 1;
+    for ( int i=4; i<=header.dim[0]; i++ ) {
+        volumes *= qMax((qint64)1, header.dim[i]);
+    }
+    return volumes;
+}
+
+// Size of the uncompressed voxel data in bytes
+qint64 RSNiftiHeaderCache::getDataSize(const rsNiftiHeader &header)
+{
+    return getVoxelsPerVolume(header) * getVolumes(header) * qMax(1, header.bitpix / 8);
+}
+
+QString RSNiftiHeaderCache::getDatatypeName(int datatype)
+{
+    switch ( datatype ) {
+        case 2:    return QString("uint8");
+        case 4:    return QString("int16");
+        case 8:    return QString("int32");
+        case 16:   return QString("float32");
+        case 32:   return QString("complex64");
+        case 64:   return QString("float64");
+        case 128:  return QString("rgb24");
+        case 256:  return QString("int8");
+        case 512:  return QString("uint16");
+        case 768:  return QString("uint32");
+        case 1024: return QString("int64");
+        case 1280: return QString("uint64");
+        case 1536: return QString("float128");
+        case 1792: return QString("complex128");
+        case 2048: return QString("complex256");
+        case 2304: return QString("rgba32");
+        default:   return QString("datatype %1").arg(datatype);
+    }
+}
+
+// e.g. "91x109x91, 120 volumes, float32"
+QString RSNiftiHeaderCache::describe(const rsNiftiHeader &header)
+{
+    if ( ! header.valid ) {
+        return header.error;
+    }
+
+    QStringList dims;
+    for ( int i=1; i<=3 && i<=header.dim[0]; i++ ) {
+        dims << QString::number(header.dim[i]);
+    }
+
+    QString description = dims.join("x");
+    qint64 volumes = getVolumes(header);
+    if ( volumes > 1 ) {
+        description += QString(", %1 volumes").arg(volumes);
+    }
+    description += QString(", ") + getDatatypeName(header.datatype);
+    return description;
+}
+
+}}} // namespace rstools::batch::util
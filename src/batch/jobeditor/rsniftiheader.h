@@ -0,0 +1,96 @@
+#ifndef rstools_rsbatch_jobeditor_rsniftiheader_h
+#define rstools_rsbatch_jobeditor_rsniftiheader_h
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    bool valid;
+    QString error;           // why the header could not be read
+    int version;             // 1 or 2
+    bool compressed;
+    bool swapped;            // stored in the other byte order
+    qint64 dim[8];           // dim[0] is the number of dimensions
+    int datatype;
+    int bitpix;
+    qint64 voxelOffset;
+    qint64 fileSize;         // on disk, including the .img of a pair
+    qint64 mtime;
+    qint64 fetched;
+} rsNiftiHeader;
+
+class RSNiftiHeaderCache;
+
+class RSNiftiHeaderTask : public QRunnable
+{
+public:
+    RSNiftiHeaderTask(RSNiftiHeaderCache *cache, const QString &path);
+    void run();
+
+protected:
+    RSNiftiHeaderCache *cache;
+    QString path;
+};
+
+/*
+ * Reads nothing but the header of NIfTI-1 and NIfTI-2 images. Uncompressed
+ * files are mapped, compressed ones are inflated only as far as the header
+ * reaches. Headers are kept by path and are read again only once the file's
+ * modification time or size changed. Like the stat cache, lookups never
+ * touch the filesystem and misses are resolved by a worker pool.
+ */
+class RSNiftiHeaderCache : public QObject
+{
+    Q_OBJECT
+public:
+    static RSNiftiHeaderCache& getInstance();
+
+    bool lookup(const QString &path, rsNiftiHeader &header);
+    void request(const QString &path);
+    rsNiftiHeader fetch(const QString &path);
+
+    static bool isNiftiPath(const QString &path);
+    static QString getDataPath(const QString &path);
+    static bool readHeader(const QString &path, rsNiftiHeader &header);
+
+    static qint64 getVoxelsPerVolume(const rsNiftiHeader &header);
+    static qint64 getVolumes(const rsNiftiHeader &header);
+    static qint64 getDataSize(const rsNiftiHeader &header);
+    static QString getDatatypeName(int datatype);
+    static QString describe(const rsNiftiHeader &header);
+
+    static const qint64 timeToLive = 10000; // ms
+
+signals:
+    void headerReady(const QString &path);
+
+protected:
+    friend class RSNiftiHeaderTask;
+
+    RSNiftiHeaderCache();
+    ~RSNiftiHeaderCache();
+
+    static bool statImage(const QString &path, QString &headerPath, qint64 &size, qint64 &mtime);
+    static bool readBytes(const QString &path, bool compressed, char *buffer, size_t length, size_t &read);
+    static bool parse(const char *buffer, size_t length, rsNiftiHeader &header);
+
+    QThreadPool pool;
+    QMutex mutex;
+    QElapsedTimer clock;
+    QHash<QString, rsNiftiHeader> headers;
+    QSet<QString> pending;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
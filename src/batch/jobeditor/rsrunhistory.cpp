@@ -0,0 +1,212 @@
+#include "rsrunhistory.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSRunHistory& RSRunHistory::getInstance()
+{
+    static RSRunHistory instance;
+    return instance;
+}
+
+RSRunHistory::RSRunHistory() : QObject(0)
+{
+    loaded = false;
+}
+
+// Directory for everything the editor keeps between sessions
+QString RSRunHistory::getDataDirectory()
+{
+    QString directory = QDir::homePath() + QString("/.rsjobeditor");
+    QDir().mkpath(directory);
+    return directory;
+}
+
+QString RSRunHistory::getPath()
+{
+    return getDataDirectory() + QString("/history.tsv");
+}
+
+/*
+ * Reads the history file once. Every line holds the time, the tool code,
+ * the wall time, the cpu time and the peak memory of one task execution.
+ */
+void RSRunHistory::load()
+{
+    if ( loaded ) {
+        return;
+    }
+    loaded = true;
+
+    QFile file(getPath());
+    if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+        return;
+    }
+
+    QTextStream in(&file);
+    while ( ! in.atEnd() ) {
+        QStringList fields = in.readLine().split('\t');
+        if ( fields.size() < 5 ) {
+            continue;
+        }
+
+        rsRunSample sample;
+        sample.time       = fields.at(0).toLongLong();
+        sample.wallTime   = fields.at(2).toLongLong();
+        sample.cpuTime    = fields.at(3).toLongLong();
+        sample.peakMemory = fields.at(4).toLongLong();
+
+        QList<rsRunSample> &list = samples[fields.at(1)];
+        list.append(sample);
+        if ( list.size() > maxSamples ) {
+            list.removeFirst();
+        }
+    }
+}
+
+void RSRunHistory::record(const QString &code, qint64 wallTime, qint64 cpuTime, qint64 peakMemory)
+{
+    load();
+
+    rsRunSample sample;
+    sample.time       = QDateTime::currentDateTime().toTime_t();
+    sample.wallTime   = wallTime;
+    sample.cpuTime    = cpuTime;
+    sample.peakMemory = peakMemory;
+
+    QList<rsRunSample> &list = samples[code];
+    list.append(sample);
+    if ( list.size() > maxSamples ) {
+        list.removeFirst();
+    }
+
+    QFile file(getPath());
+    if ( file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text) ) {
+        QTextStream out(&file);
+        out << sample.time << '\t' << code << '\t' << wallTime << '\t' << cpuTime << '\t' << peakMemory << '\n';
+    }
+
+    emit historyChanged();
+}
+
+bool RSRunHistory::predict(const QString &code, rsRunPrediction &prediction)
+{
+    load();
+
+    if ( ! samples.contains(code) ) {
+        return false;
+    }
+
+    const QList<rsRunSample> &list = samples[code];
+    if ( list.isEmpty() ) {
+        return false;
+    }
+
+    vector<qint64> wallTimes;
+    vector<qint64> cpuTimes;
+    prediction.peakMemory = 0;
+
+    foreach( const rsRunSample &sample, list ) {
+        wallTimes.push_back(sample.wallTime);
+        cpuTimes.push_back(sample.cpuTime);
+        prediction.peakMemory = qMax(prediction.peakMemory, sample.peakMemory);
+    }
+
+    // the median is not thrown off by a single run on a busy machine
+    const size_t middle = wallTimes.size() / 2;
+    nth_element(wallTimes.begin(), wallTimes.begin() + middle, wallTimes.end());
+    nth_element(cpuTimes.begin(), cpuTimes.begin() + middle, cpuTimes.end());
+
+    prediction.runs     = list.size();
+    prediction.wallTime = wallTimes[middle];
+    prediction.cpuTime  = cpuTimes[middle];
+
+    return true;
+}
+
+/*
+ * Reads the cpu time (including that of already finished children) and
+ * the peak resident set size of a running process from /proc.
+ */
+bool RSRunHistory::sampleProcess(pid_t pid, qint64 &cpuTime, qint64 &peakMemory)
+{
+    char path[64];
+    char buffer[1024];
+
+    sprintf(path, "/proc/%d/stat", (int)pid);
+    FILE *f = fopen(path, "r");
+    if ( f == NULL ) {
+        return false;
+    }
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, f);
+    fclose(f);
+    buffer[length] = '\0';
+
+    // the command name may contain spaces, so parsing starts after it
+    char *fields = strrchr(buffer, ')');
+    if ( fields == NULL ) {
+        return false;
+    }
+
+    unsigned long utime, stime;
+    long cutime, cstime;
+    if ( sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %ld %ld", &utime, &stime, &cutime, &cstime) != 4 ) {
+        return false;
+    }
+
+    const long ticks = sysconf(_SC_CLK_TCK);
+    if ( ticks > 0 ) {
+        cpuTime = (qint64)(utime + stime + cutime + cstime) * 1000 / ticks;
+    }
+
+    sprintf(path, "/proc/%d/status", (int)pid);
+    f = fopen(path, "r");
+    if ( f == NULL ) {
+        return true;
+    }
+    while ( fgets(buffer, sizeof(buffer), f) != NULL ) {
+        long hwm;
+        if ( sscanf(buffer, "VmHWM: %ld kB", &hwm) == 1 ) {
+            peakMemory = qMax(peakMemory, (qint64)hwm);
+            break;
+        }
+    }
+    fclose(f);
+
+    return true;
+}
+
+QString RSRunHistory::formatDuration(qint64 ms)
+{
+    qint64 s = ms / 1000;
+    if ( s < 60 ) {
+        return QString("%1s").arg(qMax((qint64)1, s));
+    }
+    if ( s < 3600 ) {
+        return QString("%1m%2s").arg(s / 60).arg(s % 60, 2, 10, QChar('0'));
+    }
+    return QString("%1h%2m").arg(s / 3600).arg((s / 60) % 60, 2, 10, QChar('0'));
+}
+
+QString RSRunHistory::formatMemory(qint64 kilobytes)
+{
+    if ( kilobytes < 1024 * 1024 ) {
+        return QString("%1 MB").arg((kilobytes + 1023) / 1024);
+    }
+    return QString("%1 GB").arg(kilobytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,65 @@
+#ifndef rstools_rsbatch_jobeditor_rsrunhistory_h
+#define rstools_rsbatch_jobeditor_rsrunhistory_h
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <sys/types.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    qint64 time;             // seconds since the epoch
+    qint64 wallTime;         // in ms
+    qint64 cpuTime;          // in ms
+    qint64 peakMemory;       // peak resident set size in kB
+} rsRunSample;
+
+typedef struct {
+    int runs;
+    qint64 wallTime;         // median of the recent runs
+    qint64 cpuTime;          // median of the recent runs
+    qint64 peakMemory;       // maximum of the recent runs
+} rsRunPrediction;
+
+/*
+ * Local record of how long every tool took and how much memory it needed
+ * whenever a task was executed by the run queue. The samples are appended
+ * to a tab-separated file in the user's home directory and are used to
+ * predict the cost of tasks before a job is run.
+ */
+class RSRunHistory : public QObject
+{
+    Q_OBJECT
+public:
+    static RSRunHistory& getInstance();
+
+    void record(const QString &code, qint64 wallTime, qint64 cpuTime, qint64 peakMemory);
+    bool predict(const QString &code, rsRunPrediction &prediction);
+
+    static QString getDataDirectory();
+    static bool sampleProcess(pid_t pid, qint64 &cpuTime, qint64 &peakMemory);
+    static QString formatDuration(qint64 ms);
+    static QString formatMemory(qint64 kilobytes);
+
+signals:
+    void historyChanged();
+
+protected:
+    RSRunHistory();
+
+    void load();
+    QString getPath();
+
+    static const int maxSamples = 50;
+
+    bool loaded;
+    QHash<QString, QList<rsRunSample> > samples;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,131 @@
+#include "rssingleinstance.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSSingleInstance::RSSingleInstance(QObject *parent) : QObject(parent)
+{
+    server = NULL;
+}
+
+RSSingleInstance::~RSSingleInstance()
+{
+
+}
+
+QString RSSingleInstance::socketPath()
+{
+    return QDir::tempPath() + QString("/rsjobeditor-%1.sock").arg((qulonglong)getuid());
+}
+
+/*
+ * Sends the absolute path of the job file (or an empty line to merely
+ * raise the window) to the running instance and waits briefly for it to
+ * acknowledge. Returns false if no instance answered.
+ */
+bool RSSingleInstance::forward(const char* jobFile)
+{
+    QByteArray path = socketPath().toLocal8Bit();
+    QByteArray request;
+    if ( jobFile != NULL ) {
+        request = QFileInfo(QString::fromLocal8Bit(jobFile)).absoluteFilePath().toUtf8();
+    }
+    request.append('\n');
+
+    struct sockaddr_un address;
+    if ( path.size() >= (int)sizeof(address.sun_path) ) {
+        return false;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.data(), sizeof(address.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if ( fd < 0 ) {
+        return false;
+    }
+
+    bool delivered = false;
+
+    if ( ::connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0
+      && ::write(fd, request.data(), request.size()) == (ssize_t)request.size() ) {
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+
+        char reply[3];
+        if ( ::poll(&pfd, 1, 2000) > 0 && ::read(fd, reply, sizeof(reply)) >= 2 && ! strncmp(reply, "ok", 2) ) {
+            delivered = true;
+        }
+    }
+
+    ::close(fd);
+    return delivered;
+}
+
+bool RSSingleInstance::listen()
+{
+    QString path = socketPath();
+
+    server = new QLocalServer(this);
+    connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+
+    if ( server->listen(path) ) {
+        return true;
+    }
+
+    // another instance that was started at the same time may have just
+    // begun to listen, its socket must not be taken away from it
+    QLocalSocket probe;
+    probe.connectToServer(path);
+    if ( probe.waitForConnected(500) ) {
+        probe.abort();
+        return false;
+    }
+
+    // nobody answers, so the socket was left behind by an instance that
+    // did not shut down properly
+    QLocalServer::removeServer(path);
+    return server->listen(path);
+}
+
+void RSSingleInstance::newConnection()
+{
+    while ( server->hasPendingConnections() ) {
+        QLocalSocket *socket = server->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void RSSingleInstance::readRequest()
+{
+    QLocalSocket *socket = (QLocalSocket*)sender();
+
+    if ( ! socket->canReadLine() ) {
+        return;
+    }
+
+    QString jobFile = QString::fromUtf8(socket->readLine().trimmed());
+
+    // acknowledge first so that the client can exit while the job opens
+    socket->write("ok\n");
+    socket->flush();
+    socket->disconnectFromServer();
+
+    emit openRequested(jobFile);
+}
+
+}}} // namespace rstools::batch::util
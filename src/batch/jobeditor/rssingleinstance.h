@@ -0,0 +1,45 @@
+#ifndef rstools_rsbatch_jobeditor_rssingleinstance_h
+#define rstools_rsbatch_jobeditor_rssingleinstance_h
+
+#include <QObject>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QLocalServer;
+QT_END_NAMESPACE
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Lets a second invocation of the editor hand its job file over to an
+ * already running one. The client side deliberately uses plain POSIX
+ * sockets so that it can run before any Qt initialization took place.
+ */
+class RSSingleInstance : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RSSingleInstance(QObject *parent = 0);
+    ~RSSingleInstance();
+
+    bool listen();
+
+    static bool forward(const char* jobFile);
+    static QString socketPath();
+
+signals:
+    void openRequested(const QString &jobFile);
+
+protected slots:
+    void newConnection();
+    void readRequest();
+
+protected:
+    QLocalServer *server;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,89 @@
+#include "rsstringpool.h"
+#include <QMutexLocker>
+#include <string.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSStringPool& RSStringPool::getInstance()
+{
+    static RSStringPool instance;
+    return instance;
+}
+
+RSStringPool::RSStringPool()
+{
+    chunk = g_string_chunk_new(16384);
+    // the keys are the pooled strings themselves, nothing is copied twice
+    strings = g_hash_table_new(g_str_hash, g_str_equal);
+    size = 0;
+    requestedSize = 0;
+}
+
+RSStringPool::~RSStringPool()
+{
+    g_hash_table_destroy(strings);
+    g_string_chunk_free(chunk);
+}
+
+const char* RSStringPool::intern(const char *s)
+{
+    if ( s == NULL ) {
+        return NULL;
+    }
+
+    QMutexLocker locker(&mutex);
+    const qint64 length = (qint64)strlen(s) + 1;
+    requestedSize += length;
+
+    const char *pooled = (const char*)g_hash_table_lookup(strings, s);
+    if ( pooled == NULL ) {
+        pooled = g_string_chunk_insert(chunk, s);
+        g_hash_table_insert(strings, (gpointer)pooled, (gpointer)pooled);
+        size += length;
+    }
+
+    return pooled;
+}
+
+// Returns the interned copy of s without adding it, or NULL if there is none
+const char* RSStringPool::find(const char *s)
+{
+    if ( s == NULL ) {
+        return NULL;
+    }
+
+    QMutexLocker locker(&mutex);
+    return (const char*)g_hash_table_lookup(strings, s);
+}
+
+bool RSStringPool::contains(const void *p)
+{
+    if ( p == NULL ) {
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    return g_hash_table_lookup(strings, p) == p;
+}
+
+int RSStringPool::getStringCount()
+{
+    QMutexLocker locker(&mutex);
+    return (int)g_hash_table_size(strings);
+}
+
+qint64 RSStringPool::getSize()
+{
+    QMutexLocker locker(&mutex);
+    return size;
+}
+
+qint64 RSStringPool::getRequestedSize()
+{
+    QMutexLocker locker(&mutex);
+    return requestedSize;
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,48 @@
+#ifndef rstools_rsbatch_jobeditor_rsstringpool_h
+#define rstools_rsbatch_jobeditor_rsstringpool_h
+
+#include <QMutex>
+#include <QtGlobal>
+#include <glib.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Process-wide pool of interned argument keys and option names. These come
+ * from the tool definitions, so there are only as many as the tools have
+ * options. Every distinct string is stored once and for the lifetime of the
+ * process, so two interned strings are equal if and only if they are the
+ * same pointer. Interned strings must never be freed. Argument values are
+ * held by the arena of their job instead, see RSDocumentScope.
+ */
+class RSStringPool
+{
+public:
+    static RSStringPool& getInstance();
+
+    const char* intern(const char *s);
+    const char* find(const char *s);
+    bool contains(const void *p);
+
+    int getStringCount();
+    qint64 getSize();
+    qint64 getRequestedSize();
+
+protected:
+    RSStringPool();
+    ~RSStringPool();
+    RSStringPool(RSStringPool const&);
+    void operator=(RSStringPool const&);
+
+    QMutex mutex;
+    GStringChunk *chunk;
+    GHashTable *strings;
+    qint64 size;             // bytes stored
+    qint64 requestedSize;    // bytes that would have been copied without the pool
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,290 @@
+#include "rsstudyconsistency.h"
+#include "rsjobcomparison.h"
+#include "rsjobdiff.h"
+#include <QSet>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef QPair<QString, QList<rsArgumentSnapshot> > rsAlignedTask;
+
+typedef struct {
+    QString task;
+    QString key;
+    QHash<QString, int> values;
+    int present;             // jobs with the task that have the argument
+    QString usual;
+    int usualCount;
+} rsOptionCounts;
+
+static QString optionId(const QString &task, const QString &argument)
+{
+    return task + QChar('\t') + argument;
+}
+
+RSStudyConsistency::RSStudyConsistency(const RSStudyIndex &index, double majority)
+{
+    const QHash<QString, rsIndexedJob> &jobs = index.getJobs();
+    QHash<QString, int> taskCounts;
+    QHash<QString, rsOptionCounts> options;
+    QStringList ids;
+
+    jobCount = 0;
+    chooseReference(jobs);
+
+    // count how many jobs use every value of every argument of every task
+    foreach( const rsIndexedJob &job, jobs ) {
+        if ( ! job.readable ) {
+            continue;
+        }
+        jobCount++;
+
+        foreach( const rsAlignedTask &task, alignTasks(job) ) {
+            taskCounts[task.first]++;
+
+            ids.clear();
+            QHash<QString, rsArgumentSnapshot> arguments = RSJobComparison::indexArguments(task.second, ids);
+            foreach( const QString &id, ids ) {
+                QString option = optionId(task.first, id);
+                QHash<QString, rsOptionCounts>::iterator it = options.find(option);
+                if ( it == options.end() ) {
+                    rsOptionCounts counts;
+                    counts.task = task.first;
+                    counts.key = arguments[id].key;
+                    counts.present = 0;
+                    counts.usualCount = 0;
+                    it = options.insert(option, counts);
+                }
+                it->values[formatValue(arguments[id])]++;
+                it->present++;
+            }
+        }
+    }
+
+    // arguments where a large majority agrees, but not all jobs
+    QHash<QString, QStringList> deviatingOptions;
+    for ( QHash<QString, rsOptionCounts>::iterator it = options.begin(); it != options.end(); ++it ) {
+        const int total = taskCounts[it->task];
+        it->usual = missingValue();
+        it->usualCount = total - it->present;
+
+        for ( QHash<QString, int>::const_iterator v = it->values.constBegin(); v != it->values.constEnd(); ++v ) {
+            if ( v.value() > it->usualCount ) {
+                it->usual = v.key();
+                it->usualCount = v.value();
+            }
+        }
+
+        if ( it->usualCount < total && it->usualCount >= majority * total ) {
+            deviatingOptions[it->task] << it.key();
+        }
+    }
+    optionCount = options.size();
+
+    // tasks that a large majority of the jobs has or lacks
+    QStringList usualTasks, unusualTasks;
+    for ( QHash<QString, int>::const_iterator it = taskCounts.constBegin(); it != taskCounts.constEnd(); ++it ) {
+        if ( it.value() < jobCount && it.value() >= majority * jobCount ) {
+            usualTasks << it.key();
+        } else if ( jobCount - it.value() >= majority * jobCount ) {
+            unusualTasks << it.key();
+        }
+    }
+
+    // compare every job with the majority
+    QStringList paths = jobs.keys();
+    paths.sort();
+    foreach( const QString &path, paths ) {
+        const rsIndexedJob &job = jobs[path];
+        if ( ! job.readable ) {
+            continue;
+        }
+
+        QSet<QString> tasks;
+        foreach( const rsAlignedTask &task, alignTasks(job) ) {
+            tasks.insert(task.first);
+
+            if ( unusualTasks.contains(task.first) ) {
+                rsConsistencyIssue issue;
+                issue.path = path;
+                issue.task = task.first;
+                issue.value = QString("(present)");
+                issue.usual = missingValue();
+                issue.total = jobCount;
+                issue.usualCount = jobCount - taskCounts[task.first];
+                issues << issue;
+            }
+
+            QHash<QString, QStringList>::const_iterator deviating = deviatingOptions.constFind(task.first);
+            if ( deviating == deviatingOptions.constEnd() ) {
+                continue;
+            }
+
+            ids.clear();
+            QHash<QString, rsArgumentSnapshot> arguments = RSJobComparison::indexArguments(task.second, ids);
+            foreach( const QString &option, deviating.value() ) {
+                const rsOptionCounts &counts = options[option];
+                const QString id = option.mid(task.first.size() + 1);
+                const QString value = arguments.contains(id) ? formatValue(arguments[id]) : missingValue();
+                if ( value == counts.usual ) {
+                    continue;
+                }
+
+                rsConsistencyIssue issue;
+                issue.path = path;
+                issue.task = task.first;
+                issue.key = counts.key;
+                issue.value = value;
+                issue.usual = counts.usual;
+                issue.usualCount = counts.usualCount;
+                issue.total = taskCounts[task.first];
+                issues << issue;
+            }
+        }
+
+        foreach( const QString &task, usualTasks ) {
+            if ( ! tasks.contains(task) ) {
+                rsConsistencyIssue issue;
+                issue.path = path;
+                issue.task = task;
+                issue.value = missingValue();
+                issue.usual = QString("(present)");
+                issue.total = jobCount;
+                issue.usualCount = taskCounts[task];
+                issues << issue;
+            }
+        }
+    }
+}
+
+int RSStudyConsistency::getJobCount() const
+{
+    return jobCount;
+}
+
+int RSStudyConsistency::getCheckedOptionCount() const
+{
+    return optionCount;
+}
+
+// Ordered by job
+QList<rsConsistencyIssue> RSStudyConsistency::getIssues() const
+{
+    return issues;
+}
+
+// One line per issue with a header line, as printed by rsjobeditor --consistency
+QStringList RSStudyConsistency::toTsv() const
+{
+    QStringList lines;
+    lines << QString("job\ttask\targument\tvalue\tusual\tusualJobs\tjobs");
+
+    foreach( const rsConsistencyIssue &issue, issues ) {
+        QStringList fields;
+        fields << issue.path << issue.task << issue.key << issue.value << issue.usual
+               << QString::number(issue.usualCount) << QString::number(issue.total);
+        for ( int i=0; i<fields.size(); i++ ) {
+            fields[i].replace('\t', ' ').replace('\n', ' ');
+        }
+        lines << fields.join("\t");
+    }
+
+    return lines;
+}
+
+QString RSStudyConsistency::missingValue()
+{
+    return QString("(none)");
+}
+
+QList<QByteArray> RSStudyConsistency::taskCodes(const rsIndexedJob &job)
+{
+    QList<QByteArray> codes;
+    foreach( const rsTaskSnapshot &task, job.tasks ) {
+        codes << task.code.toUtf8();
+    }
+    return codes;
+}
+
+/*
+ * Takes the sequence of tools that most jobs share as the one all jobs are
+ * aligned with. Later uses of the same tool in it are numbered.
+ */
+void RSStudyConsistency::chooseReference(const QHash<QString, rsIndexedJob> &jobs)
+{
+    QHash<QByteArray, int> sequences;
+    foreach( const rsIndexedJob &job, jobs ) {
+        if ( ! job.readable ) {
+            continue;
+        }
+
+        QByteArray sequence;
+        foreach( const rsTaskSnapshot &task, job.tasks ) {
+            sequence += task.code.toUtf8();
+            sequence += '\n';
+        }
+        sequences[sequence]++;
+    }
+
+    // ties go to the first sequence in sort order, so the result does not
+    // depend on the order of the hash
+    QByteArray best;
+    int bestCount = 0;
+    for ( QHash<QByteArray, int>::const_iterator it = sequences.constBegin(); it != sequences.constEnd(); ++it ) {
+        if ( it.value() > bestCount || (it.value() == bestCount && it.key() < best) ) {
+            best = it.key();
+            bestCount = it.value();
+        }
+    }
+
+    reference.clear();
+    referenceNames.clear();
+    if ( best.isEmpty() ) {
+        return;
+    }
+
+    QHash<QByteArray, int> uses;
+    best.chop(1);
+    foreach( const QByteArray &code, best.split('\n') ) {
+        const int use = ++uses[code];
+        const QString name = QString::fromUtf8(code);
+        reference << code;
+        referenceNames << (use == 1 ? name : QString("%1 #%2").arg(name).arg(use));
+    }
+}
+
+/*
+ * The tasks of a job named by the task of the most common sequence they
+ * are aligned with. Tasks without a counterpart there are named as extra
+ * uses of their tool. The job arguments come first as a task of their own.
+ */
+QList<rsAlignedTask> RSStudyConsistency::alignTasks(const rsIndexedJob &job) const
+{
+    QList<rsAlignedTask> result;
+    result << rsAlignedTask(QString("job arguments"), job.arguments);
+
+    const QList<int> matches = RSJobDiff::matchSequences(reference, taskCodes(job));
+
+    QHash<QString, int> extraUses;
+    for ( int i=0; i<job.tasks.size(); i++ ) {
+        const rsTaskSnapshot &task = job.tasks[i];
+        QString name;
+        if ( matches[i] >= 0 ) {
+            name = referenceNames[matches[i]];
+        } else {
+            const int use = ++extraUses[task.code];
+            name = use == 1 ? QString("%1 (extra)").arg(task.code) : QString("%1 (extra #%2)").arg(task.code).arg(use);
+        }
+        result << rsAlignedTask(name, task.arguments);
+    }
+
+    return result;
+}
+
+QString RSStudyConsistency::formatValue(const rsArgumentSnapshot &argument)
+{
+    return argument.hasValue ? argument.value : QString("(set)");
+}
+
+}}} // namespace rstools::batch::util
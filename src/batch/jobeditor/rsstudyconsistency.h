@@ -0,0 +1,66 @@
+#ifndef rstools_rsbatch_jobeditor_rsstudyconsistency_h
+#define rstools_rsbatch_jobeditor_rsstudyconsistency_h
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include "rsstudyindex.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    QString path;
+    QString task;            // e.g. "rsbandpass", "rsbandpass #2" for its second use or "rsbandpass (extra)"
+    QString key;             // empty if the job lacks the task or has an extra one
+    QString value;           // of this job
+    QString usual;           // of the majority of the jobs
+    int usualCount;          // jobs with the usual value
+    int total;               // jobs that have the task
+} rsConsistencyIssue;
+
+/*
+ * Compares the settings of all jobs of a study index. The tools of every
+ * job are aligned with the most common sequence of tools in the study the
+ * way RSJobDiff aligns two versions of a job, so jobs that gained or lost
+ * a task still line up. Tasks that have no counterpart in that sequence
+ * count as extra. For every argument the values of all jobs are counted,
+ * and a job is reported if it deviates from a value that at least the
+ * given share of the jobs agree on. Arguments that differ from subject to
+ * subject, like input files, have no such majority and are left alone.
+ * The counts are taken from the tasks and arguments that the index holds
+ * in memory, the job files are not read again. The share has to be above
+ * one half and at most one.
+ */
+class RSStudyConsistency
+{
+public:
+    explicit RSStudyConsistency(const RSStudyIndex &index, double majority = 0.9);
+
+    int getJobCount() const;
+    int getCheckedOptionCount() const;
+    QList<rsConsistencyIssue> getIssues() const;
+    QStringList toTsv() const;
+
+    static QString missingValue();
+
+protected:
+    void chooseReference(const QHash<QString, rsIndexedJob> &jobs);
+    QList<QPair<QString, QList<rsArgumentSnapshot> > > alignTasks(const rsIndexedJob &job) const;
+    static QList<QByteArray> taskCodes(const rsIndexedJob &job);
+    static QString formatValue(const rsArgumentSnapshot &argument);
+
+    int jobCount;
+    int optionCount;
+    QList<QByteArray> reference;     // tools of the most common sequence
+    QStringList referenceNames;      // and their aligned names
+    QList<rsConsistencyIssue> issues;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,442 @@
+#include "rsstudyindex.h"
+#include "rsjobdocument.h"
+#include "rsjobutils.h"
+#include "rsrunhistory.h"
+#include "utils/rsstring.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QSet>
+#include <glib.h>
+#include <exception>
+#include <vector>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+static const quint32 indexMagic = 0x52534958; // "RSIX"
+
+typedef enum {
+    TERM_CODE = 0,
+    TERM_ARGUMENT,
+    TERM_WORD
+} rsIndexTermType;
+
+typedef struct {
+    rsIndexTermType type;
+    QString key;
+    QRegExp pattern;
+    QString word;
+} rsIndexTerm;
+
+static void writeArguments(QDataStream &out, const QList<rsArgumentSnapshot> &arguments)
+{
+    out << (quint32)arguments.size();
+    foreach( const rsArgumentSnapshot &argument, arguments ) {
+        out << argument.key << argument.value << argument.hasValue;
+    }
+}
+
+static void readArguments(QDataStream &in, QList<rsArgumentSnapshot> &arguments)
+{
+    quint32 n = 0;
+    in >> n;
+    for ( quint32 i=0; i<n && in.status() == QDataStream::Ok; i++ ) {
+        rsArgumentSnapshot argument;
+        in >> argument.key >> argument.value >> argument.hasValue;
+        arguments << argument;
+    }
+}
+
+/*
+ * Whether all terms match within the given arguments. The key and value
+ * of the first argument that a term matched are passed back to show it.
+ */
+static bool matchTerms(const QList<rsIndexTerm> &terms, const QString &code, const QList<rsArgumentSnapshot> &arguments, QString &key, QString &value)
+{
+    foreach( const rsIndexTerm &term, terms ) {
+        if ( term.type == TERM_CODE ) {
+            if ( ! term.pattern.exactMatch(code) ) {
+                return false;
+            }
+            continue;
+        }
+
+        bool found = false;
+        foreach( const rsArgumentSnapshot &argument, arguments ) {
+            found = term.type == TERM_ARGUMENT
+                ? argument.key == term.key && term.pattern.exactMatch(argument.value)
+                : argument.value.contains(term.word, Qt::CaseInsensitive);
+            if ( found ) {
+                if ( key.isEmpty() ) {
+                    key = argument.key;
+                    value = argument.value;
+                }
+                break;
+            }
+        }
+        if ( ! found ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+RSStudyIndex::RSStudyIndex(const QString &root)
+{
+    this->root = QFileInfo(root).absoluteFilePath();
+}
+
+QString RSStudyIndex::getRoot() const
+{
+    return root;
+}
+
+int RSStudyIndex::getJobCount() const
+{
+    return jobs.size();
+}
+
+int RSStudyIndex::getUnreadableCount() const
+{
+    int count = 0;
+    foreach( const rsIndexedJob &job, jobs ) {
+        if ( ! job.readable ) {
+            count++;
+        }
+    }
+    return count;
+}
+
+const QHash<QString, rsIndexedJob>& RSStudyIndex::getJobs() const
+{
+    return jobs;
+}
+
+// One index file per directory, named after the hash of its absolute path
+QString RSStudyIndex::getPath() const
+{
+    QString directory = RSRunHistory::getDataDirectory() + QString("/index");
+    QDir().mkpath(directory);
+
+    QByteArray p = root.toUtf8();
+    gchar *name = g_compute_checksum_for_data(G_CHECKSUM_SHA256, (const guchar*)p.data(), p.size());
+    QString result = directory + QString("/") + QString(name) + QString(".idx");
+    g_free(name);
+    return result;
+}
+
+// Reads the saved index, returns false if there is none that can be used
+bool RSStudyIndex::load()
+{
+    jobs.clear();
+
+    QFile file(getPath());
+    if ( ! file.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0, fileVersion = 0, n = 0;
+    QString indexedRoot;
+    in >> magic >> fileVersion >> indexedRoot >> n;
+    if ( magic != indexMagic || fileVersion != version || indexedRoot != root ) {
+        return false;
+    }
+
+    for ( quint32 i=0; i<n && in.status() == QDataStream::Ok; i++ ) {
+        rsIndexedJob job;
+        quint32 nTasks = 0;
+        in >> job.path >> job.mtime >> job.size >> job.readable;
+        readArguments(in, job.arguments);
+
+        in >> nTasks;
+        for ( quint32 t=0; t<nTasks && in.status() == QDataStream::Ok; t++ ) {
+            rsTaskSnapshot task;
+            in >> task.code >> task.description;
+            readArguments(in, task.arguments);
+            job.tasks << task;
+        }
+
+        jobs.insert(job.path, job);
+    }
+
+    if ( in.status() != QDataStream::Ok ) {
+        jobs.clear();
+        return false;
+    }
+    return true;
+}
+
+void RSStudyIndex::save()
+{
+    QString path = getPath();
+    QString temporaryPath = path + QString(".tmp");
+
+    QFile file(temporaryPath);
+    if ( ! file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << indexMagic << version << root << (quint32)jobs.size();
+
+    foreach( const rsIndexedJob &job, jobs ) {
+        out << job.path << job.mtime << job.size << job.readable;
+        writeArguments(out, job.arguments);
+
+        out << (quint32)job.tasks.size();
+        foreach( const rsTaskSnapshot &task, job.tasks ) {
+            out << task.code << task.description;
+            writeArguments(out, task.arguments);
+        }
+    }
+
+    const bool written = out.status() == QDataStream::Ok;
+    file.close();
+
+    if ( ! written ) {
+        QFile::remove(temporaryPath);
+        return;
+    }
+
+    QFile::remove(path);
+    QFile::rename(temporaryPath, path);
+}
+
+bool RSStudyIndex::readJob(const QString &path, rsIndexedJob &job)
+{
+    QByteArray p = path.toLocal8Bit();
+    RSJobParser *parser = NULL;
+    RSJob *parsed = NULL;
+
+    try {
+        parser = new RSJobParser(rsString(p.data()));
+        parser->parse();
+        parsed = parser->getJob();
+
+        vector<rsArgument*> arguments = parsed->getArguments();
+        for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+            job.arguments << RSJobDocument::copyArgument(*it);
+        }
+
+        vector<RSTask*> tasks = parsed->getTasks();
+        for (vector<RSTask*>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+            job.tasks << *RSJobDocument::copyTask(*it);
+        }
+
+        delete parsed;
+        delete parser;
+    } catch (...) {
+        delete parsed;
+        delete parser;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Finds the jobs that are new or were touched since the last update and
+ * those that are gone, without changing the index.
+ */
+void RSStudyIndex::scan(QList<rsIndexedJob> &pending, QStringList &gone) const
+{
+    QSet<QString> seen;
+
+    QDirIterator it(root, QStringList() << QString("*.job"), QDir::Files, QDirIterator::Subdirectories);
+    while ( it.hasNext() ) {
+        QString path = it.next();
+        QFileInfo info = it.fileInfo();
+        seen.insert(path);
+
+        const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+        const qint64 size = info.size();
+        QHash<QString, rsIndexedJob>::const_iterator indexed = jobs.constFind(path);
+        if ( indexed != jobs.constEnd() && indexed->mtime == mtime && indexed->size == size ) {
+            continue;
+        }
+
+        rsIndexedJob job;
+        job.path = path;
+        job.mtime = mtime;
+        job.size = size;
+        job.readable = false;
+        pending << job;
+    }
+
+    foreach( const QString &path, jobs.keys() ) {
+        if ( ! seen.contains(path) ) {
+            gone << path;
+        }
+    }
+}
+
+/*
+ * Reads the files of the jobs into the page cache, several at a time, as
+ * most of the time goes into waiting for the file server. Safe to call
+ * from any thread, unlike read().
+ */
+void RSStudyIndex::prefetch(const QList<rsIndexedJob> &pending, volatile bool *cancelled)
+{
+    const long n = (long)pending.size();
+    #pragma omp parallel for schedule(dynamic, 16)
+    for ( long i=0; i<n; i++ ) {
+        if ( cancelled == NULL || ! *cancelled ) {
+            rsJobPrefetchFile(pending.at(i).path);
+        }
+    }
+}
+
+void RSStudyIndex::remove(const QStringList &paths)
+{
+    foreach( const QString &path, paths ) {
+        jobs.remove(path);
+    }
+}
+
+/*
+ * Parses a job that scan() found and adds it to the index. Unreadable jobs
+ * are kept as well, so they are only tried again once touched. Has to be
+ * called from the GUI thread, RSJobParser and the task factory are not
+ * known to be thread-safe.
+ */
+void RSStudyIndex::read(rsIndexedJob &job)
+{
+    job.readable = readJob(job.path, job);
+    jobs.insert(job.path, job);
+}
+
+/*
+ * Reads the jobs that are new or were touched since the last update and
+ * forgets those that are gone. The plugins have to be loaded beforehand,
+ * see RSToolIndex::build().
+ */
+void RSStudyIndex::update(int &read, int &removed)
+{
+    QList<rsIndexedJob> pending;
+    QStringList gone;
+    scan(pending, gone);
+
+    remove(gone);
+    removed = gone.size();
+
+    prefetch(pending);
+    for ( int i=0; i<pending.size(); i++ ) {
+        this->read(pending[i]);
+    }
+    read = pending.size();
+}
+
+QList<rsIndexMatch> RSStudyIndex::query(const QString &text, int limit) const
+{
+    QList<rsIndexTerm> terms;
+    bool hasCode = false;
+
+    foreach( const QString &word, text.split(QRegExp("\\s+"), QString::SkipEmptyParts) ) {
+        rsIndexTerm term;
+        const int equals = word.indexOf('=');
+
+        if ( word.startsWith("code:") ) {
+            term.type = TERM_CODE;
+            term.pattern = QRegExp(word.mid(5), Qt::CaseInsensitive, QRegExp::Wildcard);
+            hasCode = true;
+        } else if ( equals > 0 ) {
+            term.type = TERM_ARGUMENT;
+            term.key = word.left(equals);
+            term.pattern = QRegExp(word.mid(equals + 1), Qt::CaseSensitive, QRegExp::Wildcard);
+        } else {
+            term.type = TERM_WORD;
+            term.word = word;
+        }
+        terms << term;
+    }
+
+    QList<rsIndexMatch> matches;
+    if ( terms.isEmpty() ) {
+        return matches;
+    }
+
+    QStringList paths = jobs.keys();
+    paths.sort();
+
+    foreach( const QString &path, paths ) {
+        const rsIndexedJob &job = jobs[path];
+        rsIndexMatch match;
+        match.path = path;
+
+        if ( ! hasCode && matchTerms(terms, QString(), job.arguments, match.key, match.value) ) {
+            match.taskIndex = -1;
+            match.task = QString("Job arguments");
+            matches << match;
+        }
+
+        for ( int t=0; t<job.tasks.size(); t++ ) {
+            const rsTaskSnapshot &task = job.tasks.at(t);
+            match.key = QString();
+            match.value = QString();
+            if ( ! matchTerms(terms, task.code, task.arguments, match.key, match.value) ) {
+                continue;
+            }
+            match.taskIndex = t;
+            match.task = QString("%1. %2 (%3)").arg(t + 1).arg(task.description).arg(task.code);
+            matches << match;
+        }
+
+        if ( matches.size() >= limit ) {
+            break;
+        }
+    }
+
+    return matches;
+}
+
+RSStudyIndexThread::RSStudyIndexThread(const RSStudyIndex &index, QObject *parent) : QThread(parent), index(index)
+{
+    cancelled = false;
+}
+
+QList<rsIndexedJob> RSStudyIndexThread::getPending()
+{
+    return pending;
+}
+
+QStringList RSStudyIndexThread::getGone()
+{
+    return gone;
+}
+
+// Empty if the index was scanned
+QString RSStudyIndexThread::getError()
+{
+    return error;
+}
+
+// Skips the files that have not been read yet
+void RSStudyIndexThread::cancel()
+{
+    cancelled = true;
+}
+
+void RSStudyIndexThread::run()
+{
+    try {
+        index.scan(pending, gone);
+        RSStudyIndex::prefetch(pending, &cancelled);
+    } catch (const exception& e) {
+        error = QString::fromUtf8(e.what());
+    }
+}
+
+}}} // namespace rstools::batch::util
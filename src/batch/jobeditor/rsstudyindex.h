@@ -0,0 +1,104 @@
+#ifndef rstools_rsbatch_jobeditor_rsstudyindex_h
+#define rstools_rsbatch_jobeditor_rsstudyindex_h
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    QString path;
+    qint64 mtime;
+    qint64 size;
+    bool readable;
+    QList<rsArgumentSnapshot> arguments;
+    QList<rsTaskSnapshot> tasks;
+} rsIndexedJob;
+
+typedef struct {
+    QString path;
+    int taskIndex;           // -1 for a job argument
+    QString task;            // description and tool of the task
+    QString key;             // argument that matched, empty if only the tool did
+    QString value;
+} rsIndexMatch;
+
+/*
+ * Index of the tasks and arguments of all job files below a directory,
+ * e.g. of a whole study, kept in the editor's data directory. Updating it
+ * only reads the jobs that were added or touched since the last update.
+ * Their files are fetched several at a time, they are parsed one by one.
+ *
+ * A query consists of terms that all have to match within the same task:
+ * "code:rsbandpass" for the tool, "key=value" for an argument, where the
+ * value may contain * and ? wildcards, and plain words that are looked for
+ * in the values of all arguments. Job arguments are searched as well if
+ * the query does not ask for a tool.
+ */
+class RSStudyIndex
+{
+public:
+    explicit RSStudyIndex(const QString &root);
+
+    QString getRoot() const;
+    int getJobCount() const;
+    int getUnreadableCount() const;
+    const QHash<QString, rsIndexedJob>& getJobs() const;
+
+    bool load();
+    void update(int &read, int &removed);
+    void save();
+
+    void scan(QList<rsIndexedJob> &pending, QStringList &gone) const;
+    static void prefetch(const QList<rsIndexedJob> &pending, volatile bool *cancelled = NULL);
+    void remove(const QStringList &paths);
+    void read(rsIndexedJob &job);
+
+    QList<rsIndexMatch> query(const QString &text, int limit = 10000) const;
+
+    static const quint32 version = 1;
+
+protected:
+    QString getPath() const;
+    static bool readJob(const QString &path, rsIndexedJob &job);
+
+    QString root;
+    QHash<QString, rsIndexedJob> jobs;
+};
+
+/*
+ * Finds what changed below the directory of an index and reads those job
+ * files into the page cache in the background. It works on a copy of the
+ * index, the jobs are parsed into the index itself in the GUI thread, see
+ * RSStudyIndex::read().
+ */
+class RSStudyIndexThread : public QThread
+{
+    Q_OBJECT
+public:
+    RSStudyIndexThread(const RSStudyIndex &index, QObject *parent = 0);
+
+    QList<rsIndexedJob> getPending();
+    QStringList getGone();
+    QString getError();
+    void cancel();
+
+protected:
+    void run();
+
+    RSStudyIndex index;
+    QList<rsIndexedJob> pending;
+    QStringList gone;
+    QString error;
+    volatile bool cancelled;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
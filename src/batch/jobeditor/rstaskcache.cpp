@@ -0,0 +1,534 @@
+#include "rstaskcache.h"
+#include "rsjobutils.h"
+#include "rsrunhistory.h"
+#include "rstoolindex.h"
+#include "rsuioptionutils.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSet>
+#include <QSettings>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <glib.h>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+RSTaskCacheCheck::RSTaskCacheCheck(const QList<rsTaskCacheDescriptor>& tasks, bool chain, QObject *parent) : QThread(parent)
+{
+    this->tasks = tasks;
+    this->chain = chain;
+    cancelled = false;
+}
+
+QList<rsTaskCacheResult> RSTaskCacheCheck::getResults()
+{
+    return results;
+}
+
+// Stops before the next task, the results end with the last checked task
+void RSTaskCacheCheck::cancel()
+{
+    cancelled = true;
+}
+
+void RSTaskCacheCheck::run()
+{
+    RSTaskCache &cache = RSTaskCache::getInstance();
+    QSet<QString> produced;
+
+    for ( int i=0; i<tasks.size() && ! cancelled; i++ ) {
+        const rsTaskCacheDescriptor &task = tasks.at(i);
+        rsTaskCacheResult result;
+        result.hit = false;
+
+        bool dependsOnRun = false;
+        if ( chain ) {
+            foreach( const QString &input, task.inputs ) {
+                if ( produced.contains(input) ) {
+                    dependsOnRun = true;
+                    result.reason = QString("Reads '%1', which is written by an earlier task that runs").arg(input);
+                    break;
+                }
+            }
+        }
+
+        if ( ! dependsOnRun ) {
+            result.key = cache.computeKey(task, result.reason);
+            if ( ! result.key.isEmpty() ) {
+                result.hit = cache.lookup(result.key, result.reason);
+            }
+        }
+
+        if ( ! result.hit ) {
+            foreach( const QString &output, task.outputs ) {
+                produced.insert(output);
+            }
+        }
+
+        results.append(result);
+    }
+}
+
+RSTaskCache& RSTaskCache::getInstance()
+{
+    static RSTaskCache instance;
+    return instance;
+}
+
+RSTaskCache::RSTaskCache()
+{
+    fileHashesLoaded = false;
+    fileHashLines = 0;
+}
+
+bool RSTaskCache::isEnabled()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("runqueue/useCache", true).toBool();
+}
+
+void RSTaskCache::setEnabled(bool enabled)
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("runqueue/useCache", enabled);
+}
+
+QString RSTaskCache::getDirectory()
+{
+    QString directory = RSRunHistory::getDataDirectory() + QString("/cache");
+    QDir().mkpath(directory);
+    return directory;
+}
+
+/*
+ * Collects the arguments of a task with all job arguments substituted and
+ * sorts its filenames into inputs and outputs. Has to be called from the
+ * GUI thread, the result can be handed to other threads.
+ */
+rsTaskCacheDescriptor RSTaskCache::describe(RSJob* job, RSTask* task)
+{
+    rsTaskCacheDescriptor result;
+    result.code = QString(task->getCode());
+
+    rsToolIndexEntry* entry = RSToolIndex::getInstance().findEntry(task->getCode());
+    rsUIInterface* I = entry == NULL ? NULL : entry->ui;
+
+    vector<rsArgument*> arguments = task->getArguments();
+    for (vector<rsArgument*>::iterator it = arguments.begin(); it != arguments.end(); ++it) {
+        QString name = QString((*it)->key);
+
+        if ( (*it)->value == NULL ) {
+            result.arguments << name;
+            continue;
+        }
+
+        QString value = QString::fromUtf8(rsJobResolveValue(job, (*it)->value).c_str());
+        addArgument(I, name, value, result);
+    }
+
+    result.arguments.sort();
+
+    return result;
+}
+
+/*
+ * Describes a task of a snapshot with the job arguments known to the
+ * resolver. Does not touch the job, so workers may call it as long as the
+ * tool index has been built beforehand.
+ */
+rsTaskCacheDescriptor RSTaskCache::describe(const rsTaskSnapshot& task, RSArgumentResolver& resolver)
+{
+    rsTaskCacheDescriptor result;
+    result.code = task.code;
+
+    QByteArray code = task.code.toUtf8();
+    rsToolIndexEntry* entry = RSToolIndex::getInstance().findEntry(code.data());
+    rsUIInterface* I = entry == NULL ? NULL : entry->ui;
+
+    foreach( const rsArgumentSnapshot &argument, task.arguments ) {
+        if ( ! argument.hasValue ) {
+            result.arguments << argument.key;
+            continue;
+        }
+
+        addArgument(I, argument.key, resolver.resolve(argument.value), result);
+    }
+
+    result.arguments.sort();
+
+    return result;
+}
+
+// Records a resolved argument and, if its option reads or writes a file, the file
+void RSTaskCache::addArgument(rsUIInterface* I, const QString& name, const QString& value, rsTaskCacheDescriptor& result)
+{
+    result.arguments << name + QString("=") + value;
+
+    if ( I == NULL || value.isEmpty() ) {
+        return;
+    }
+
+    QByteArray n = name.toUtf8();
+    for ( size_t i=0; i<I->nOptions; i++ ) {
+        rsUIOption* option = I->options[i];
+        if ( strcmp(option->name, n.data()) != 0 ) {
+            continue;
+        }
+
+        QString path = QFileInfo(value).absoluteFilePath();
+        if ( rsUIOptionIsOutput(option) ) {
+            result.outputs << path;
+        } else if ( rsUIOptionIsInput(option) ) {
+            result.inputs << path;
+        }
+        break;
+    }
+}
+
+QString RSTaskCache::computeKey(const rsTaskCacheDescriptor& task, QString& reason)
+{
+    if ( task.outputs.isEmpty() ) {
+        reason = QString("The task does not write any files");
+        return QString();
+    }
+
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+    QByteArray code = task.code.toUtf8();
+    g_checksum_update(checksum, (const guchar*)code.data(), code.size() + 1);
+
+    foreach( const QString &argument, task.arguments ) {
+        QByteArray a = argument.toUtf8();
+        g_checksum_update(checksum, (const guchar*)a.data(), a.size() + 1);
+    }
+
+    foreach( const QString &input, task.inputs ) {
+        QString hash = hashFile(input);
+        if ( hash.isEmpty() ) {
+            g_checksum_free(checksum);
+            reason = QString("Input '%1' cannot be read").arg(input);
+            return QString();
+        }
+        QByteArray h = hash.toLatin1();
+        g_checksum_update(checksum, (const guchar*)h.data(), h.size() + 1);
+    }
+
+    QString key = QString(g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+
+    return key;
+}
+
+/*
+ * A key is a hit if it was stored before and none of the outputs that
+ * were recorded with it have been changed or removed since.
+ */
+bool RSTaskCache::lookup(const QString& key, QString& reason)
+{
+    QFile file(getDirectory() + QString("/") + key);
+    if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+        reason = QString("Not run with these settings and inputs before");
+        return false;
+    }
+
+    QTextStream in(&file);
+    while ( ! in.atEnd() ) {
+        QStringList fields = in.readLine().split('\t');
+        if ( fields.size() < 3 ) {
+            continue;
+        }
+
+        QFileInfo info(fields.at(0));
+        if ( ! info.exists() ) {
+            reason = QString("Output '%1' no longer exists").arg(fields.at(0));
+            return false;
+        }
+        if ( info.size() != fields.at(1).toLongLong() || info.lastModified().toMSecsSinceEpoch() != fields.at(2).toLongLong() ) {
+            reason = QString("Output '%1' has been changed since").arg(fields.at(0));
+            return false;
+        }
+    }
+
+    reason = QString("Outputs of a previous run are unchanged");
+    return true;
+}
+
+void RSTaskCache::store(const QString& key, const rsTaskCacheDescriptor& task)
+{
+    QString path = getDirectory() + QString("/") + key;
+    QString temporaryPath = path + QString(".tmp");
+
+    QFile file(temporaryPath);
+    if ( ! file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) ) {
+        return;
+    }
+
+    QTextStream out(&file);
+    foreach( const QString &output, task.outputs ) {
+        QFileInfo info(output);
+        if ( ! info.exists() ) {
+            // the task did not do what it was asked to do
+            file.close();
+            QFile::remove(temporaryPath);
+            return;
+        }
+        out << output << '\t' << info.size() << '\t' << info.lastModified().toMSecsSinceEpoch() << '\n';
+    }
+    out.flush();
+    file.close();
+
+    QFile::remove(path);
+    QFile::rename(temporaryPath, path);
+}
+
+void RSTaskCache::loadFileHashes()
+{
+    if ( fileHashesLoaded ) {
+        return;
+    }
+    fileHashesLoaded = true;
+
+    QFile file(getDirectory() + QString("/files.tsv"));
+    if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+        return;
+    }
+
+    // later lines of the same file replace the earlier ones
+    QTextStream in(&file);
+    while ( ! in.atEnd() ) {
+        QStringList fields = in.readLine().split('\t');
+        fileHashLines++;
+        if ( fields.size() < 4 ) {
+            continue;
+        }
+
+        rsFileHash hash;
+        hash.size  = fields.at(1).toLongLong();
+        hash.mtime = fields.at(2).toLongLong();
+        hash.hash  = fields.at(3);
+        fileHashes.insert(unescapeField(fields.at(0)), hash);
+    }
+}
+
+// Paths may contain tabs and line breaks, which would end the field
+QString RSTaskCache::escapeField(const QString& field)
+{
+    QString result;
+    result.reserve(field.size());
+    for ( int i=0; i<field.size(); i++ ) {
+        const QChar c = field.at(i);
+        if ( c == QChar('\\') ) {
+            result += QString("\\\\");
+        } else if ( c == QChar('\t') ) {
+            result += QString("\\t");
+        } else if ( c == QChar('\n') ) {
+            result += QString("\\n");
+        } else if ( c == QChar('\r') ) {
+            result += QString("\\r");
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+QString RSTaskCache::unescapeField(const QString& field)
+{
+    QString result;
+    result.reserve(field.size());
+    for ( int i=0; i<field.size(); i++ ) {
+        const QChar c = field.at(i);
+        if ( c != QChar('\\') || i+1 == field.size() ) {
+            result += c;
+            continue;
+        }
+
+        const QChar next = field.at(++i);
+        if ( next == QChar('t') ) {
+            result += QChar('\t');
+        } else if ( next == QChar('n') ) {
+            result += QChar('\n');
+        } else if ( next == QChar('r') ) {
+            result += QChar('\r');
+        } else {
+            result += next;
+        }
+    }
+    return result;
+}
+
+/*
+ * Appends a hash to files.tsv. Every rehash of a file adds a line, so the
+ * file is rewritten with only the current hashes once most of its lines
+ * are outdated. To be called with the mutex held.
+ */
+void RSTaskCache::appendFileHash(const QString& path, const rsFileHash& hash)
+{
+    if ( fileHashLines >= 1024 && fileHashLines > 2 * fileHashes.size() ) {
+        compactFileHashes();
+        return;
+    }
+
+    QFile file(getDirectory() + QString("/files.tsv"));
+    if ( file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text) ) {
+        QTextStream out(&file);
+        out << escapeField(path) << '\t' << hash.size << '\t' << hash.mtime << '\t' << hash.hash << '\n';
+        fileHashLines++;
+    }
+}
+
+void RSTaskCache::compactFileHashes()
+{
+    QTemporaryFile file(getDirectory() + QString("/files.tsv.XXXXXX"));
+    if ( ! file.open() ) {
+        return;
+    }
+
+    QTextStream out(&file);
+    for (QHash<QString, rsFileHash>::const_iterator it = fileHashes.constBegin(); it != fileHashes.constEnd(); ++it) {
+        out << escapeField(it.key()) << '\t' << it->size << '\t' << it->mtime << '\t' << it->hash << '\n';
+    }
+    out.flush();
+
+    if ( out.status() != QTextStream::Ok ) {
+        return;
+    }
+
+    const QString path = getDirectory() + QString("/files.tsv");
+    QFile::remove(path);
+    if ( file.rename(path) ) {
+        file.setAutoRemove(false);
+        fileHashLines = fileHashes.size();
+    }
+}
+
+/*
+ * Returns the content hash of a file. Hashes are remembered along with the
+ * file's size and modification time, so a file is only read again once it
+ * has changed. Safe to call from any thread.
+ */
+QString RSTaskCache::hashFile(const QString& path)
+{
+    QFileInfo info(path);
+    if ( ! info.isFile() ) {
+        return QString();
+    }
+
+    const qint64 size  = info.size();
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+    {
+        QMutexLocker locker(&mutex);
+        loadFileHashes();
+
+        QHash<QString, rsFileHash>::const_iterator it = fileHashes.find(path);
+        if ( it != fileHashes.end() && it->size == size && it->mtime == mtime ) {
+            return it->hash;
+        }
+    }
+
+    rsFileHash hash;
+    hash.size  = size;
+    hash.mtime = mtime;
+    hash.hash  = hashFileContents(path);
+
+    if ( hash.hash.isEmpty() ) {
+        return QString();
+    }
+
+    QMutexLocker locker(&mutex);
+    fileHashes.insert(path, hash);
+    appendFileHash(path, hash);
+
+    return hash.hash;
+}
+
+/*
+ * Hashes a file that is mapped into memory in chunks of 64MB in parallel.
+ * The result is the hash of the file size and the chunk hashes, so it
+ * differs from a plain SHA-256 of the file but is just as specific.
+ */
+QString RSTaskCache::hashFileContents(const QString& path)
+{
+    QByteArray p = path.toLocal8Bit();
+    int fd = open(p.data(), O_RDONLY);
+    if ( fd < 0 ) {
+        return QString();
+    }
+
+    struct stat info;
+    if ( fstat(fd, &info) != 0 || ! S_ISREG(info.st_mode) ) {
+        close(fd);
+        return QString();
+    }
+
+    const size_t size = (size_t)info.st_size;
+
+    const guchar *data = NULL;
+    if ( size > 0 ) {
+        void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( mapping == MAP_FAILED ) {
+            close(fd);
+            return QString();
+        }
+        madvise(mapping, size, MADV_WILLNEED);
+        data = (const guchar*)mapping;
+    }
+    close(fd);
+
+    QString result = hashData(data, size);
+
+    if ( data != NULL ) {
+        munmap((void*)data, size);
+    }
+
+    return result;
+}
+
+// The hash that hashFileContents() returns for a file with these contents
+QString RSTaskCache::hashData(const guchar *data, size_t size)
+{
+    const size_t chunkSize = 64 * 1024 * 1024;
+    const long nChunks = (long)((size + chunkSize - 1) / chunkSize);
+
+    vector<string> digests(nChunks);
+
+    #pragma omp parallel for schedule(dynamic)
+    for ( long i=0; i<nChunks; i++ ) {
+        const size_t offset = (size_t)i * chunkSize;
+        const size_t length = size - offset < chunkSize ? size - offset : chunkSize;
+
+        GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+        g_checksum_update(checksum, data + offset, (gssize)length);
+        digests[i] = g_checksum_get_string(checksum);
+        g_checksum_free(checksum);
+    }
+
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    QByteArray sizeString = QByteArray::number((qint64)size);
+    g_checksum_update(checksum, (const guchar*)sizeString.data(), sizeString.size());
+    for ( long i=0; i<nChunks; i++ ) {
+        g_checksum_update(checksum, (const guchar*)digests[i].data(), digests[i].size());
+    }
+
+    QString result = QString(g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+
+    return result;
+}
+
+}}} // namespace rstools::batch::util
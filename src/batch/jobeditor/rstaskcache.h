@@ -0,0 +1,110 @@
+#ifndef rstools_rsbatch_jobeditor_rstaskcache_h
+#define rstools_rsbatch_jobeditor_rstaskcache_h
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <glib.h>
+#include "batch/util/rsjob.hpp"
+#include "batch/util/rstask.hpp"
+#include "utils/rsui.h"
+#include "rsargumentresolver.h"
+#include "rsjobsnapshot.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+// Everything about a task that determines its results, with all job
+// arguments already substituted
+typedef struct {
+    QString code;
+    QStringList arguments;   // "name=value", sorted by name
+    QStringList inputs;
+    QStringList outputs;
+} rsTaskCacheDescriptor;
+
+typedef struct {
+    QString key;             // empty if the task cannot be cached
+    bool hit;
+    QString reason;
+} rsTaskCacheResult;
+
+typedef struct {
+    qint64 size;
+    qint64 mtime;
+    QString hash;
+} rsFileHash;
+
+/*
+ * Remembers the output files of successfully executed tasks under a key
+ * that is derived from the tool, its arguments and the contents of its
+ * input files. A task whose key is known and whose recorded outputs have
+ * not been touched since does not need to run again.
+ */
+class RSTaskCache
+{
+public:
+    static RSTaskCache& getInstance();
+
+    static rsTaskCacheDescriptor describe(RSJob* job, RSTask* task);
+    static rsTaskCacheDescriptor describe(const rsTaskSnapshot& task, RSArgumentResolver& resolver);
+
+    QString computeKey(const rsTaskCacheDescriptor& task, QString& reason);
+    bool lookup(const QString& key, QString& reason);
+    void store(const QString& key, const rsTaskCacheDescriptor& task);
+
+    QString hashFile(const QString& path);
+    static QString hashFileContents(const QString& path);
+    static QString hashData(const guchar *data, size_t size);
+
+    bool isEnabled();
+    void setEnabled(bool enabled);
+
+protected:
+    RSTaskCache();
+
+    static void addArgument(rsUIInterface* I, const QString& name, const QString& value, rsTaskCacheDescriptor& result);
+
+    QString getDirectory();
+    void loadFileHashes();
+    void appendFileHash(const QString& path, const rsFileHash& hash);
+    void compactFileHashes();
+
+    static QString escapeField(const QString& field);
+    static QString unescapeField(const QString& field);
+
+    QMutex mutex;
+    bool fileHashesLoaded;
+    QHash<QString, rsFileHash> fileHashes;
+    int fileHashLines;       // lines in files.tsv, outdated ones included
+};
+
+/*
+ * Computes the cache keys of a list of tasks in the background. With
+ * chaining enabled, tasks that read what an earlier task of the list
+ * writes are expected to run whenever that earlier task runs.
+ */
+class RSTaskCacheCheck : public QThread
+{
+public:
+    RSTaskCacheCheck(const QList<rsTaskCacheDescriptor>& tasks, bool chain, QObject *parent = 0);
+
+    QList<rsTaskCacheResult> getResults();
+    void cancel();
+
+protected:
+    void run();
+
+    QList<rsTaskCacheDescriptor> tasks;
+    QList<rsTaskCacheResult> results;
+    bool chain;
+    volatile bool cancelled;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
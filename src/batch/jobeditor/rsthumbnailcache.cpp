@@ -0,0 +1,353 @@
+#include "rsthumbnailcache.h"
+#include <QMutexLocker>
+#include <QSettings>
+#include <QVector>
+#include <qnumeric.h>
+#include <algorithm>
+#include <vector>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+/*
+ * Hands out the slices of an image's first volume in increasing order.
+ * Uncompressed files are mapped, so only the pages that are actually read
+ * from are loaded. Compressed files are inflated slice by slice and stop
+ * once the last requested slice has been read.
+ */
+class RSSliceReader
+{
+public:
+    RSSliceReader()
+    {
+        map = NULL;
+        mapLength = 0;
+        file = NULL;
+    }
+
+    ~RSSliceReader()
+    {
+        if ( map != NULL ) {
+            munmap(map, mapLength);
+        }
+        if ( file != NULL ) {
+            gzclose(file);
+        }
+    }
+
+    bool open(const QString &path, bool compressed, qint64 offset, qint64 sliceBytes, qint64 slices)
+    {
+        this->offset = offset;
+        this->sliceBytes = sliceBytes;
+        QByteArray p = path.toLocal8Bit();
+
+        if ( compressed ) {
+            file = gzopen(p.data(), "rb");
+            buffer.resize((int)sliceBytes);
+            return file != NULL;
+        }
+
+        int fd = ::open(p.data(), O_RDONLY);
+        if ( fd < 0 ) {
+            return false;
+        }
+
+        struct stat info;
+        if ( fstat(fd, &info) != 0 || (qint64)info.st_size < offset + sliceBytes * slices ) {
+            ::close(fd);
+            return false;
+        }
+
+        mapLength = (size_t)info.st_size;
+        void *data = mmap(NULL, mapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if ( data == MAP_FAILED ) {
+            mapLength = 0;
+            return false;
+        }
+        map = (char*)data;
+        return true;
+    }
+
+    const char* slice(qint64 z)
+    {
+        if ( map != NULL ) {
+            return map + offset + z * sliceBytes;
+        }
+
+        if ( gzseek(file, (z_off_t)(offset + z * sliceBytes), SEEK_SET) < 0 ) {
+            return NULL;
+        }
+        if ( gzread(file, buffer.data(), (unsigned int)sliceBytes) != (int)sliceBytes ) {
+            return NULL;
+        }
+        return buffer.constData();
+    }
+
+protected:
+    char *map;
+    size_t mapLength;
+    gzFile file;
+    QByteArray buffer;
+    qint64 offset;
+    qint64 sliceBytes;
+};
+
+// Bytes per voxel of the datatypes that can be shown, 0 for all others
+static int datatypeSize(int datatype)
+{
+    switch ( datatype ) {
+        case 2:   return sizeof(quint8);
+        case 4:   return sizeof(qint16);
+        case 8:   return sizeof(qint32);
+        case 16:  return sizeof(float);
+        case 64:  return sizeof(double);
+        case 256: return sizeof(qint8);
+        case 512: return sizeof(quint16);
+        case 768: return sizeof(quint32);
+        default:  return 0;
+    }
+}
+
+template <typename T>
+static double readVoxelAs(const char *p, bool swap)
+{
+    T value;
+    char *bytes = (char*)&value;
+    memcpy(bytes, p, sizeof(T));
+    if ( swap ) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+    return (double)value;
+}
+
+static double readVoxel(const char *p, int datatype, bool swap)
+{
+    switch ( datatype ) {
+        case 2:   return readVoxelAs<quint8>(p, swap);
+        case 4:   return readVoxelAs<qint16>(p, swap);
+        case 8:   return readVoxelAs<qint32>(p, swap);
+        case 16:  return readVoxelAs<float>(p, swap);
+        case 64:  return readVoxelAs<double>(p, swap);
+        case 256: return readVoxelAs<qint8>(p, swap);
+        case 512: return readVoxelAs<quint16>(p, swap);
+        case 768: return readVoxelAs<quint32>(p, swap);
+        default:  return 0.0;
+    }
+}
+
+// Draws a slice with its first row at the bottom, so that superior and
+// anterior point up
+static void paintSlice(QImage &image, int left, const QVector<double> &values, int width, int height, double low, double high)
+{
+    for ( int r=0; r<height; r++ ) {
+        QRgb *line = (QRgb*)image.scanLine(height - 1 - r);
+        for ( int c=0; c<width; c++ ) {
+            double v = values[r * width + c];
+            int gray = 0;
+            if ( qIsFinite(v) ) {
+                gray = (int)(255.0 * (v - low) / (high - low));
+                gray = qBound(0, gray, 255);
+            }
+            line[left + c] = qRgb(gray, gray, gray);
+        }
+    }
+}
+
+RSThumbnailTask::RSThumbnailTask(RSThumbnailCache *cache, const QString &path, const rsNiftiHeader &header)
+{
+    this->cache  = cache;
+    this->path   = path;
+    this->header = header;
+}
+
+void RSThumbnailTask::run()
+{
+    QImage image;
+    if ( ! RSThumbnailCache::decode(path, header, image) ) {
+        // remembered as well, so that broken files are not read over and over
+        image = QImage();
+    }
+    cache->insert(RSThumbnailCache::getKey(path, header), image);
+    emit cache->thumbnailReady(path);
+}
+
+RSThumbnailCache& RSThumbnailCache::getInstance()
+{
+    static RSThumbnailCache instance;
+    return instance;
+}
+
+RSThumbnailCache::RSThumbnailCache() : QObject(0)
+{
+    pool.setMaxThreadCount(2);
+    thumbnails.setMaxCost(getCacheSize() * 1024);
+}
+
+RSThumbnailCache::~RSThumbnailCache()
+{
+    pool.waitForDone();
+}
+
+// The limit for all thumbnails in MB
+int RSThumbnailCache::getCacheSize()
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    return settings.value("thumbnails/cacheSize", 32).toInt();
+}
+
+void RSThumbnailCache::setCacheSize(int megabytes)
+{
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("thumbnails/cacheSize", megabytes);
+
+    QMutexLocker locker(&mutex);
+    thumbnails.setMaxCost(megabytes * 1024);
+}
+
+QString RSThumbnailCache::getKey(const QString &path, const rsNiftiHeader &header)
+{
+    return QString("%1\t%2\t%3").arg(path).arg(header.mtime).arg(header.fileSize);
+}
+
+bool RSThumbnailCache::lookup(const QString &path, const rsNiftiHeader &header, QImage &image)
+{
+    QMutexLocker locker(&mutex);
+    QImage *thumbnail = thumbnails.object(getKey(path, header));
+
+    if ( thumbnail == NULL ) {
+        return false;
+    }
+
+    image = *thumbnail;
+    return true;
+}
+
+void RSThumbnailCache::request(const QString &path, const rsNiftiHeader &header)
+{
+    QString key = getKey(path, header);
+    QMutexLocker locker(&mutex);
+
+    if ( pending.contains(key) ) {
+        return;
+    }
+
+    pending.insert(key);
+    pool.start(new RSThumbnailTask(this, path, header));
+}
+
+void RSThumbnailCache::insert(const QString &key, const QImage &image)
+{
+    // costs are counted in kB
+    int cost = qMax(1, image.byteCount() / 1024);
+
+    QMutexLocker locker(&mutex);
+    thumbnails.insert(key, new QImage(image), cost);
+    pending.remove(key);
+}
+
+/*
+ * Reads the center slices of the first volume, taking only every n-th
+ * voxel along each axis so that no slice is larger than the thumbnail.
+ * The gray values are windowed between the 2nd and 98th percentile.
+ */
+bool RSThumbnailCache::decode(const QString &path, const rsNiftiHeader &header, QImage &image)
+{
+    // the voxel size comes from the datatype that readVoxel() goes by, a
+    // header whose bitpix disagrees with it is not trusted at all
+    const int bytesPerVoxel = datatypeSize(header.datatype);
+    if ( ! header.valid || header.dim[0] < 2 || bytesPerVoxel == 0 || header.bitpix != bytesPerVoxel * 8 ) {
+        return false;
+    }
+
+    const qint64 nx = qMax((qint64)1, header.dim[1]);
+    const qint64 ny = qMax((qint64)1, header.dim[2]);
+    const qint64 nz = header.dim[0] >= 3 ? qMax((qint64)1, header.dim[3]) : 1;
+
+    const qint64 step = qMax((qint64)1, (qMax(nx, qMax(ny, nz)) + sliceSize - 1) / sliceSize);
+    const int wx = (int)((nx + step - 1) / step);
+    const int wy = (int)((ny + step - 1) / step);
+    const int wz = (int)((nz + step - 1) / step);
+
+    QVector<double> axial(wx * wy), coronal(wx * wz), sagittal(wy * wz);
+
+    RSSliceReader reader;
+    if ( ! reader.open(RSNiftiHeaderCache::getDataPath(path), header.compressed, header.voxelOffset, nx * ny * bytesPerVoxel, nz) ) {
+        return false;
+    }
+
+    const qint64 xCenter = nx / 2;
+    const qint64 yCenter = ny / 2;
+    const qint64 zCenter = nz / 2;
+
+    for ( qint64 z=0; z<nz; z++ ) {
+        const bool sampled = z % step == 0;
+        if ( ! sampled && z != zCenter ) {
+            continue;
+        }
+
+        const char *slice = reader.slice(z);
+        if ( slice == NULL ) {
+            return false;
+        }
+
+        if ( z == zCenter ) {
+            for ( qint64 y=0; y<ny; y+=step ) {
+                for ( qint64 x=0; x<nx; x+=step ) {
+                    axial[(int)(y / step) * wx + (int)(x / step)] =
+                        readVoxel(slice + (y * nx + x) * bytesPerVoxel, header.datatype, header.swapped);
+                }
+            }
+        }
+
+        if ( sampled ) {
+            const int row = (int)(z / step);
+            for ( qint64 x=0; x<nx; x+=step ) {
+                coronal[row * wx + (int)(x / step)] =
+                    readVoxel(slice + (yCenter * nx + x) * bytesPerVoxel, header.datatype, header.swapped);
+            }
+            for ( qint64 y=0; y<ny; y+=step ) {
+                sagittal[row * wy + (int)(y / step)] =
+                    readVoxel(slice + (y * nx + xCenter) * bytesPerVoxel, header.datatype, header.swapped);
+            }
+        }
+    }
+
+    std::vector<double> values;
+    values.reserve(axial.size() + coronal.size() + sagittal.size());
+    for ( int i=0; i<axial.size(); i++ )    if ( qIsFinite(axial[i]) )    values.push_back(axial[i]);
+    for ( int i=0; i<coronal.size(); i++ )  if ( qIsFinite(coronal[i]) )  values.push_back(coronal[i]);
+    for ( int i=0; i<sagittal.size(); i++ ) if ( qIsFinite(sagittal[i]) ) values.push_back(sagittal[i]);
+
+    if ( values.empty() ) {
+        return false;
+    }
+
+    std::vector<double>::iterator lowIt = values.begin() + values.size() * 2 / 100;
+    std::nth_element(values.begin(), lowIt, values.end());
+    const double low = *lowIt;
+    std::vector<double>::iterator highIt = values.begin() + values.size() * 98 / 100;
+    std::nth_element(values.begin(), highIt, values.end());
+    const double high = *highIt > low ? *highIt : low + 1.0;
+
+    // sagittal, coronal and axial next to each other
+    const int gap = 2;
+    image = QImage(wy + wx + wx + 2 * gap, qMax(wz, wy), QImage::Format_RGB32);
+    image.fill(qRgb(0, 0, 0));
+    paintSlice(image, 0, sagittal, wy, wz, low, high);
+    paintSlice(image, wy + gap, coronal, wx, wz, low, high);
+    paintSlice(image, wy + wx + 2 * gap, axial, wx, wy, low, high);
+
+    return true;
+}
+
+}}} // namespace rstools::batch::util
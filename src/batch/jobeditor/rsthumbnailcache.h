@@ -0,0 +1,77 @@
+#ifndef rstools_rsbatch_jobeditor_rsthumbnailcache_h
+#define rstools_rsbatch_jobeditor_rsthumbnailcache_h
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QSet>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QRunnable>
+#include "rsniftiheader.h"
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+class RSThumbnailCache;
+
+class RSThumbnailTask : public QRunnable
+{
+public:
+    RSThumbnailTask(RSThumbnailCache *cache, const QString &path, const rsNiftiHeader &header);
+    void run();
+
+protected:
+    RSThumbnailCache *cache;
+    QString path;
+    rsNiftiHeader header;
+};
+
+/*
+ * Sagittal, coronal and axial center slices of the first volume of an
+ * image, shared by all SettingWidgets. The slices are downsampled while
+ * they are read and only the voxels that end up in the thumbnail are ever
+ * touched, except for compressed files where the slices in between have to
+ * be inflated. Decoding happens in a worker pool, lookups never block.
+ * Thumbnails are kept by path and modification time in a cache that drops
+ * the least recently used ones once its memory limit is reached.
+ */
+class RSThumbnailCache : public QObject
+{
+    Q_OBJECT
+public:
+    static RSThumbnailCache& getInstance();
+
+    bool lookup(const QString &path, const rsNiftiHeader &header, QImage &image);
+    void request(const QString &path, const rsNiftiHeader &header);
+
+    int getCacheSize();
+    void setCacheSize(int megabytes);
+
+    static bool decode(const QString &path, const rsNiftiHeader &header, QImage &image);
+
+    static const int sliceSize = 64; // pixels along the longest axis
+
+signals:
+    void thumbnailReady(const QString &path);
+
+protected:
+    friend class RSThumbnailTask;
+
+    RSThumbnailCache();
+    ~RSThumbnailCache();
+
+    static QString getKey(const QString &path, const rsNiftiHeader &header);
+    void insert(const QString &key, const QImage &image);
+
+    QThreadPool pool;
+    QMutex mutex;
+    QCache<QString, QImage> thumbnails;
+    QSet<QString> pending;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
@@ -0,0 +1,222 @@
+#include "rstoolindex.h"
+#include "batch/util/pluginmanager.hpp"
+#include <algorithm>
+#include <sstream>
+#include <ctype.h>
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+static bool rsToolIndexMatchCompare(const rsToolIndexMatch& a, const rsToolIndexMatch& b)
+{
+    if ( a.score != b.score ) {
+        return a.score > b.score;
+    }
+    return a.entry->lname < b.entry->lname;
+}
+
+RSToolIndex& RSToolIndex::getInstance()
+{
+    static RSToolIndex instance;
+    return instance;
+}
+
+RSToolIndex::RSToolIndex()
+{
+    built = false;
+}
+
+RSToolIndex::~RSToolIndex()
+{}
+
+bool RSToolIndex::isBuilt()
+{
+    return built;
+}
+
+void RSToolIndex::build()
+{
+    if ( built ) {
+        return;
+    }
+
+    // ensure that plugins are loaded
+    PluginManager::getInstance().loadPlugins();
+
+    vector<const char*> tools = RSTool::getTools();
+
+    int i=0;
+    for (vector<const char*>::iterator it = tools.begin(); it != tools.end(); ++it, i++) {
+
+        const char* code = *it;
+        rsToolRegistration* reg = RSTool::findRegistration(code);
+
+        // a tool's UI can only be created once it has got a task assigned
+        RSTask* task = RSTask::taskFactory(code);
+        RSTool* tool = RSTool::toolFactory(code);
+        tool->setTask(task);
+        rsUIInterface* I = tool->createUI();
+
+        rsToolIndexEntry* entry = new rsToolIndexEntry;
+        entry->toolIndex   = i;
+        entry->code        = code;
+        entry->name        = task->getName();
+        entry->category    = reg->category;
+        entry->description = (I->gui_description == NULL ? I->description : I->gui_description);
+        entry->lcode       = toLower(entry->code.c_str());
+        entry->lname       = toLower(entry->name.c_str());
+        entry->lcategory   = toLower(entry->category.c_str());
+        entry->ldescription= toLower(entry->description.c_str());
+        entry->tool        = tool;
+        entry->ui          = I;
+
+        codes[entry->code] = entries.size();
+        entries.push_back(entry);
+
+        for ( size_t o=0; o<I->nOptions; o++ ) {
+            optionNames.insert(string(I->options[o]->name));
+        }
+    }
+
+    built = true;
+}
+
+size_t RSToolIndex::size()
+{
+    return entries.size();
+}
+
+rsToolIndexEntry* RSToolIndex::getEntry(size_t i)
+{
+    return entries.at(i);
+}
+
+rsToolIndexEntry* RSToolIndex::findEntry(const char* code)
+{
+    tr1::unordered_map<string, size_t>::iterator it = codes.find(string(code));
+    if ( it == codes.end() ) {
+        return NULL;
+    }
+    return entries[it->second];
+}
+
+// Whether any tool has an option of that name, false before build()
+bool RSToolIndex::hasOption(const char* name)
+{
+    return optionNames.find(string(name)) != optionNames.end();
+}
+
+vector<rsToolIndexMatch> RSToolIndex::search(const char* query, size_t maxResults)
+{
+    build();
+
+    // split the query into terms that all have to match
+    vector<string> terms;
+    istringstream stream(toLower(query));
+    string term;
+    while ( stream >> term ) {
+        terms.push_back(term);
+    }
+
+    vector<rsToolIndexMatch> matches;
+
+    for (vector<rsToolIndexEntry*>::iterator it = entries.begin(); it != entries.end(); ++it) {
+        rsToolIndexEntry* entry = *it;
+        int score = 0;
+        bool matched = true;
+
+        for (vector<string>::iterator t = terms.begin(); t != terms.end(); ++t) {
+            // names weigh more than codes, codes more than categories, etc.
+            int best = -1;
+            int s;
+            if ( (s = fuzzyScore(*t, entry->lname)) >= 0 )
+                best = max(best, s * 4);
+            if ( (s = fuzzyScore(*t, entry->lcode)) >= 0 )
+                best = max(best, s * 3);
+            if ( (s = fuzzyScore(*t, entry->lcategory)) >= 0 )
+                best = max(best, s * 2);
+            if ( (s = fuzzyScore(*t, entry->ldescription)) >= 0 )
+                best = max(best, s);
+
+            if ( best < 0 ) {
+                matched = false;
+                break;
+            }
+            score += best;
+        }
+
+        if ( matched ) {
+            rsToolIndexMatch match;
+            match.entry = entry;
+            match.score = score;
+            matches.push_back(match);
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), rsToolIndexMatchCompare);
+
+    if ( matches.size() > maxResults ) {
+        matches.resize(maxResults);
+    }
+
+    return matches;
+}
+
+/*
+ * Returns a negative value if the characters of pattern do not appear in
+ * text in the same order. Otherwise the score grows with contiguous runs,
+ * matches at word boundaries and an early position of the match.
+ */
+int RSToolIndex::fuzzyScore(const string& pattern, const string& text)
+{
+    if ( pattern.empty() ) {
+        return 0;
+    }
+
+    // plain substring matches always beat scattered ones
+    size_t pos = text.find(pattern);
+    if ( pos != string::npos ) {
+        int score = 100 + (int)pattern.length() * 10 - (int)min(pos, (size_t)50);
+        if ( pos == 0 || ! isalnum((unsigned char)text[pos-1]) ) {
+            score += 50;
+        }
+        return score;
+    }
+
+    int score = 0;
+    size_t t = 0;
+    size_t lastMatch = string::npos;
+
+    for (size_t p = 0; p < pattern.length(); p++) {
+        while ( t < text.length() && text[t] != pattern[p] ) {
+            t++;
+        }
+
+        if ( t >= text.length() ) {
+            return -1;
+        }
+
+        score += 1;
+        if ( lastMatch != string::npos && lastMatch + 1 == t ) {
+            score += 5;
+        }
+        if ( t == 0 || ! isalnum((unsigned char)text[t-1]) ) {
+            score += 8;
+        }
+
+        lastMatch = t;
+        t++;
+    }
+
+    return score;
+}
+
+string RSToolIndex::toLower(const char* s)
+{
+    string result(s == NULL ? "" : s);
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+}}} // namespace rstools::batch::util
@@ -0,0 +1,77 @@
+#ifndef rstools_rsbatch_jobeditor_rstoolindex_h
+#define rstools_rsbatch_jobeditor_rstoolindex_h
+
+#include <string>
+#include <vector>
+#include <tr1/unordered_map>
+#include <tr1/unordered_set>
+#include "batch/util/rstool.hpp"
+#include "batch/util/rstask.hpp"
+#include "utils/rsui.h"
+
+using namespace std;
+
+namespace rstools {
+namespace batch {
+namespace util {
+
+typedef struct {
+    int toolIndex;          // position in RSTool::getTools() as expected by insertNewTask()
+    string code;
+    string name;
+    string category;
+    string description;
+
+    // lower-cased copies of the above that the fuzzy matcher runs on
+    string lcode;
+    string lname;
+    string lcategory;
+    string ldescription;
+
+    RSTool *tool;
+    rsUIInterface *ui;
+} rsToolIndexEntry;
+
+typedef struct {
+    rsToolIndexEntry *entry;
+    int score;
+} rsToolIndexMatch;
+
+/*
+ * Precomputed in-memory index over all registered tools. It is built once
+ * per process (on first use) and can then be searched on every keystroke.
+ */
+class RSToolIndex
+{
+public:
+    static RSToolIndex& getInstance();
+
+    void build();
+    bool isBuilt();
+
+    size_t size();
+    rsToolIndexEntry* getEntry(size_t i);
+    rsToolIndexEntry* findEntry(const char* code);
+    bool hasOption(const char* name);
+
+    vector<rsToolIndexMatch> search(const char* query, size_t maxResults = 50);
+
+    static int fuzzyScore(const string& pattern, const string& text);
+
+protected:
+    RSToolIndex();
+    ~RSToolIndex();
+    RSToolIndex(RSToolIndex const&);
+    void operator=(RSToolIndex const&);
+
+    static string toLower(const char* s);
+
+    vector<rsToolIndexEntry*> entries;
+    tr1::unordered_map<string, size_t> codes;
+    tr1::unordered_set<string> optionNames;
+    bool built;
+};
+
+}}} // namespace rstools::batch::util
+
+#endif
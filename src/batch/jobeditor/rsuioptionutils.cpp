@@ -0,0 +1,49 @@
+#include "rsuioptionutils.h"
+#include <string.h>
+#include <glib.h>
+
+static bool rsContainsIgnoreCase(const char* text, const char* word)
+{
+    if ( text == NULL ) {
+        return false;
+    }
+
+    const size_t length = strlen(word);
+    for ( const char* p = text; *p != '\0'; p++ ) {
+        if ( g_ascii_strncasecmp(p, word, length) == 0 ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool rsUIOptionIsFilename(const rsUIOption* option)
+{
+    return option->type == G_OPTION_ARG_FILENAME;
+}
+
+bool rsUIOptionIsOutput(const rsUIOption* option)
+{
+    if ( ! rsUIOptionIsFilename(option) ) {
+        return false;
+    }
+
+    if ( rsContainsIgnoreCase(option->name, "input") ) {
+        return false;
+    }
+
+    static const char* outputHints[] = {"output", "save", "write", "written", "store", "result", NULL};
+    for ( size_t i=0; outputHints[i] != NULL; i++ ) {
+        if ( rsContainsIgnoreCase(option->name, outputHints[i]) || rsContainsIgnoreCase(option->cli_description, outputHints[i]) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool rsUIOptionIsInput(const rsUIOption* option)
+{
+    return rsUIOptionIsFilename(option) && ! rsUIOptionIsOutput(option);
+}
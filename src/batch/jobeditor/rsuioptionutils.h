@@ -0,0 +1,14 @@
+#ifndef rstools_rsbatch_jobeditor_rsuioptionutils_h
+#define rstools_rsbatch_jobeditor_rsuioptionutils_h
+
+#include "utils/rsui.h"
+
+/*
+ * rsUIOption does not state whether a filename is read or written by a
+ * tool. These helpers guess it from the option's name and description.
+ */
+bool rsUIOptionIsFilename(const rsUIOption* option);
+bool rsUIOptionIsOutput(const rsUIOption* option);
+bool rsUIOptionIsInput(const rsUIOption* option);
+
+#endif
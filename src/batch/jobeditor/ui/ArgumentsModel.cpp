@@ -5,9 +5,10 @@ namespace rstools {
 namespace batch {
 namespace util {
 
-ArgumentsModel::ArgumentsModel(RSJob* job, QObject *parent) : QAbstractTableModel(parent)
+ArgumentsModel::ArgumentsModel(RSJobDocument *document, QObject *parent) : QAbstractTableModel(parent)
 {
-    this->job = job;
+    this->document = document;
+    this->job = document->getJob();
 }
 
 ArgumentsModel::~ArgumentsModel()
@@ -50,37 +51,28 @@ bool ArgumentsModel::setData(const QModelIndex & index, const QVariant & value,
     if (role == Qt::EditRole) {
         QString result = value.toString();
         QByteArray result2 = result.toLatin1();
-        char *v = rsString(result2.data());
-        bool insertedRow = false;
-        vector<rsArgument*> args = job->getArguments();
         
-        if ( index.row() >= (int)args.size() ) {
+        if ( index.row() >= (int)job->getArguments().size() ) {
             
             //beginInsertRows(index, 0, 1);
             
-            rsArgument* arg = (rsArgument*)rsMalloc(sizeof(rsArgument));
-            arg->key = rsString("<empty>");
-            arg->value = rsString("");
-            job->addArgument(arg);
-
-            insertedRow = true;
+            if ( index.column() == 0 ) {
+                document->appendJobArgument(result2.data(), "");
+            } else {
+                document->appendJobArgument("<empty>", result2.data());
+            }
                 
             //endInsertRows();
-        }
-        
-        args = job->getArguments();
-        rsArgument* arg = args[index.row()];
-        
-        if ( index.column() == 0 ) {
-            arg->key = v;
-        } else {
-            arg->value = v;
-        }
-                
-        if ( insertedRow ) {
+            
             beginResetModel();
             endResetModel();
         } else {
+            if ( index.column() == 0 ) {
+                document->setJobArgumentKey(index.row(), result2.data());
+            } else {
+                document->setJobArgumentValue(index.row(), result2.data());
+            }
+            
             emit editCompleted(result);    
         }
     }
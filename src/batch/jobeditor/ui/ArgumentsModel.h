@@ -3,6 +3,7 @@
 
 #include <QAbstractTableModel>
 #include "batch/util/rsjob.hpp"
+#include "../rsjobdocument.h"
 
 using namespace std;
 
@@ -14,7 +15,7 @@ class ArgumentsModel : public QAbstractTableModel
 {
     Q_OBJECT
 public:
-    explicit ArgumentsModel(RSJob* job, QObject *parent = 0);
+    explicit ArgumentsModel(RSJobDocument *document, QObject *parent = 0);
     ~ArgumentsModel();
     
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
@@ -25,6 +26,7 @@ public:
     Qt::ItemFlags flags(const QModelIndex & /*index*/) const;
     
 protected:
+    RSJobDocument *document;
     RSJob *job;
     
 signals:
@@ -0,0 +1,112 @@
+#include "CachePreviewDialog.h"
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+#include <vector>
+
+using namespace std;
+
+enum {
+    COLUMN_TASK = 0,
+    COLUMN_TOOL,
+    COLUMN_RESULT,
+    COLUMN_REASON,
+    COLUMN_COUNT
+};
+
+CachePreviewDialog::CachePreviewDialog(RSJob *job, QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Reusable Tasks"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    setupLayout();
+
+    QList<rsTaskCacheDescriptor> tasks;
+    vector<RSTask*> jobTasks = job->getTasks();
+
+    table->setRowCount((int)jobTasks.size());
+    for ( size_t i=0; i<jobTasks.size(); i++ ) {
+        tasks << RSTaskCache::describe(job, jobTasks[i]);
+
+        for ( int c=0; c<COLUMN_COUNT; c++ ) {
+            table->setItem((int)i, c, new QTableWidgetItem());
+        }
+        table->item((int)i, COLUMN_TASK)->setText(QString("%1. %2").arg(i + 1).arg(QString(jobTasks[i]->getDescription())));
+        table->item((int)i, COLUMN_TOOL)->setText(QString(jobTasks[i]->getCode()));
+    }
+
+    // hashing the inputs may take a while for large images
+    statusLabel->setText(tr("Hashing input files..."));
+    check = new RSTaskCacheCheck(tasks, true);
+    connect(check, SIGNAL(finished()), this, SLOT(checkFinished()));
+    connect(check, SIGNAL(finished()), check, SLOT(deleteLater()));
+    check->start();
+}
+
+/*
+ * The check is not waited for, a file that is being hashed would keep the
+ * dialog from closing. It stops after its current task and deletes itself.
+ */
+CachePreviewDialog::~CachePreviewDialog()
+{
+    if ( check != NULL ) {
+        check->cancel();
+    }
+}
+
+void CachePreviewDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    table = new QTableWidget(0, COLUMN_COUNT);
+    QStringList headers;
+    headers << tr("Task") << tr("Tool") << tr("Result") << tr("Details");
+    table->setHorizontalHeaderLabels(headers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(table);
+
+    statusLabel = new QLabel();
+    layout->addWidget(statusLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(800, 360);
+}
+
+void CachePreviewDialog::checkFinished()
+{
+    QList<rsTaskCacheResult> results = check->getResults();
+    check = NULL;
+    int reused = 0;
+
+    for ( int i=0; i<results.size() && i<table->rowCount(); i++ ) {
+        const rsTaskCacheResult &result = results.at(i);
+        QTableWidgetItem *item = table->item(i, COLUMN_RESULT);
+
+        if ( result.hit ) {
+            item->setText(tr("Reused"));
+            item->setForeground(QBrush(QColor(0, 128, 0)));
+            reused++;
+        } else {
+            item->setText(tr("Runs"));
+        }
+        table->item(i, COLUMN_REASON)->setText(result.reason);
+        table->item(i, COLUMN_REASON)->setToolTip(result.reason);
+    }
+
+    table->resizeColumnsToContents();
+    table->horizontalHeader()->setStretchLastSection(true);
+
+    QString status = tr("%1 of %2 tasks would be reused").arg(reused).arg(results.size());
+    if ( ! RSTaskCache::getInstance().isEnabled() ) {
+        status += tr(", but skipping unchanged tasks is turned off in the run queue");
+    }
+    statusLabel->setText(status);
+}
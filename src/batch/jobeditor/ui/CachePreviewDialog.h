@@ -0,0 +1,36 @@
+#ifndef rstools_rsbatch_jobeditor_ui_cachepreviewdialog_h
+#define rstools_rsbatch_jobeditor_ui_cachepreviewdialog_h
+
+#include <QDialog>
+#include "../rstaskcache.h"
+
+QT_BEGIN_NAMESPACE
+class QTableWidget;
+class QLabel;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Dry run of the result cache: lists which tasks of a job would be reused
+ * and why the others would have to run.
+ */
+class CachePreviewDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit CachePreviewDialog(RSJob *job, QWidget * parent = 0);
+    ~CachePreviewDialog();
+
+protected:
+    void setupLayout();
+
+    QTableWidget *table;
+    QLabel *statusLabel;
+    RSTaskCacheCheck *check;
+
+protected slots:
+    void checkFinished();
+};
+
+#endif
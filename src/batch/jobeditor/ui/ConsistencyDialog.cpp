@@ -0,0 +1,87 @@
+#include "ConsistencyDialog.h"
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QFileInfo>
+#include <QHash>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSet>
+#include <QTreeWidget>
+
+ConsistencyDialog::ConsistencyDialog(const RSStudyConsistency &consistency, QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Study Consistency"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    setupLayout();
+
+    // one entry per setting, those with the most deviating jobs first
+    QHash<QString, QTreeWidgetItem*> settings;
+    QList<rsConsistencyIssue> issues = consistency.getIssues();
+    QSet<QString> jobs;
+
+    foreach( const rsConsistencyIssue &issue, issues ) {
+        const QString id = issue.task + QChar('\t') + issue.key;
+        QTreeWidgetItem *setting = settings.value(id, NULL);
+        if ( setting == NULL ) {
+            setting = new QTreeWidgetItem(tree);
+            setting->setText(0, issue.key.isEmpty() ? issue.task : QString("%1: %2").arg(issue.task).arg(issue.key));
+            setting->setText(1, tr("%1 (%2 of %3 jobs)").arg(issue.usual).arg(issue.usualCount).arg(issue.total));
+            settings.insert(id, setting);
+        }
+
+        QTreeWidgetItem *item = new QTreeWidgetItem(setting);
+        item->setText(0, QFileInfo(issue.path).fileName());
+        item->setToolTip(0, issue.path);
+        item->setData(0, Qt::UserRole, issue.path);
+        item->setText(1, issue.value);
+        jobs.insert(issue.path);
+    }
+
+    for ( int i=0; i<tree->topLevelItemCount(); i++ ) {
+        QTreeWidgetItem *setting = tree->topLevelItem(i);
+        setting->setData(2, Qt::DisplayRole, setting->childCount());
+    }
+    tree->sortItems(2, Qt::DescendingOrder);
+
+    summaryLabel->setText(
+        tr("%1 of %2 jobs deviate from the majority in %3 of %4 settings.")
+            .arg(jobs.size())
+            .arg(consistency.getJobCount())
+            .arg(settings.size())
+            .arg(consistency.getCheckedOptionCount())
+    );
+}
+
+void ConsistencyDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    tree = new QTreeWidget();
+    tree->setColumnCount(3);
+    QStringList headers;
+    headers << tr("Setting / Job") << tr("Usual / Deviating value") << tr("Deviating jobs");
+    tree->setHeaderLabels(headers);
+    tree->header()->resizeSection(0, 360);
+    tree->header()->resizeSection(1, 360);
+    connect(tree, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(itemActivated(QTreeWidgetItem*, int)));
+    layout->addWidget(tree);
+
+    summaryLabel = new QLabel();
+    summaryLabel->setWordWrap(true);
+    layout->addWidget(summaryLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(900, 520);
+}
+
+void ConsistencyDialog::itemActivated(QTreeWidgetItem *item, int /*column*/)
+{
+    QString path = item->data(0, Qt::UserRole).toString();
+    if ( ! path.isEmpty() ) {
+        emit jobActivated(path);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef rstools_rsbatch_jobeditor_ui_consistencydialog_h
+#define rstools_rsbatch_jobeditor_ui_consistencydialog_h
+
+#include <QDialog>
+#include "../rsstudyconsistency.h"
+
+QT_BEGIN_NAMESPACE
+class QTreeWidget;
+class QTreeWidgetItem;
+class QLabel;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Lists the settings in which some jobs of a study deviate from the
+ * majority, one entry per setting with the deviating jobs below it.
+ */
+class ConsistencyDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit ConsistencyDialog(const RSStudyConsistency &consistency, QWidget * parent = 0);
+
+signals:
+    void jobActivated(const QString &path);
+
+protected:
+    void setupLayout();
+
+    QTreeWidget *tree;
+    QLabel *summaryLabel;
+
+protected slots:
+    void itemActivated(QTreeWidgetItem *item, int column);
+};
+
+#endif
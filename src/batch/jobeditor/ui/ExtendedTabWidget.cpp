@@ -51,11 +51,13 @@ void ExtendedTabWidget::removePage(int index)
 {
     QWidget *widget = stackWidget->widget(index);
     stackWidget->removeWidget(widget);
+    annotations.remove(widget);
    
     QPushButton* button = (QPushButton*)buttonGroup->button(index);
     buttonLayout->removeWidget(button);
     buttonGroup->removeButton(button);
     delete button;
+    updateButtonIds();
     
     setCurrentIndex(0);
 }
@@ -116,7 +118,19 @@ void ExtendedTabWidget::insertPage(int index, QWidget *page, const QIcon &icon,
     if( count()==1 )
         button->setChecked(true);
     buttonGroup->addButton(button, index);
-    buttonLayout->addWidget(button);
+    buttonLayout->insertWidget(index, button);
+    updateButtonIds();
+}
+
+// Button ids are the page indices, which shift when pages are inserted or removed
+void ExtendedTabWidget::updateButtonIds()
+{
+    for( int i=0; i<buttonLayout->count(); i++ )
+    {
+        QAbstractButton *button = qobject_cast<QAbstractButton*>(buttonLayout->itemAt(i)->widget());
+        if( button != NULL )
+            buttonGroup->setId(button, i);
+    }
 }
 
 void ExtendedTabWidget::setCurrentIndex(int index)
@@ -211,17 +225,19 @@ void ExtendedTabWidget::setPageTitleList(QStringList const &newTitleList)
     if( !count() ) return;
     for( int i=0; i<stackWidget->count() && i<titleList.count(); i++ )
     {
-        buttonGroup->button(i)->setText(titleList.at(i));
         stackWidget->widget(i)->setWindowTitle(titleList.at(i));
+        buttonGroup->button(i)->setText(buttonText(stackWidget->widget(i)));
     }
 }
 
 void ExtendedTabWidget::setPageTitle(QString const &newTitle)
 {
     if( !count() ) return;
-    buttonGroup->button(currentIndex())->setText(newTitle);
     if (QWidget *currentWidget = stackWidget->currentWidget())
+    {
         currentWidget->setWindowTitle(newTitle);
+        buttonGroup->button(currentIndex())->setText(buttonText(currentWidget));
+    }
 
     emit pageTitleChanged(newTitle);
 }
@@ -229,9 +245,11 @@ void ExtendedTabWidget::setPageTitle(QString const &newTitle)
 void ExtendedTabWidget::setPageTitle(int index, QString const &newTitle)
 {
     if( index<0 || index>=count() ) return;
-    buttonGroup->button(index)->setText(newTitle);
     if (QWidget *currentWidget = stackWidget->widget(index))
+    {
         currentWidget->setWindowTitle(newTitle);
+        buttonGroup->button(index)->setText(buttonText(currentWidget));
+    }
 
     emit pageTitleChanged(newTitle);
 }
@@ -255,3 +273,36 @@ void ExtendedTabWidget::setPageIcon(QIcon const &newIcon)
         currentWidget->setWindowIcon(newIcon);
     emit pageIconChanged(newIcon);
 }
+
+void ExtendedTabWidget::setPageAnnotation(int index, const QString &annotation, const QColor &color, const QString &toolTip)
+{
+    QWidget *page = stackWidget->widget(index);
+    QAbstractButton *button = buttonGroup->button(index);
+    if( page == NULL || button == NULL ) return;
+
+    if( annotation.isEmpty() )
+        annotations.remove(page);
+    else
+        annotations.insert(page, annotation);
+
+    button->setText(buttonText(page));
+    button->setToolTip(toolTip);
+
+    // A colored square replaces the page icon while there is a marker
+    if( color.isValid() )
+    {
+        QPixmap marker(button->iconSize());
+        marker.fill(color);
+        button->setIcon(QIcon(marker));
+    }
+    else
+        button->setIcon(page->windowIcon());
+}
+
+QString ExtendedTabWidget::buttonText(QWidget *page) const
+{
+    QString annotation = annotations.value(page);
+    if( annotation.isEmpty() )
+        return page->windowTitle();
+    return page->windowTitle() + "  (" + annotation + ")";
+}
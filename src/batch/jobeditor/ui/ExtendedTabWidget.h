@@ -2,6 +2,8 @@
 
 #include <QWidget>
 #include <QIcon>
+#include <QHash>
+#include <QColor>
 
 QT_BEGIN_NAMESPACE
 class QComboBox;
@@ -50,6 +52,9 @@ public:
     void setTabText(int index, const QString &title)
     { setPageTitle(index, title); }
 
+    // Extra text and a colored marker shown on a page's button
+    void setPageAnnotation(int index, const QString &annotation, const QColor &color=QColor(), const QString &toolTip=QString());
+
 public slots:   
     void addPage(QWidget *page, const QIcon &icon=QIcon(), const QString &title=QString());
     void insertPage(int index, QWidget *page, const QIcon &icon=QIcon(), const QString &title=QString());
@@ -70,7 +75,11 @@ signals:
     void pageIconChanged(const QIcon &icon);
 
 private:
+    QString buttonText(QWidget *page) const;
+    void updateButtonIds();
+
     QStringList titleList, iconList;
+    QHash<QWidget*, QString> annotations;
 
     QStackedWidget *stackWidget;
     QButtonGroup *buttonGroup;
@@ -0,0 +1,146 @@
+#include "FootprintDialog.h"
+#include "../rsrunhistory.h"
+#include "../rstoolindex.h"
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+
+enum {
+    COLUMN_TASK = 0,
+    COLUMN_TOOL,
+    COLUMN_READ,
+    COLUMN_DATA,
+    COLUMN_WRITE,
+    COLUMN_MEMORY,
+    COLUMN_COUNT
+};
+
+static QString formatBytes(qint64 bytes)
+{
+    return bytes <= 0 ? QString("-") : RSRunHistory::formatMemory(bytes / 1024);
+}
+
+FootprintDialog::FootprintDialog(const RSJobSnapshot &job, QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Data Footprint"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    setupLayout();
+
+    table->setRowCount(job.getTaskCount());
+    for ( int i=0; i<job.getTaskCount(); i++ ) {
+        for ( int c=0; c<COLUMN_COUNT; c++ ) {
+            table->setItem(i, c, new QTableWidgetItem());
+        }
+        table->item(i, COLUMN_TASK)->setText(QString("%1. %2").arg(i + 1).arg(job.getTask(i).description));
+        table->item(i, COLUMN_TOOL)->setText(job.getTask(i).code);
+    }
+
+    // the worker looks up the options of the tools
+    RSToolIndex::getInstance().build();
+
+    // only the headers are read, but they may live on a slow share
+    statusLabel->setText(tr("Reading image headers..."));
+    footprint = new RSJobFootprint(job);
+    connect(footprint, SIGNAL(finished()), this, SLOT(footprintFinished()));
+    connect(footprint, SIGNAL(finished()), footprint, SLOT(deleteLater()));
+    footprint->start();
+}
+
+/*
+ * The worker is not waited for, a header on a slow share would keep the
+ * dialog from closing. It stops before the next header and deletes itself.
+ */
+FootprintDialog::~FootprintDialog()
+{
+    if ( footprint != NULL ) {
+        footprint->cancel();
+    }
+}
+
+void FootprintDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    table = new QTableWidget(0, COLUMN_COUNT);
+    QStringList headers;
+    headers << tr("Task") << tr("Tool") << tr("Reads") << tr("Voxel data") << tr("Writes") << tr("Memory");
+    table->setHorizontalHeaderLabels(headers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(table);
+
+    statusLabel = new QLabel();
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    spaceLabel = new QLabel();
+    spaceLabel->setWordWrap(true);
+    layout->addWidget(spaceLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(800, 360);
+}
+
+void FootprintDialog::footprintFinished()
+{
+    QList<rsTaskFootprint> results = footprint->getTasks();
+    qint64 read = 0, data = 0, written = 0, memory = 0;
+
+    for ( int i=0; i<results.size() && i<table->rowCount(); i++ ) {
+        const rsTaskFootprint &result = results.at(i);
+
+        table->item(i, COLUMN_READ)->setText(formatBytes(result.inputSize));
+        table->item(i, COLUMN_DATA)->setText(formatBytes(result.inputData));
+        table->item(i, COLUMN_WRITE)->setText(formatBytes(result.outputSize));
+        table->item(i, COLUMN_MEMORY)->setText(formatBytes(result.memory));
+
+        QString files = result.files.join("\n");
+        for ( int c=0; c<COLUMN_COUNT; c++ ) {
+            table->item(i, c)->setToolTip(files);
+        }
+
+        read    += result.inputSize;
+        data    += result.inputData;
+        written += result.outputSize;
+        memory   = qMax(memory, result.memory);
+    }
+
+    table->resizeColumnsToContents();
+    table->horizontalHeader()->setStretchLastSection(true);
+
+    // the tasks run one after another, so the largest one sets the memory
+    statusLabel->setText(
+        tr("The job reads %1 (%2 of voxel data), writes about %3 and needs about %4 of memory for its largest task.")
+            .arg(formatBytes(read))
+            .arg(formatBytes(data))
+            .arg(formatBytes(written))
+            .arg(formatBytes(memory))
+    );
+
+    QStringList lines;
+    bool insufficient = false;
+    foreach( const rsFilesystemFootprint &filesystem, footprint->getFilesystems() ) {
+        QString line = tr("%1: needs about %2, %3 free")
+            .arg(filesystem.directory)
+            .arg(formatBytes(filesystem.required))
+            .arg(formatBytes(filesystem.available));
+        if ( filesystem.required > filesystem.available ) {
+            line += tr(" - not enough space");
+            insufficient = true;
+        }
+        lines << line;
+    }
+    spaceLabel->setText(lines.join("\n"));
+    spaceLabel->setStyleSheet(insufficient ? "color: #c00000" : "");
+
+    // the worker deletes itself
+    footprint = NULL;
+}
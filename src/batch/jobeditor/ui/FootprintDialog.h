@@ -0,0 +1,37 @@
+#ifndef rstools_rsbatch_jobeditor_ui_footprintdialog_h
+#define rstools_rsbatch_jobeditor_ui_footprintdialog_h
+
+#include <QDialog>
+#include "../rsjobfootprint.h"
+
+QT_BEGIN_NAMESPACE
+class QTableWidget;
+class QLabel;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Shows how much image data every task of a job reads and writes, how much
+ * memory it needs and whether the output directories have enough space.
+ */
+class FootprintDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit FootprintDialog(const RSJobSnapshot &job, QWidget * parent = 0);
+    ~FootprintDialog();
+
+protected:
+    void setupLayout();
+
+    QTableWidget *table;
+    QLabel *statusLabel;
+    QLabel *spaceLabel;
+    RSJobFootprint *footprint;
+
+protected slots:
+    void footprintFinished();
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "GenerateJobsDialog.h"
+#include "../rsjobrunqueue.h"
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QErrorMessage>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <stdexcept>
+
+using namespace std;
+
+GenerateJobsDialog::GenerateJobsDialog(RSJob *currentJob, QWidget *parent) : QDialog(parent)
+{
+    this->currentJob = currentJob;
+
+    setWindowTitle(tr("Generate Jobs"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    setupLayout();
+}
+
+GenerateJobsDialog::~GenerateJobsDialog()
+{
+
+}
+
+QLineEdit* GenerateJobsDialog::addPathRow(QFormLayout *form, const QString &label, const char *browseSlot)
+{
+    QBoxLayout *row = new QBoxLayout(QBoxLayout::LeftToRight);
+    QLineEdit *edit = new QLineEdit();
+    row->addWidget(edit);
+
+    QPushButton *browseButton = new QPushButton(tr("Browse..."));
+    connect(browseButton, SIGNAL(clicked()), this, browseSlot);
+    row->addWidget(browseButton);
+
+    form->addRow(label, row);
+    return edit;
+}
+
+void GenerateJobsDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+    QFormLayout *form = new QFormLayout();
+
+    useCurrentJobBox = new QCheckBox(tr("Use the job of this window as template"));
+    useCurrentJobBox->setChecked(currentJob != NULL);
+    useCurrentJobBox->setEnabled(currentJob != NULL);
+    connect(useCurrentJobBox, SIGNAL(toggled(bool)), this, SLOT(useCurrentJobToggled(bool)));
+    form->addRow(QString(), useCurrentJobBox);
+
+    templateEdit = addPathRow(form, tr("Template job:"), SLOT(browseTemplate()));
+    templateEdit->setEnabled(currentJob == NULL);
+
+    tableEdit = addPathRow(form, tr("Subject table:"), SLOT(browseTable()));
+    tableEdit->setToolTip(tr("CSV or TSV file with a header row. Every {{column}} in the template's arguments is replaced by the row's value."));
+    connect(tableEdit, SIGNAL(editingFinished()), this, SLOT(tableChanged()));
+
+    directoryEdit = addPathRow(form, tr("Output directory:"), SLOT(browseDirectory()));
+
+    nameEdit = new QLineEdit(QString("{{subject}}.job"));
+    form->addRow(tr("File name:"), nameEdit);
+
+    queueBox = new QCheckBox(tr("Add the generated jobs to the run queue"));
+    form->addRow(QString(), queueBox);
+
+    layout->addLayout(form);
+
+    statusLabel = new QLabel();
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    generateButton = buttons->addButton(tr("Generate"), QDialogButtonBox::ActionRole);
+    connect(generateButton, SIGNAL(clicked()), this, SLOT(generate()));
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(560, 260);
+}
+
+void GenerateJobsDialog::useCurrentJobToggled(bool checked)
+{
+    templateEdit->setEnabled(! checked);
+}
+
+// The window's job is gone, only a template file can be used from now on
+void GenerateJobsDialog::jobClosed()
+{
+    currentJob = NULL;
+    useCurrentJobBox->setChecked(false);
+    useCurrentJobBox->setEnabled(false);
+}
+
+void GenerateJobsDialog::browseTemplate()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Template Job"), templateEdit->text(), tr("Job (*.job)"));
+    if ( ! fileName.isEmpty() ) {
+        templateEdit->setText(fileName);
+        useCurrentJobBox->setChecked(false);
+    }
+}
+
+void GenerateJobsDialog::browseTable()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Subject Table"), tableEdit->text(), tr("Table (*.csv *.tsv *.txt)"));
+    if ( ! fileName.isEmpty() ) {
+        tableEdit->setText(fileName);
+        tableChanged();
+    }
+}
+
+void GenerateJobsDialog::browseDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Output Directory"), directoryEdit->text());
+    if ( ! directory.isEmpty() ) {
+        directoryEdit->setText(directory);
+    }
+}
+
+// Names the generated files after the table's first column by default
+void GenerateJobsDialog::tableChanged()
+{
+    if ( tableEdit->text().isEmpty() ) {
+        return;
+    }
+
+    try {
+        RSJobTemplate jobTemplate;
+        jobTemplate.readTable(tableEdit->text());
+
+        QStringList columns = jobTemplate.getColumns();
+        if ( ! columns.isEmpty() && nameEdit->text() == QString("{{subject}}.job") && ! columns.contains("subject") ) {
+            nameEdit->setText(QString("{{%1}}.job").arg(columns.first()));
+        }
+
+        statusLabel->setText(tr("%1 rows with the columns %2").arg(jobTemplate.getRowCount()).arg(columns.join(", ")));
+    } catch (const exception& e) {
+        statusLabel->setText(QString::fromUtf8(e.what()));
+    }
+}
+
+void GenerateJobsDialog::generate()
+{
+    try {
+        QElapsedTimer timer;
+        timer.start();
+
+        RSJobTemplate jobTemplate;
+        if ( useCurrentJobBox->isChecked() && currentJob != NULL ) {
+            jobTemplate.setJob(currentJob);
+        } else {
+            jobTemplate.load(templateEdit->text());
+        }
+        jobTemplate.readTable(tableEdit->text());
+
+        QStringList jobs = jobTemplate.generate(directoryEdit->text(), nameEdit->text());
+
+        statusLabel->setText(tr("Wrote %1 jobs in %2 ms").arg(jobs.size()).arg(timer.elapsed()));
+
+        if ( queueBox->isChecked() ) {
+            foreach( const QString &job, jobs ) {
+                RSJobRunQueue::getInstance().enqueue(job);
+            }
+        }
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef rstools_rsbatch_jobeditor_ui_generatejobsdialog_h
+#define rstools_rsbatch_jobeditor_ui_generatejobsdialog_h
+
+#include <QDialog>
+#include "../rsjobtemplate.h"
+
+QT_BEGIN_NAMESPACE
+class QLineEdit;
+class QCheckBox;
+class QLabel;
+class QPushButton;
+class QFormLayout;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Front end for RSJobTemplate: picks a template job, a table of subject
+ * variables and the directory the generated jobs go to.
+ */
+class GenerateJobsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit GenerateJobsDialog(RSJob *currentJob, QWidget * parent = 0);
+    ~GenerateJobsDialog();
+
+protected:
+    void setupLayout();
+    QLineEdit* addPathRow(QFormLayout *form, const QString &label, const char *browseSlot);
+
+    RSJob *currentJob;
+    QCheckBox *useCurrentJobBox;
+    QLineEdit *templateEdit;
+    QLineEdit *tableEdit;
+    QLineEdit *directoryEdit;
+    QLineEdit *nameEdit;
+    QCheckBox *queueBox;
+    QLabel *statusLabel;
+    QPushButton *generateButton;
+
+protected slots:
+    void browseTemplate();
+    void browseTable();
+    void browseDirectory();
+    void useCurrentJobToggled(bool checked);
+    void tableChanged();
+    void generate();
+
+public slots:
+    void jobClosed();
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "JobDiffDialog.h"
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTreeWidget>
+
+JobDiffDialog::JobDiffDialog(const RSJobSnapshot &left, const RSJobSnapshot &right, const QString &leftTitle, const QString &rightTitle, QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Compare Jobs"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    setupLayout(leftTitle, rightTitle);
+
+    RSJobComparison comparison(left, right);
+
+    QList<rsArgumentChange> arguments = comparison.getArgumentChanges();
+    if ( ! arguments.isEmpty() ) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(tree);
+        item->setText(0, tr("Job arguments"));
+        item->setText(1, tr("Job arguments"));
+        setColor(item, TASK_CHANGED);
+        addArgumentItems(item, arguments);
+        item->setExpanded(true);
+    }
+
+    foreach( const rsTaskChange &change, comparison.getTasks() ) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(tree);
+        if ( change.from >= 0 ) {
+            item->setText(0, RSJobComparison::formatTask(change.from, left.getTask(change.from)));
+        }
+        if ( change.to >= 0 ) {
+            item->setText(1, RSJobComparison::formatTask(change.to, right.getTask(change.to)));
+        }
+        if ( change.type == TASK_MOVED ) {
+            item->setText(1, item->text(1) + tr(" (moved from %1)").arg(change.from + 1));
+        }
+        setColor(item, change.type);
+
+        if ( change.type == TASK_UNCHANGED ) {
+            unchanged << item;
+        } else if ( change.type == TASK_CHANGED ) {
+            if ( change.descriptionChanged ) {
+                QTreeWidgetItem *description = new QTreeWidgetItem(item);
+                description->setText(0, tr("description = %1").arg(left.getTask(change.from).description));
+                description->setText(1, tr("description = %1").arg(right.getTask(change.to).description));
+            }
+            addArgumentItems(item, change.arguments);
+            item->setExpanded(true);
+        }
+    }
+
+    summaryLabel->setText(
+        tr("%1 tasks changed, %2 added, %3 removed and %4 moved, %5 job arguments changed.")
+            .arg(comparison.count(TASK_CHANGED))
+            .arg(comparison.count(TASK_ADDED))
+            .arg(comparison.count(TASK_REMOVED))
+            .arg(comparison.count(TASK_MOVED))
+            .arg(arguments.size())
+    );
+}
+
+void JobDiffDialog::setupLayout(const QString &leftTitle, const QString &rightTitle)
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    tree = new QTreeWidget();
+    tree->setColumnCount(2);
+    QStringList headers;
+    headers << leftTitle << rightTitle;
+    tree->setHeaderLabels(headers);
+    tree->setRootIsDecorated(true);
+    tree->setSelectionBehavior(QAbstractItemView::SelectRows);
+    tree->header()->setStretchLastSection(true);
+    tree->header()->resizeSection(0, 440);
+    layout->addWidget(tree);
+
+    QCheckBox *hideUnchangedBox = new QCheckBox(tr("Hide unchanged tasks"));
+    connect(hideUnchangedBox, SIGNAL(toggled(bool)), this, SLOT(setUnchangedHidden(bool)));
+    layout->addWidget(hideUnchangedBox);
+
+    summaryLabel = new QLabel();
+    summaryLabel->setWordWrap(true);
+    layout->addWidget(summaryLabel);
+
+    conflictsLabel = new QLabel();
+    conflictsLabel->setWordWrap(true);
+    conflictsLabel->setStyleSheet("color: #c00000");
+    conflictsLabel->setVisible(false);
+    layout->addWidget(conflictsLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(900, 500);
+}
+
+// Lists what a merge could not decide, below the comparison of its result
+void JobDiffDialog::setConflicts(const QStringList &conflicts)
+{
+    conflictsLabel->setText(tr("Conflicts, resolved in favour of this job:") + QString("\n") + conflicts.join("\n"));
+    conflictsLabel->setVisible(! conflicts.isEmpty());
+}
+
+void JobDiffDialog::addArgumentItems(QTreeWidgetItem *parent, const QList<rsArgumentChange> &changes)
+{
+    foreach( const rsArgumentChange &change, changes ) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(parent);
+        if ( change.inFrom ) {
+            item->setText(0, QString("%1 = %2").arg(change.key).arg(RSJobComparison::formatValue(true, change.from)));
+        }
+        if ( change.inTo ) {
+            item->setText(1, QString("%1 = %2").arg(change.key).arg(RSJobComparison::formatValue(true, change.to)));
+        }
+    }
+}
+
+void JobDiffDialog::setColor(QTreeWidgetItem *item, rsTaskChangeType type)
+{
+    QColor color;
+    switch ( type ) {
+        case TASK_CHANGED: color = QColor(255, 240, 200); break;
+        case TASK_ADDED:   color = QColor(220, 255, 220); break;
+        case TASK_REMOVED: color = QColor(255, 220, 220); break;
+        case TASK_MOVED:   color = QColor(220, 230, 255); break;
+        default:
+            return;
+    }
+
+    for ( int c=0; c<2; c++ ) {
+        item->setBackground(c, QBrush(color));
+    }
+}
+
+void JobDiffDialog::setUnchangedHidden(bool hidden)
+{
+    foreach( QTreeWidgetItem *item, unchanged ) {
+        item->setHidden(hidden);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef rstools_rsbatch_jobeditor_ui_jobdiffdialog_h
+#define rstools_rsbatch_jobeditor_ui_jobdiffdialog_h
+
+#include <QDialog>
+#include <QStringList>
+#include "../rsjobcomparison.h"
+
+QT_BEGIN_NAMESPACE
+class QTreeWidget;
+class QTreeWidgetItem;
+class QLabel;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Shows two versions of a job side by side, one row per task, with the
+ * arguments that differ below the tasks that were changed. Unchanged
+ * tasks can be hidden to look at the changes only.
+ */
+class JobDiffDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    JobDiffDialog(const RSJobSnapshot &left, const RSJobSnapshot &right, const QString &leftTitle, const QString &rightTitle, QWidget * parent = 0);
+
+    void setConflicts(const QStringList &conflicts);
+
+protected:
+    void setupLayout(const QString &leftTitle, const QString &rightTitle);
+    void addArgumentItems(QTreeWidgetItem *parent, const QList<rsArgumentChange> &changes);
+    static void setColor(QTreeWidgetItem *item, rsTaskChangeType type);
+
+    QTreeWidget *tree;
+    QLabel *summaryLabel;
+    QLabel *conflictsLabel;
+    QList<QTreeWidgetItem*> unchanged;
+
+protected slots:
+    void setUnchangedHidden(bool hidden);
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "JobGraphDialog.h"
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QErrorMessage>
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTextStream>
+#include <QTreeWidget>
+#include <QtAlgorithms>
+#include <vector>
+
+using namespace std;
+
+enum {
+    COLUMN_TASK = 0,
+    COLUMN_BRANCH,
+    COLUMN_AFTER,
+    COLUMN_BEFORE,
+    COLUMN_COUNT
+};
+
+JobGraphDialog::JobGraphDialog(RSJobGraph *graph, QWidget *parent) : QDialog(parent)
+{
+    this->graph = graph;
+    this->job = NULL;
+
+    setWindowTitle(tr("Task Dependencies"));
+    setupLayout();
+
+    connect(graph, SIGNAL(graphChanged()), this, SLOT(refresh()));
+}
+
+JobGraphDialog::~JobGraphDialog()
+{
+
+}
+
+void JobGraphDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    summaryLabel = new QLabel();
+    summaryLabel->setWordWrap(true);
+    layout->addWidget(summaryLabel);
+
+    tree = new QTreeWidget();
+    tree->setColumnCount(COLUMN_COUNT);
+    QStringList headers;
+    headers << tr("Task") << tr("Branch") << tr("After") << tr("Before");
+    tree->setHeaderLabels(headers);
+    tree->setRootIsDecorated(false);
+    tree->setUniformRowHeights(true);
+    connect(tree, SIGNAL(itemActivated(QTreeWidgetItem*, int)), this, SLOT(itemActivated(QTreeWidgetItem*, int)));
+    layout->addWidget(tree);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    QPushButton *exportButton = buttons->addButton(tr("Export Plan..."), QDialogButtonBox::ActionRole);
+    connect(exportButton, SIGNAL(clicked()), this, SLOT(exportPlan()));
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(640, 480);
+}
+
+void JobGraphDialog::setJob(RSJob *job)
+{
+    this->job = job;
+    refresh();
+}
+
+void JobGraphDialog::popup()
+{
+    show();
+    refresh();
+    raise();
+    activateWindow();
+}
+
+void JobGraphDialog::refresh()
+{
+    // popup() catches up on what happened while hidden
+    if ( ! isVisible() ) {
+        return;
+    }
+
+    vector<RSTask*> tasks;
+    if ( job != NULL ) {
+        tasks = job->getTasks();
+    }
+
+    tree->setUpdatesEnabled(false);
+    tree->clear();
+
+    const int branches = graph->getBranchCount();
+    QList<QList<int> > stages = graph->getStages();
+
+    for ( int s=0; s<stages.size(); s++ ) {
+        QTreeWidgetItem *stageItem = new QTreeWidgetItem(tree);
+        stageItem->setText(COLUMN_TASK, tr("Stage %1 (%2 tasks)").arg(s + 1).arg(stages.at(s).size()));
+        stageItem->setFirstColumnSpanned(true);
+        QFont f = stageItem->font(COLUMN_TASK);
+        f.setBold(true);
+        stageItem->setFont(COLUMN_TASK, f);
+        stageItem->setFlags(Qt::ItemIsEnabled);
+
+        foreach( int i, stages.at(s) ) {
+            const rsJobGraphNode &node = graph->getNode(i);
+
+            QList<int> after = node.dependencies.toList();
+            qSort(after);
+            QStringList afterList;
+            foreach( int d, after ) {
+                afterList << QString::number(d + 1);
+            }
+            QStringList beforeList;
+            foreach( int d, graph->getDependents(i) ) {
+                beforeList << QString::number(d + 1);
+            }
+
+            QString title = QString::number(i + 1);
+            if ( i < (int)tasks.size() ) {
+                title += QString(". ") + QString::fromUtf8(tasks[i]->getDescription());
+            }
+
+            QTreeWidgetItem *item = new QTreeWidgetItem(stageItem);
+            item->setText(COLUMN_TASK, title);
+            item->setText(COLUMN_BRANCH, QString::number(node.branch + 1));
+            item->setText(COLUMN_AFTER, afterList.join(", "));
+            item->setText(COLUMN_BEFORE, beforeList.join(", "));
+            item->setData(COLUMN_TASK, Qt::UserRole, i);
+
+            // evenly spread hues, so that neighbouring branches differ
+            if ( branches > 1 ) {
+                QColor color = QColor::fromHsvF((double)node.branch / (double)branches, 0.25, 1.0);
+                for ( int c=0; c<COLUMN_COUNT; c++ ) {
+                    item->setBackground(c, QBrush(color));
+                }
+            }
+        }
+    }
+
+    tree->expandAll();
+    tree->resizeColumnToContents(COLUMN_TASK);
+    tree->setUpdatesEnabled(true);
+
+    summaryLabel->setText(
+        tr("%1 tasks in %2 stages and %3 independent branches. Tasks within a stage can run at the same time.")
+            .arg(graph->size())
+            .arg(graph->getStageCount())
+            .arg(branches)
+    );
+}
+
+void JobGraphDialog::itemActivated(QTreeWidgetItem *item, int /*column*/)
+{
+    QVariant index = item->data(COLUMN_TASK, Qt::UserRole);
+    if ( index.isValid() ) {
+        emit taskActivated(index.toInt());
+    }
+}
+
+void JobGraphDialog::exportPlan()
+{
+    if ( job == NULL ) {
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Execution Plan"), "", tr("Text (*.txt)"));
+    if ( fileName.isEmpty() ) {
+        return;
+    }
+
+    QFile file(fileName);
+    if ( ! file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) ) {
+        QErrorMessage errorMessage(this);
+        errorMessage.showMessage(tr("The plan could not be written to '%1'").arg(fileName));
+        errorMessage.exec();
+        return;
+    }
+
+    QTextStream out(&file);
+    out << graph->toPlan(job);
+}
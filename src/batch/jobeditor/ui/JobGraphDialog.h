@@ -0,0 +1,46 @@
+#ifndef rstools_rsbatch_jobeditor_ui_jobgraphdialog_h
+#define rstools_rsbatch_jobeditor_ui_jobgraphdialog_h
+
+#include <QDialog>
+#include "../rsjobgraph.h"
+
+QT_BEGIN_NAMESPACE
+class QTreeWidget;
+class QTreeWidgetItem;
+class QLabel;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Shows the stages of a job's dependency graph. Tasks of the same branch
+ * share a color, so independent parts of the pipeline stand out.
+ */
+class JobGraphDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit JobGraphDialog(RSJobGraph *graph, QWidget * parent = 0);
+    ~JobGraphDialog();
+
+    void setJob(RSJob *job);
+    void popup();
+
+signals:
+    void taskActivated(int taskIndex);
+
+protected:
+    void setupLayout();
+
+    RSJobGraph *graph;
+    RSJob *job;
+    QTreeWidget *tree;
+    QLabel *summaryLabel;
+
+protected slots:
+    void refresh();
+    void itemActivated(QTreeWidgetItem *item, int column);
+    void exportPlan();
+};
+
+#endif
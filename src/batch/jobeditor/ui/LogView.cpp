@@ -0,0 +1,140 @@
+#include "LogView.h"
+#include <QBoxLayout>
+#include <QLabel>
+#include <QListView>
+#include <QScrollBar>
+
+LogModel::LogModel(QObject *parent) : QAbstractListModel(parent)
+{
+    buffer = NULL;
+    rows = 0;
+    total = 0;
+}
+
+LogModel::~LogModel()
+{
+
+}
+
+void LogModel::setBuffer(RSLogBuffer *buffer)
+{
+    beginResetModel();
+    this->buffer = buffer;
+    rows  = buffer == NULL ? 0 : buffer->size();
+    total = buffer == NULL ? 0 : buffer->totalLines();
+    endResetModel();
+}
+
+void LogModel::sync()
+{
+    if ( buffer == NULL || buffer->totalLines() == total ) {
+        return;
+    }
+
+    const qint64 added = buffer->totalLines() - total;
+    const int newRows  = buffer->size();
+    const qint64 dropped = rows + added - newRows;
+
+    if ( dropped >= rows ) {
+        // everything that was shown has been overwritten
+        beginResetModel();
+        rows  = newRows;
+        total = buffer->totalLines();
+        endResetModel();
+        return;
+    }
+
+    // row r of the buffer now holds what was row r+dropped before
+    if ( dropped > 0 ) {
+        beginRemoveRows(QModelIndex(), 0, (int)dropped - 1);
+        rows -= (int)dropped;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), rows, newRows - 1);
+    rows  = newRows;
+    total = buffer->totalLines();
+    endInsertRows();
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if ( buffer == NULL || ! index.isValid() || role != Qt::DisplayRole ) {
+        return QVariant();
+    }
+    return buffer->line(index.row());
+}
+
+LogView::LogView(QWidget *parent) : QWidget(parent)
+{
+    buffer = NULL;
+
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    model = new LogModel(this);
+
+    // uniform item sizes let the view lay out only the visible lines
+    view = new QListView();
+    view->setModel(model);
+    view->setUniformItemSizes(true);
+    view->setLayoutMode(QListView::Batched);
+    view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    QFont f("Courier", 10);
+    f.setStyleHint(QFont::TypeWriter);
+    view->setFont(f);
+    layout->addWidget(view);
+
+    statusLabel = new QLabel();
+    layout->addWidget(statusLabel);
+
+    setLayout(layout);
+}
+
+LogView::~LogView()
+{
+
+}
+
+void LogView::setBuffer(RSLogBuffer *buffer)
+{
+    this->buffer = buffer;
+    model->setBuffer(buffer);
+    view->scrollToBottom();
+    updateStatus();
+}
+
+void LogView::sync()
+{
+    QScrollBar *scrollBar = view->verticalScrollBar();
+    bool atBottom = scrollBar->value() == scrollBar->maximum();
+
+    model->sync();
+
+    if ( atBottom ) {
+        view->scrollToBottom();
+    }
+    updateStatus();
+}
+
+void LogView::updateStatus()
+{
+    if ( buffer == NULL ) {
+        statusLabel->setText(QString());
+        return;
+    }
+
+    QString status = tr("%1 lines").arg(buffer->totalLines());
+    if ( buffer->droppedLines() > 0 ) {
+        status += tr(", the first %1 are no longer held").arg(buffer->droppedLines());
+    }
+    if ( ! buffer->spillPath().isEmpty() ) {
+        status += tr(", full output in %1").arg(buffer->spillPath());
+    }
+    statusLabel->setText(status);
+}
@@ -0,0 +1,58 @@
+#ifndef rstools_rsbatch_jobeditor_ui_logview_h
+#define rstools_rsbatch_jobeditor_ui_logview_h
+
+#include <QAbstractListModel>
+#include <QWidget>
+#include "../rslogbuffer.h"
+
+QT_BEGIN_NAMESPACE
+class QListView;
+class QLabel;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Exposes an RSLogBuffer to a list view. The model does not copy any lines,
+ * sync() translates whatever has been appended to the buffer since the last
+ * call into a single row removal and a single row insertion.
+ */
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit LogModel(QObject *parent = 0);
+    ~LogModel();
+
+    void setBuffer(RSLogBuffer *buffer);
+    void sync();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+protected:
+    RSLogBuffer *buffer;
+    int rows;
+    qint64 total;
+};
+
+class LogView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit LogView(QWidget * parent = 0);
+    ~LogView();
+
+    void setBuffer(RSLogBuffer *buffer);
+    void sync();
+
+protected:
+    void updateStatus();
+
+    RSLogBuffer *buffer;
+    LogModel *model;
+    QListView *view;
+    QLabel *statusLabel;
+};
+
+#endif
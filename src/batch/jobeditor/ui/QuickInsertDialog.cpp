@@ -0,0 +1,109 @@
+#include "QuickInsertDialog.h"
+#include <QApplication>
+#include <QBoxLayout>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QKeyEvent>
+
+QuickInsertDialog::QuickInsertDialog(QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Quick Insert"));
+    setupLayout();
+}
+
+QuickInsertDialog::~QuickInsertDialog()
+{
+
+}
+
+void QuickInsertDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    filterEdit = new QLineEdit();
+    filterEdit->setPlaceholderText(tr("Type to search tools by name, code, category or description"));
+    filterEdit->installEventFilter(this);
+    connect(filterEdit, SIGNAL(textChanged(QString)), this, SLOT(filterChanged(QString)));
+    connect(filterEdit, SIGNAL(returnPressed()), this, SLOT(accept()));
+    layout->addWidget(filterEdit);
+
+    resultList = new QListWidget();
+    resultList->setUniformItemSizes(true);
+    connect(resultList, SIGNAL(itemActivated(QListWidgetItem*)), this, SLOT(itemActivated(QListWidgetItem*)));
+    layout->addWidget(resultList);
+
+    setLayout(layout);
+    resize(480, 360);
+}
+
+void QuickInsertDialog::popup()
+{
+    // the index is only built once, the first time the palette is needed
+    RSToolIndex::getInstance().build();
+
+    filterEdit->clear();
+    filterChanged(QString());
+    filterEdit->setFocus();
+
+    show();
+    raise();
+    activateWindow();
+}
+
+void QuickInsertDialog::filterChanged(const QString &query)
+{
+    QByteArray q = query.toUtf8();
+    vector<rsToolIndexMatch> matches = RSToolIndex::getInstance().search(q.data(), 50);
+
+    resultList->setUpdatesEnabled(false);
+    resultList->clear();
+
+    for (vector<rsToolIndexMatch>::iterator it = matches.begin(); it != matches.end(); ++it) {
+        rsToolIndexEntry* entry = it->entry;
+
+        QListWidgetItem *item = new QListWidgetItem(
+            QString::fromUtf8(entry->name.c_str())
+            + QString("  (") + QString::fromUtf8(entry->category.c_str()) + QString(")")
+        );
+        item->setToolTip(QString::fromUtf8(entry->code.c_str()) + QString(": ") + QString::fromUtf8(entry->description.c_str()));
+        item->setData(Qt::UserRole, entry->toolIndex);
+        resultList->addItem(item);
+    }
+
+    if ( resultList->count() > 0 ) {
+        resultList->setCurrentRow(0);
+    }
+    resultList->setUpdatesEnabled(true);
+}
+
+// Forward navigation keys from the filter field to the result list
+bool QuickInsertDialog::eventFilter(QObject *watched, QEvent *event)
+{
+    if ( watched == filterEdit && event->type() == QEvent::KeyPress ) {
+        QKeyEvent *keyEvent = (QKeyEvent*)event;
+        switch ( keyEvent->key() ) {
+            case Qt::Key_Up:
+            case Qt::Key_Down:
+            case Qt::Key_PageUp:
+            case Qt::Key_PageDown:
+                QApplication::sendEvent(resultList, event);
+                return true;
+        }
+    }
+    return QDialog::eventFilter(watched, event);
+}
+
+void QuickInsertDialog::itemActivated(QListWidgetItem *item)
+{
+    if ( item == NULL ) {
+        return;
+    }
+
+    hide();
+    emit toolSelected(item->data(Qt::UserRole).toInt());
+}
+
+void QuickInsertDialog::accept()
+{
+    itemActivated(resultList->currentItem());
+}
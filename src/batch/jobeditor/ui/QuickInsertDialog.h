@@ -0,0 +1,40 @@
+#ifndef rstools_rsbatch_jobeditor_ui_quickinsertdialog_h
+#define rstools_rsbatch_jobeditor_ui_quickinsertdialog_h
+
+#include <QDialog>
+#include "../rstoolindex.h"
+
+QT_BEGIN_NAMESPACE
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+class QuickInsertDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit QuickInsertDialog(QWidget * parent = 0);
+    ~QuickInsertDialog();
+
+    void popup();
+
+signals:
+    void toolSelected(int toolIndex);
+
+protected:
+    void setupLayout();
+    bool eventFilter(QObject *watched, QEvent *event);
+
+    QLineEdit *filterEdit;
+    QListWidget *resultList;
+
+protected slots:
+    void filterChanged(const QString &query);
+    void itemActivated(QListWidgetItem *item);
+    void accept();
+};
+
+#endif
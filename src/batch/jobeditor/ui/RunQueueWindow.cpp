@@ -0,0 +1,353 @@
+#include "RunQueueWindow.h"
+#include "LogView.h"
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QTableWidget>
+#include <QTimer>
+
+enum {
+    COLUMN_JOB = 0,
+    COLUMN_STATE,
+    COLUMN_PROGRESS,
+    COLUMN_ELAPSED,
+    COLUMN_MEMORY,
+    COLUMN_EXIT,
+    COLUMN_OUTPUT,
+    COLUMN_COUNT
+};
+
+RunQueueWindow* RunQueueWindow::getInstance()
+{
+    static RunQueueWindow *instance = NULL;
+    if ( instance == NULL ) {
+        instance = new RunQueueWindow();
+    }
+    return instance;
+}
+
+RunQueueWindow::RunQueueWindow(QWidget *parent) : QWidget(parent, Qt::Window)
+{
+    setWindowTitle(tr("Run Queue - RSTools Job Editor"));
+    setAttribute(Qt::WA_QuitOnClose, false);
+    shownJob = 0;
+    setupLayout();
+
+    RSJobRunQueue *queue = &RSJobRunQueue::getInstance();
+    connect(queue, SIGNAL(jobAdded(int)), this, SLOT(jobAdded(int)));
+    connect(queue, SIGNAL(jobChanged(int)), this, SLOT(jobChanged(int)));
+    connect(queue, SIGNAL(jobOutput(int)), this, SLOT(jobOutput(int)));
+
+    foreach( int id, queue->getJobIds() ) {
+        jobAdded(id);
+    }
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setInterval(1000);
+    connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    refreshTimer->start();
+}
+
+RunQueueWindow::~RunQueueWindow()
+{
+
+}
+
+void RunQueueWindow::popup()
+{
+    show();
+    raise();
+    activateWindow();
+}
+
+void RunQueueWindow::setupLayout()
+{
+    RSJobRunQueue &queue = RSJobRunQueue::getInstance();
+
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    // limits
+    QBoxLayout *limitsLayout = new QBoxLayout(QBoxLayout::LeftToRight);
+
+    maxJobsBox = new QSpinBox();
+    maxJobsBox->setRange(1, 1024);
+    maxJobsBox->setValue(queue.getMaxJobs());
+    connect(maxJobsBox, SIGNAL(valueChanged(int)), this, SLOT(maxJobsChanged(int)));
+    limitsLayout->addWidget(new QLabel(tr("Concurrent jobs:")));
+    limitsLayout->addWidget(maxJobsBox);
+
+    memoryLimitBox = new QSpinBox();
+    memoryLimitBox->setRange(128, 64 * 1024 * 1024);
+    memoryLimitBox->setSingleStep(1024);
+    memoryLimitBox->setSuffix(" MB");
+    memoryLimitBox->setValue((int)queue.getMemoryLimit());
+    connect(memoryLimitBox, SIGNAL(valueChanged(int)), this, SLOT(memoryLimitChanged(int)));
+    limitsLayout->addWidget(new QLabel(tr("Memory limit:")));
+    limitsLayout->addWidget(memoryLimitBox);
+
+    memoryEstimateBox = new QSpinBox();
+    memoryEstimateBox->setRange(16, 64 * 1024 * 1024);
+    memoryEstimateBox->setSingleStep(256);
+    memoryEstimateBox->setSuffix(" MB");
+    memoryEstimateBox->setValue((int)queue.getDefaultMemoryEstimate());
+    connect(memoryEstimateBox, SIGNAL(valueChanged(int)), this, SLOT(memoryEstimateChanged(int)));
+    limitsLayout->addWidget(new QLabel(tr("Memory per job:")));
+    limitsLayout->addWidget(memoryEstimateBox);
+
+    spillLogsBox = new QCheckBox(tr("Keep full output on disk"));
+    spillLogsBox->setChecked(queue.getSpillLogs());
+    connect(spillLogsBox, SIGNAL(toggled(bool)), this, SLOT(spillLogsChanged(bool)));
+    limitsLayout->addWidget(spillLogsBox);
+
+    useCacheBox = new QCheckBox(tr("Skip unchanged tasks"));
+    useCacheBox->setToolTip(tr("Tasks whose settings and input files did not change since their last successful run are not run again"));
+    useCacheBox->setChecked(RSTaskCache::getInstance().isEnabled());
+    connect(useCacheBox, SIGNAL(toggled(bool)), this, SLOT(useCacheChanged(bool)));
+    limitsLayout->addWidget(useCacheBox);
+
+    limitsLayout->addStretch(1);
+    layout->addLayout(limitsLayout);
+
+    // jobs
+    table = new QTableWidget(0, COLUMN_COUNT);
+    QStringList headers;
+    headers << tr("Job") << tr("State") << tr("Progress") << tr("Elapsed") << tr("Memory") << tr("Exit") << tr("Output");
+    table->setHorizontalHeaderLabels(headers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+    connect(table, SIGNAL(itemSelectionChanged()), this, SLOT(selectionChanged()));
+
+    // output of the selected job
+    logView = new LogView();
+
+    QSplitter *splitter = new QSplitter(Qt::Vertical);
+    splitter->addWidget(table);
+    splitter->addWidget(logView);
+    splitter->setStretchFactor(0, 1);
+    splitter->setStretchFactor(1, 2);
+    layout->addWidget(splitter);
+
+    // actions
+    QBoxLayout *buttonLayout = new QBoxLayout(QBoxLayout::LeftToRight);
+
+    QPushButton *addButton = new QPushButton(tr("Add Jobs..."));
+    connect(addButton, SIGNAL(clicked()), this, SLOT(addJobs()));
+    buttonLayout->addWidget(addButton);
+
+    QPushButton *cancelButton = new QPushButton(tr("Cancel Selected"));
+    connect(cancelButton, SIGNAL(clicked()), this, SLOT(cancelSelected()));
+    buttonLayout->addWidget(cancelButton);
+
+    QPushButton *clearButton = new QPushButton(tr("Clear Finished"));
+    connect(clearButton, SIGNAL(clicked()), this, SLOT(clearFinished()));
+    buttonLayout->addWidget(clearButton);
+
+    buttonLayout->addStretch(1);
+
+    statusLabel = new QLabel();
+    buttonLayout->addWidget(statusLabel);
+
+    layout->addLayout(buttonLayout);
+
+    setLayout(layout);
+    resize(900, 600);
+}
+
+QString RunQueueWindow::stateToString(rsRunState state)
+{
+    switch ( state ) {
+        case RS_RUN_QUEUED:
+            return tr("Queued");
+        case RS_RUN_RUNNING:
+            return tr("Running");
+        case RS_RUN_FINISHED:
+            return tr("Finished");
+        case RS_RUN_FAILED:
+            return tr("Failed");
+        case RS_RUN_CANCELLED:
+            return tr("Cancelled");
+    }
+    return QString();
+}
+
+QString RunQueueWindow::formatDuration(qint64 ms)
+{
+    qint64 s = ms / 1000;
+    return QString("%1:%2:%3")
+        .arg(s / 3600)
+        .arg((s / 60) % 60, 2, 10, QChar('0'))
+        .arg(s % 60, 2, 10, QChar('0'));
+}
+
+void RunQueueWindow::jobAdded(int id)
+{
+    int row = table->rowCount();
+    table->insertRow(row);
+    for ( int c=0; c<COLUMN_COUNT; c++ ) {
+        table->setItem(row, c, new QTableWidgetItem());
+    }
+    table->item(row, COLUMN_JOB)->setData(Qt::UserRole, id);
+    rows.insert(id, row);
+    updateRow(id);
+    updateStatus();
+}
+
+void RunQueueWindow::jobChanged(int id)
+{
+    updateRow(id);
+    updateStatus();
+}
+
+void RunQueueWindow::jobOutput(int id)
+{
+    if ( id == shownJob && isVisible() ) {
+        logView->sync();
+    }
+}
+
+void RunQueueWindow::selectionChanged()
+{
+    int id = 0;
+
+    QList<QTableWidgetItem*> items = table->selectedItems();
+    foreach( QTableWidgetItem *item, items ) {
+        if ( item->column() == COLUMN_JOB ) {
+            id = item->data(Qt::UserRole).toInt();
+            break;
+        }
+    }
+
+    if ( id == shownJob ) {
+        return;
+    }
+
+    rsRunQueueJob *job = RSJobRunQueue::getInstance().getJob(id);
+    shownJob = job == NULL ? 0 : id;
+    logView->setBuffer(job == NULL ? NULL : job->log);
+}
+
+void RunQueueWindow::updateRow(int id)
+{
+    rsRunQueueJob *job = RSJobRunQueue::getInstance().getJob(id);
+    if ( job == NULL || ! rows.contains(id) ) {
+        return;
+    }
+
+    int row = rows.value(id);
+
+    QString progress;
+    if ( job->taskCount > 0 ) {
+        progress = QString("%1/%2").arg(qMin(job->currentTask + (job->state == RS_RUN_RUNNING ? 1 : 0), job->taskCount)).arg(job->taskCount);
+        if ( job->reusedTasks > 0 ) {
+            progress += tr(" (%1 reused)").arg(job->reusedTasks);
+        }
+    }
+
+    qint64 elapsed = job->state == RS_RUN_RUNNING ? job->timer.elapsed() : job->elapsed;
+
+    table->item(row, COLUMN_JOB)->setText(QFileInfo(job->name).fileName());
+    table->item(row, COLUMN_JOB)->setToolTip(job->name);
+    table->item(row, COLUMN_STATE)->setText(stateToString(job->state));
+    table->item(row, COLUMN_PROGRESS)->setText(progress);
+    table->item(row, COLUMN_ELAPSED)->setText(job->state == RS_RUN_QUEUED ? QString() : formatDuration(elapsed));
+    table->item(row, COLUMN_MEMORY)->setText(QString("%1 MB").arg(job->memoryEstimate));
+    table->item(row, COLUMN_EXIT)->setText(job->state == RS_RUN_FAILED || job->state == RS_RUN_FINISHED ? QString::number(job->exitCode) : QString());
+    table->item(row, COLUMN_OUTPUT)->setText(job->message.isEmpty() ? job->lastLine : job->message);
+}
+
+void RunQueueWindow::updateStatus()
+{
+    RSJobRunQueue &queue = RSJobRunQueue::getInstance();
+    statusLabel->setText(
+        tr("%1 of %2 jobs running, %3 of %4 MB reserved")
+            .arg(queue.getRunningCount())
+            .arg(queue.getMaxJobs())
+            .arg(queue.getUsedMemory())
+            .arg(queue.getMemoryLimit())
+    );
+}
+
+void RunQueueWindow::refresh()
+{
+    if ( ! isVisible() ) {
+        return;
+    }
+
+    RSJobRunQueue &queue = RSJobRunQueue::getInstance();
+    foreach( int id, queue.getJobIds() ) {
+        rsRunQueueJob *job = queue.getJob(id);
+        if ( job->state == RS_RUN_RUNNING ) {
+            updateRow(id);
+        }
+    }
+}
+
+void RunQueueWindow::addJobs()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, tr("Queue Jobs"), "", tr("Job (*.job)"));
+    foreach( const QString &fileName, fileNames ) {
+        RSJobRunQueue::getInstance().enqueue(fileName);
+    }
+}
+
+void RunQueueWindow::cancelSelected()
+{
+    QList<QTableWidgetItem*> items = table->selectedItems();
+    foreach( QTableWidgetItem *item, items ) {
+        if ( item->column() == COLUMN_JOB ) {
+            RSJobRunQueue::getInstance().cancel(item->data(Qt::UserRole).toInt());
+        }
+    }
+}
+
+void RunQueueWindow::clearFinished()
+{
+    RSJobRunQueue &queue = RSJobRunQueue::getInstance();
+
+    // the buffer that is shown might be freed along with its job
+    shownJob = 0;
+    logView->setBuffer(NULL);
+
+    queue.clearFinished();
+
+    table->setRowCount(0);
+    rows.clear();
+    foreach( int id, queue.getJobIds() ) {
+        jobAdded(id);
+    }
+}
+
+void RunQueueWindow::maxJobsChanged(int value)
+{
+    RSJobRunQueue::getInstance().setMaxJobs(value);
+    updateStatus();
+}
+
+void RunQueueWindow::memoryLimitChanged(int value)
+{
+    RSJobRunQueue::getInstance().setMemoryLimit(value);
+    updateStatus();
+}
+
+void RunQueueWindow::memoryEstimateChanged(int value)
+{
+    RSJobRunQueue::getInstance().setDefaultMemoryEstimate(value);
+}
+
+void RunQueueWindow::spillLogsChanged(bool checked)
+{
+    RSJobRunQueue::getInstance().setSpillLogs(checked);
+}
+
+void RunQueueWindow::useCacheChanged(bool checked)
+{
+    RSTaskCache::getInstance().setEnabled(checked);
+}
@@ -0,0 +1,67 @@
+#ifndef rstools_rsbatch_jobeditor_ui_runqueuewindow_h
+#define rstools_rsbatch_jobeditor_ui_runqueuewindow_h
+
+#include <QWidget>
+#include <QHash>
+#include "../rsjobrunqueue.h"
+
+QT_BEGIN_NAMESPACE
+class QTableWidget;
+class QSpinBox;
+class QLabel;
+class QTimer;
+class QCheckBox;
+QT_END_NAMESPACE
+
+class LogView;
+
+using namespace rstools::batch::util;
+
+class RunQueueWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    static RunQueueWindow* getInstance();
+
+    void popup();
+
+protected:
+    explicit RunQueueWindow(QWidget * parent = 0);
+    ~RunQueueWindow();
+
+    void setupLayout();
+    void updateRow(int id);
+    void updateStatus();
+
+    static QString stateToString(rsRunState state);
+    static QString formatDuration(qint64 ms);
+
+    QTableWidget *table;
+    QSpinBox *maxJobsBox;
+    QSpinBox *memoryLimitBox;
+    QSpinBox *memoryEstimateBox;
+    QCheckBox *spillLogsBox;
+    QCheckBox *useCacheBox;
+    LogView *logView;
+    int shownJob;
+    QLabel *statusLabel;
+    QTimer *refreshTimer;
+    QHash<int, int> rows;
+
+protected slots:
+    void jobAdded(int id);
+    void jobChanged(int id);
+    void jobOutput(int id);
+    void selectionChanged();
+    void refresh();
+    void addJobs();
+    void cancelSelected();
+    void clearFinished();
+    void maxJobsChanged(int value);
+    void memoryLimitChanged(int value);
+    void memoryEstimateChanged(int value);
+    void spillLogsChanged(bool checked);
+    void useCacheChanged(bool checked);
+};
+
+#endif
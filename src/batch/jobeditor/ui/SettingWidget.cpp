@@ -11,14 +11,28 @@
 #include <QCheckBox>
 #include <QRadioButton>
 #include <QButtonGroup>
+#include <QFileInfo>
+#include <QPixmap>
 #include <glib.h>
+#include "../rsuioptionutils.h"
+#include "../rsrunhistory.h"
 
 using namespace rstools::batch::util;
 
-SettingWidget::SettingWidget(RSTask* task, rsUIOption *option, QWidget *parent) : QGroupBox(parent)
+SettingWidget::SettingWidget(RSTask* task, rsUIOption *option, RSJobDocument *document, QWidget *parent) : QGroupBox(parent)
 {
     this->task   = task;
     this->option = option;
+    this->document = document;
+    messageLabel = NULL;
+    resolvedLabel = NULL;
+    headerLabel = NULL;
+    thumbnailLabel = NULL;
+    headerWidget = NULL;
+    shownHeader.valid = false;
+    fileCheckTimer = NULL;
+    completer = NULL;
+    completionModel = NULL;
     setupLayout();
 }
 
@@ -32,6 +46,70 @@ rsUIOption* SettingWidget::getSetting()
     return option;
 }
 
+RSTask* SettingWidget::getTask()
+{
+    return task;
+}
+
+// The value as it is stored in the task, with job argument references
+QString SettingWidget::getValue()
+{
+    rsArgument* argument = task->getArgument(option->name);
+    if ( argument == NULL || argument->value == NULL ) {
+        return QString();
+    }
+    return QString::fromUtf8(argument->value);
+}
+
+/*
+ * Shows what the value turns into once the job arguments are substituted.
+ * Nothing is shown for values without references.
+ */
+// The task has to hold the same value as the one the widget was created for
+void SettingWidget::rebind(RSTask *task, RSJobDocument *document)
+{
+    this->task = task;
+    this->document = document;
+}
+
+void SettingWidget::setResolvedValue(const QString &value)
+{
+    bool changed = value != resolvedValue;
+    resolvedValue = value;
+    
+    if ( resolvedLabel != NULL ) {
+        resolvedLabel->setText(tr("= %1").arg(value));
+        resolvedLabel->setToolTip(value);
+        resolvedLabel->setVisible(getValue().contains("${"));
+    }
+    
+    if ( changed && fileCheckTimer != NULL ) {
+        fileCheckTimer->start();
+    }
+}
+
+void SettingWidget::setValidationMessage(const QString &message)
+{
+    validationMessage = message;
+    updateMessageLabel();
+}
+
+void SettingWidget::updateMessageLabel()
+{
+    if ( messageLabel == NULL ) {
+        return;
+    }
+    
+    QStringList messages;
+    if ( ! validationMessage.isEmpty() )
+        messages << validationMessage;
+    if ( ! fileMessage.isEmpty() )
+        messages << fileMessage;
+    
+    messageLabel->setText(messages.join("\n"));
+    messageLabel->setVisible( ! messages.isEmpty() );
+}
+
 void SettingWidget::setupLayout()
 {       
     QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
@@ -50,6 +128,34 @@ void SettingWidget::setupLayout()
     createValueWidget();
     layout->addWidget(valueWidget);
     
+    resolvedLabel = new QLabel();
+    resolvedLabel->setWordWrap(true);
+    resolvedLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    resolvedLabel->setStyleSheet("color: #606060");
+    resolvedLabel->setVisible(false);
+    layout->addWidget(resolvedLabel);
+    
+    // the thumbnail sits next to what the image header says
+    headerWidget = new QWidget();
+    QBoxLayout *headerLayout = new QBoxLayout(QBoxLayout::LeftToRight);
+    headerLayout->setContentsMargins(0, 0, 0, 0);
+    thumbnailLabel = new QLabel();
+    thumbnailLabel->setVisible(false);
+    headerLayout->addWidget(thumbnailLabel);
+    headerLabel = new QLabel();
+    headerLabel->setWordWrap(true);
+    headerLabel->setStyleSheet("color: #606060");
+    headerLayout->addWidget(headerLabel, 1);
+    headerWidget->setLayout(headerLayout);
+    headerWidget->setVisible(false);
+    layout->addWidget(headerWidget);
+    
+    messageLabel = new QLabel();
+    messageLabel->setWordWrap(true);
+    messageLabel->setStyleSheet("color: #c00000");
+    messageLabel->setVisible(false);
+    layout->addWidget(messageLabel);
+    
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
     setLayout(layout);
 }
@@ -73,7 +179,11 @@ void SettingWidget::createValueWidget()
                         QLineEdit *w = new QLineEdit();
                         valueWidget = w;
                         w->setPlaceholderText(option->cli_arg_description);
+                        if ( rsUIOptionIsFilename(option) ) {
+                            setupFileChecks(w);
+                        }
                         connect(w, SIGNAL(textChanged(QString)), this, SLOT(textChanged(QString)));
+                        connect(w, SIGNAL(editingFinished()), this, SLOT(editingFinished()));
                         if ( argument != NULL ) {
                             w->setText(argument->value);
                         } else if ( option->defaultValue != NULL ) {
@@ -160,31 +270,220 @@ void SettingWidget::createValueWidget()
     }
 }
 
-// Slot for QLineEdits
+/*
+ * Filename options are checked against the shared stat cache. Neither the
+ * check nor the completion ever blocks, missing results are requested from
+ * the cache's worker pool and applied once they arrive.
+ */
+void SettingWidget::setupFileChecks(QLineEdit *w)
+{
+    fileCheckTimer = new QTimer(this);
+    fileCheckTimer->setSingleShot(true);
+    fileCheckTimer->setInterval(300);
+    connect(fileCheckTimer, SIGNAL(timeout()), this, SLOT(checkFile()));
+    
+    completionModel = new QStringListModel(this);
+    completer = new QCompleter(completionModel, this);
+    completer->setCompletionMode(QCompleter::PopupCompletion);
+    completer->setModelSorting(QCompleter::CaseSensitivelySortedModel);
+    w->setCompleter(completer);
+    
+    RSFileStatCache *cache = &RSFileStatCache::getInstance();
+    connect(cache, SIGNAL(statReady(QString)), this, SLOT(fileStatReady(QString)));
+    connect(cache, SIGNAL(listingReady(QString)), this, SLOT(listingReady(QString)));
+    connect(&RSNiftiHeaderCache::getInstance(), SIGNAL(headerReady(QString)), this, SLOT(niftiHeaderReady(QString)));
+    connect(&RSThumbnailCache::getInstance(), SIGNAL(thumbnailReady(QString)), this, SLOT(thumbnailReady(QString)));
+    
+    fileCheckTimer->start();
+}
+
+void SettingWidget::checkFile()
+{
+    QString path = ((QLineEdit*)valueWidget)->text().trimmed();
+    
+    // values that reference job arguments are checked once resolved
+    if ( path.contains("${") ) {
+        path = resolvedValue.trimmed();
+    }
+    
+    if ( path.isEmpty() || path.contains("${") ) {
+        pendingPath = QString();
+        pendingHeaderPath = QString();
+        fileMessage = QString();
+        headerWidget->setVisible(false);
+        updateMessageLabel();
+        return;
+    }
+    
+    // outputs do not exist yet, but the directory they go to has to
+    if ( rsUIOptionIsOutput(option) ) {
+        path = QFileInfo(path).path();
+    }
+    
+    pendingPath = path;
+    
+    rsFileStat stat;
+    if ( RSFileStatCache::getInstance().lookupStat(path, stat) ) {
+        applyFileStat(stat);
+    } else {
+        RSFileStatCache::getInstance().requestStat(path);
+    }
+}
+
+void SettingWidget::fileStatReady(const QString &path)
+{
+    if ( path != pendingPath ) {
+        return;
+    }
+    
+    rsFileStat stat;
+    if ( RSFileStatCache::getInstance().lookupStat(path, stat) ) {
+        applyFileStat(stat);
+    }
+}
+
+void SettingWidget::applyFileStat(const rsFileStat &stat)
+{
+    if ( rsUIOptionIsOutput(option) ) {
+        fileMessage = stat.exists && stat.isDir
+            ? QString()
+            : tr("The output directory does not exist");
+    } else if ( ! stat.exists ) {
+        fileMessage = tr("The file does not exist");
+    } else if ( stat.isDir ) {
+        fileMessage = tr("This is a directory, not a file");
+    } else {
+        fileMessage = QString();
+    }
+    
+    updateMessageLabel();
+    
+    // existing input images show what their header says
+    if ( rsUIOptionIsOutput(option) || ! stat.exists || stat.isDir || ! RSNiftiHeaderCache::isNiftiPath(pendingPath) ) {
+        pendingHeaderPath = QString();
+        headerWidget->setVisible(false);
+        return;
+    }
+    
+    pendingHeaderPath = pendingPath;
+    
+    rsNiftiHeader header;
+    if ( RSNiftiHeaderCache::getInstance().lookup(pendingHeaderPath, header) && header.mtime >= stat.mtime ) {
+        applyNiftiHeader(header);
+    } else {
+        RSNiftiHeaderCache::getInstance().request(pendingHeaderPath);
+    }
+}
+
+void SettingWidget::niftiHeaderReady(const QString &path)
+{
+    if ( path != pendingHeaderPath ) {
+        return;
+    }
+    
+    rsNiftiHeader header;
+    if ( RSNiftiHeaderCache::getInstance().lookup(path, header) ) {
+        applyNiftiHeader(header);
+    }
+}
+
+void SettingWidget::applyNiftiHeader(const rsNiftiHeader &header)
+{
+    QString text = RSNiftiHeaderCache::describe(header);
+    if ( header.valid ) {
+        text += tr(", %1 of voxel data").arg(RSRunHistory::formatMemory(RSNiftiHeaderCache::getDataSize(header) / 1024));
+    }
+    headerLabel->setText(text);
+    headerWidget->setVisible(true);
+    
+    shownHeader = header;
+    thumbnailLabel->setVisible(false);
+    if ( ! header.valid ) {
+        return;
+    }
+    
+    // decoding never happens here, a missing thumbnail shows up once ready
+    QImage image;
+    if ( RSThumbnailCache::getInstance().lookup(pendingHeaderPath, header, image) ) {
+        thumbnailLabel->setPixmap(QPixmap::fromImage(image));
+        thumbnailLabel->setVisible( ! image.isNull() );
+    } else {
+        RSThumbnailCache::getInstance().request(pendingHeaderPath, header);
+    }
+}
+
+void SettingWidget::thumbnailReady(const QString &path)
+{
+    if ( path != pendingHeaderPath || ! shownHeader.valid ) {
+        return;
+    }
+    
+    QImage image;
+    if ( RSThumbnailCache::getInstance().lookup(path, shownHeader, image) ) {
+        thumbnailLabel->setPixmap(QPixmap::fromImage(image));
+        thumbnailLabel->setVisible( ! image.isNull() );
+    }
+}
+
+void SettingWidget::updateCompletions(const QString &text)
+{
+    int slash = text.lastIndexOf('/');
+    if ( slash < 0 ) {
+        return;
+    }
+    
+    QString directory = text.left(slash + 1);
+    if ( directory == completionDirectory ) {
+        return;
+    }
+    
+    QStringList entries;
+    if ( RSFileStatCache::getInstance().lookupListing(directory, entries) ) {
+        QStringList completions;
+        foreach( const QString &entry, entries ) {
+            completions << directory + entry;
+        }
+        completionModel->setStringList(completions);
+        completionDirectory = directory;
+        pendingDirectory = QString();
+    } else {
+        pendingDirectory = directory;
+        RSFileStatCache::getInstance().requestListing(directory);
+    }
+}
+
+void SettingWidget::listingReady(const QString &directory)
+{
+    if ( directory != pendingDirectory ) {
+        return;
+    }
+    
+    QLineEdit *w = (QLineEdit*)valueWidget;
+    updateCompletions(w->text());
+    
+    if ( w->hasFocus() ) {
+        completer->complete();
+    }
+}
+
+// Slot for QLineEdits, the value is a draft until editing is finished
 void SettingWidget::textChanged(QString newValue)
 {
     QByteArray ba = newValue.toLatin1();
-    const char *newValueCString = ba.data();
-    rsArgument* argument = task->getArgument(option->name);
-        
-    char *newV = (char*)rsMalloc(sizeof(char)*(strlen(newValueCString)+1));
-    sprintf(newV, "%s", newValueCString);
+    document->setTaskArgument(task, option->name, ba.data(), true);
     
-    if ( argument != NULL ) {
-        char *oldV = argument->value;
-        argument->value = newV;
-        rsFree(oldV);
-    } else {
-        argument = (rsArgument*)rsMalloc(sizeof(rsArgument));
-        
-        char *name = (char*)rsMalloc(sizeof(char)*(strlen(option->name)+1));
-        sprintf(name, "%s", option->name);
-        
-        argument->key = name;
-        argument->value = newV;
-        
-        task->addArgument(argument);
+    if ( fileCheckTimer != NULL ) {
+        updateCompletions(newValue);
+        fileCheckTimer->start();
     }
+    
+    emit valueChanged(this);
+}
+
+// Slot for QLineEdits
+void SettingWidget::editingFinished()
+{
+    document->commitTaskArgument(task, option->name);
 }
 
 // Slot for QPlainTextEdit
@@ -202,27 +501,13 @@ void SettingWidget::buttonClicked(int id)
     const QString s = QString::fromLatin1(value);
     
     textChanged(s);
+    document->commitTaskArgument(task, option->name);
 }
 
 // Slot for QCheckBox
 void SettingWidget::stateChanged(int state)
 {
-    if ( state == Qt::Checked ) {
-        rsArgument* argument = task->getArgument(option->name);
-        if ( argument == NULL ) {
-            argument = (rsArgument*)rsMalloc(sizeof(rsArgument));
-            
-            argument->key = (char*)rsMalloc(sizeof(char)*(strlen(option->name)+1));
-            sprintf(argument->key, "%s", option->name);
-            argument->value = NULL;
-            
-            task->addArgument(argument);
-        }
-    } else {
-        rsArgument* argument = task->getArgument(option->name);
-        if ( argument != NULL ) {
-            task->removeArgument(option->name);
-            //rsFree(argument);
-        }
-    }
+    document->setTaskFlag(task, option->name, state == Qt::Checked);
+    
+    emit valueChanged(this);
 }
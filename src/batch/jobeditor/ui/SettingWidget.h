@@ -3,8 +3,17 @@
 
 #include <stdexcept>
 #include <QGroupBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTimer>
+#include <QCompleter>
+#include <QStringListModel>
 #include "utils/rsui.h"
 #include "batch/util/rstask.hpp"
+#include "../rsfilestatcache.h"
+#include "../rsniftiheader.h"
+#include "../rsthumbnailcache.h"
+#include "../rsjobdocument.h"
 
 using namespace rstools::batch::util;
 
@@ -12,24 +21,62 @@ class SettingWidget : public QGroupBox
 {
     Q_OBJECT
 public:
-    explicit SettingWidget(RSTask* task, rsUIOption* option, QWidget * parent = 0);
+    explicit SettingWidget(RSTask* task, rsUIOption* option, RSJobDocument *document, QWidget * parent = 0);
     ~SettingWidget();
     
     rsUIOption* getSetting();
+    RSTask* getTask();
+    QString getValue();
+    
+    void setValidationMessage(const QString &message);
+    void setResolvedValue(const QString &value);
+    void rebind(RSTask *task, RSJobDocument *document);
+    
+signals:
+    void valueChanged(SettingWidget *setting);
     
 protected:
     void createValueWidget();
     void setupLayout();
+    void setupFileChecks(QLineEdit *w);
+    void updateCompletions(const QString &text);
+    void applyFileStat(const rsFileStat &stat);
+    void applyNiftiHeader(const rsNiftiHeader &header);
+    void updateMessageLabel();
     
     rsUIOption *option;
+    RSJobDocument *document;
     QWidget *valueWidget;
+    QLabel *messageLabel;
+    QLabel *resolvedLabel;
+    QLabel *headerLabel;
+    QLabel *thumbnailLabel;
+    QWidget *headerWidget;
+    rsNiftiHeader shownHeader;
+    QString resolvedValue;
+    QString validationMessage;
+    QString fileMessage;
+    
+    QTimer *fileCheckTimer;
+    QCompleter *completer;
+    QStringListModel *completionModel;
+    QString completionDirectory;
+    QString pendingDirectory;
+    QString pendingPath;
+    QString pendingHeaderPath;
     RSTask* task;
     
 protected slots:
     void textChanged();
     void textChanged(QString newValue);
+    void editingFinished();
     void buttonClicked(int id);
     void stateChanged(int state);
+    void checkFile();
+    void fileStatReady(const QString &path);
+    void niftiHeaderReady(const QString &path);
+    void thumbnailReady(const QString &path);
+    void listingReady(const QString &directory);
 };
 
 #endif
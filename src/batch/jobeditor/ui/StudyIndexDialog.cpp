@@ -0,0 +1,291 @@
+#include "StudyIndexDialog.h"
+#include "ConsistencyDialog.h"
+#include "../rstoolindex.h"
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSet>
+#include <QSettings>
+#include <QTimer>
+#include <QTreeWidget>
+
+static const int maxResults = 10000;
+
+StudyIndexDialog::StudyIndexDialog(QWidget *parent) : QDialog(parent)
+{
+    index = NULL;
+    worker = NULL;
+    readCount = 0;
+    removedCount = 0;
+
+    readTimer = new QTimer(this);
+    readTimer->setInterval(0);
+    connect(readTimer, SIGNAL(timeout()), this, SLOT(readPending()));
+
+    setWindowTitle(tr("Search Study"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    setupLayout();
+
+    QSettings settings("RSTools", "rsjobeditor");
+    QString root = settings.value("studyIndex/root").toString();
+    if ( ! root.isEmpty() ) {
+        setRoot(root);
+    }
+}
+
+/*
+ * The worker is not waited for, scanning a study on a slow share would
+ * keep the dialog from closing. It works on a copy of the index, skips
+ * the files it has not read yet and deletes itself.
+ */
+StudyIndexDialog::~StudyIndexDialog()
+{
+    if ( worker != NULL ) {
+        disconnect(worker, SIGNAL(finished()), this, SLOT(indexScanned()));
+        worker->cancel();
+        if ( worker->isFinished() ) {
+            worker->deleteLater();
+        } else {
+            connect(worker, SIGNAL(finished()), worker, SLOT(deleteLater()));
+        }
+    }
+    delete index;
+}
+
+void StudyIndexDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+    QFormLayout *form = new QFormLayout();
+
+    QBoxLayout *row = new QBoxLayout(QBoxLayout::LeftToRight);
+    rootEdit = new QLineEdit();
+    rootEdit->setReadOnly(true);
+    row->addWidget(rootEdit);
+    QPushButton *browseButton = new QPushButton(tr("Browse..."));
+    connect(browseButton, SIGNAL(clicked()), this, SLOT(browse()));
+    row->addWidget(browseButton);
+    updateButton = new QPushButton(tr("Update"));
+    updateButton->setEnabled(false);
+    connect(updateButton, SIGNAL(clicked()), this, SLOT(updateIndex()));
+    row->addWidget(updateButton);
+    form->addRow(tr("Study directory:"), row);
+
+    queryEdit = new QLineEdit();
+    queryEdit->setToolTip(tr(
+        "Terms that all have to match within the same task:\n"
+        "code:rsbandpass - tasks of a tool\n"
+        "f1=0.01 - an argument with the given value, * and ? are wildcards\n"
+        "atlas_v1 - any argument whose value contains the word"
+    ));
+    connect(queryEdit, SIGNAL(returnPressed()), this, SLOT(runQuery()));
+    form->addRow(tr("Search:"), queryEdit);
+
+    layout->addLayout(form);
+
+    results = new QTreeWidget();
+    results->setColumnCount(3);
+    QStringList headers;
+    headers << tr("Job") << tr("Task") << tr("Argument");
+    results->setHeaderLabels(headers);
+    results->setRootIsDecorated(false);
+    results->setSortingEnabled(true);
+    results->header()->setStretchLastSection(true);
+    connect(results, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(resultActivated(QTreeWidgetItem*, int)));
+    layout->addWidget(results);
+
+    statusLabel = new QLabel();
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    consistencyButton = buttons->addButton(tr("Check Consistency"), QDialogButtonBox::ActionRole);
+    consistencyButton->setToolTip(tr("List the jobs whose settings deviate from those of the majority"));
+    consistencyButton->setEnabled(false);
+    connect(consistencyButton, SIGNAL(clicked()), this, SLOT(checkConsistency()));
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(900, 520);
+}
+
+void StudyIndexDialog::browse()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Study Directory"), rootEdit->text());
+    if ( directory.isEmpty() || isUpdating() ) {
+        return;
+    }
+
+    QSettings settings("RSTools", "rsjobeditor");
+    settings.setValue("studyIndex/root", directory);
+    setRoot(directory);
+}
+
+// Searches what was indexed before right away and updates it meanwhile
+void StudyIndexDialog::setRoot(const QString &root)
+{
+    delete index;
+    index = new RSStudyIndex(root);
+    index->load();
+
+    rootEdit->setText(index->getRoot());
+    results->clear();
+    runQuery();
+    updateIndex();
+}
+
+bool StudyIndexDialog::isUpdating()
+{
+    return worker != NULL || readTimer->isActive();
+}
+
+void StudyIndexDialog::updateIndex()
+{
+    if ( index == NULL || isUpdating() ) {
+        return;
+    }
+
+    updateButton->setEnabled(false);
+    consistencyButton->setEnabled(false);
+    queryEdit->setEnabled(false);
+    statusLabel->setText(tr("Reading the jobs that changed since the last update..."));
+
+    worker = new RSStudyIndexThread(*index);
+    connect(worker, SIGNAL(finished()), this, SLOT(indexScanned()));
+    worker->start(QThread::LowPriority);
+}
+
+void StudyIndexDialog::indexScanned()
+{
+    RSStudyIndexThread *thread = worker;
+    worker = NULL;
+
+    QString error = thread->getError();
+    pending = thread->getPending();
+    QStringList gone = thread->getGone();
+    thread->deleteLater();
+
+    if ( ! error.isEmpty() ) {
+        pending.clear();
+        finishUpdate(error);
+        return;
+    }
+
+    index->remove(gone);
+    removedCount = gone.size();
+    readCount = pending.size();
+
+    // the plugins are needed to parse the jobs
+    RSToolIndex::getInstance().build();
+    readTimer->start();
+}
+
+/*
+ * Parses the changed jobs in the GUI thread, which may parse jobs of its
+ * own at any time, a few at a time so that the editor stays responsive.
+ */
+void StudyIndexDialog::readPending()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while ( ! pending.isEmpty() && timer.elapsed() < 40 ) {
+        rsIndexedJob job = pending.takeFirst();
+        index->read(job);
+    }
+
+    if ( ! pending.isEmpty() ) {
+        statusLabel->setText(tr("Reading the jobs that changed since the last update, %1 of %2 left...")
+            .arg(pending.size())
+            .arg(readCount));
+        return;
+    }
+
+    readTimer->stop();
+    index->save();
+    finishUpdate(QString());
+}
+
+void StudyIndexDialog::finishUpdate(const QString &error)
+{
+    updateButton->setEnabled(true);
+    consistencyButton->setEnabled(true);
+    queryEdit->setEnabled(true);
+
+    if ( ! error.isEmpty() ) {
+        statusLabel->setText(tr("The index could not be updated: %1").arg(error));
+        return;
+    }
+
+    QString status = tr("%1 jobs indexed, %2 read and %3 removed by this update.")
+        .arg(index->getJobCount())
+        .arg(readCount)
+        .arg(removedCount);
+    if ( index->getUnreadableCount() > 0 ) {
+        status += QString(" ") + tr("%1 jobs could not be read.").arg(index->getUnreadableCount());
+    }
+    statusLabel->setText(status);
+
+    if ( readCount > 0 || removedCount > 0 ) {
+        runQuery();
+    }
+}
+
+void StudyIndexDialog::runQuery()
+{
+    // the index changes while it is updated
+    if ( index == NULL || isUpdating() ) {
+        return;
+    }
+
+    results->clear();
+    results->setSortingEnabled(false);
+
+    QList<rsIndexMatch> matches = index->query(queryEdit->text(), maxResults);
+    foreach( const rsIndexMatch &match, matches ) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(results);
+        item->setText(0, QFileInfo(match.path).fileName());
+        item->setToolTip(0, match.path);
+        item->setData(0, Qt::UserRole, match.path);
+        item->setText(1, match.task);
+        if ( ! match.key.isEmpty() ) {
+            item->setText(2, QString("%1 = %2").arg(match.key).arg(match.value));
+        }
+    }
+
+    results->setSortingEnabled(true);
+    results->resizeColumnToContents(0);
+    results->resizeColumnToContents(1);
+
+    QSet<QString> jobs;
+    foreach( const rsIndexMatch &match, matches ) {
+        jobs.insert(match.path);
+    }
+    if ( ! queryEdit->text().trimmed().isEmpty() ) {
+        statusLabel->setText(tr("%1 tasks in %2 jobs match.").arg(matches.size()).arg(jobs.size()));
+    }
+}
+
+void StudyIndexDialog::checkConsistency()
+{
+    if ( index == NULL || isUpdating() ) {
+        return;
+    }
+
+    RSStudyConsistency consistency(*index);
+    ConsistencyDialog *dialog = new ConsistencyDialog(consistency, this);
+    connect(dialog, SIGNAL(jobActivated(const QString&)), this, SIGNAL(jobActivated(const QString&)));
+    dialog->show();
+}
+
+void StudyIndexDialog::resultActivated(QTreeWidgetItem *item, int /*column*/)
+{
+    emit jobActivated(item->data(0, Qt::UserRole).toString());
+}
@@ -0,0 +1,66 @@
+#ifndef rstools_rsbatch_jobeditor_ui_studyindexdialog_h
+#define rstools_rsbatch_jobeditor_ui_studyindexdialog_h
+
+#include <QDialog>
+#include "../rsstudyindex.h"
+
+QT_BEGIN_NAMESPACE
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QLabel;
+class QTimer;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Searches the tasks and arguments of all jobs below a study directory,
+ * e.g. for the jobs that still use an old atlas. The index of the
+ * directory is brought up to date whenever it is chosen: the changed job
+ * files are found and read in the background and then parsed in idle
+ * moments of the GUI thread. A job is opened by double-clicking one of its
+ * matches.
+ */
+class StudyIndexDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit StudyIndexDialog(QWidget * parent = 0);
+    ~StudyIndexDialog();
+
+signals:
+    void jobActivated(const QString &path);
+
+protected:
+    void setupLayout();
+    void setRoot(const QString &root);
+    bool isUpdating();
+    void finishUpdate(const QString &error);
+
+    QLineEdit *rootEdit;
+    QPushButton *updateButton;
+    QPushButton *consistencyButton;
+    QLineEdit *queryEdit;
+    QTreeWidget *results;
+    QLabel *statusLabel;
+
+    RSStudyIndex *index;
+    RSStudyIndexThread *worker;
+    QList<rsIndexedJob> pending;   // jobs of the update that are still to be parsed
+    int readCount;
+    int removedCount;
+    QTimer *readTimer;
+
+protected slots:
+    void browse();
+    void updateIndex();
+    void indexScanned();
+    void readPending();
+    void runQuery();
+    void checkConsistency();
+    void resultActivated(QTreeWidgetItem *item, int column);
+};
+
+#endif
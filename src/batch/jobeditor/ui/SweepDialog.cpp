@@ -0,0 +1,207 @@
+#include "SweepDialog.h"
+#include "../rsjobcomparison.h"
+#include "../rsjobrunqueue.h"
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QErrorMessage>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <stdexcept>
+
+using namespace std;
+
+SweepDialog::SweepDialog(const RSJobSnapshot &job, QWidget *parent) : QDialog(parent)
+{
+    this->job = job;
+
+    setWindowTitle(tr("Parameter Sweep"));
+    setAttribute(Qt::WA_DeleteOnClose);
+    setupLayout();
+
+    QFileInfo info(job.getPath());
+    directoryEdit->setText(info.absolutePath() + QString("/") + info.completeBaseName() + QString("_sweep"));
+
+    addDimensionRow(job.getTaskCount() > 0 ? 0 : -1, QString(), QString());
+}
+
+void SweepDialog::setupLayout()
+{
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+
+    dimensionsTable = new QTableWidget(0, 3);
+    QStringList headers;
+    headers << tr("Task") << tr("Argument") << tr("Values");
+    dimensionsTable->setHorizontalHeaderLabels(headers);
+    dimensionsTable->horizontalHeader()->resizeSection(0, 260);
+    dimensionsTable->horizontalHeader()->setStretchLastSection(true);
+    dimensionsTable->setToolTip(tr("Values are separated by commas, e.g. 4,6,8, or given as a range START:STEP:END, e.g. 0.01:0.01:0.05"));
+    connect(dimensionsTable, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(updateCount()));
+    layout->addWidget(dimensionsTable);
+
+    QBoxLayout *rowButtons = new QBoxLayout(QBoxLayout::LeftToRight);
+    QPushButton *addButton = new QPushButton(tr("Add Argument"));
+    connect(addButton, SIGNAL(clicked()), this, SLOT(addDimension()));
+    rowButtons->addWidget(addButton);
+    QPushButton *removeButton = new QPushButton(tr("Remove Argument"));
+    connect(removeButton, SIGNAL(clicked()), this, SLOT(removeDimension()));
+    rowButtons->addWidget(removeButton);
+    rowButtons->addStretch();
+    layout->addLayout(rowButtons);
+
+    QFormLayout *form = new QFormLayout();
+
+    QBoxLayout *directoryRow = new QBoxLayout(QBoxLayout::LeftToRight);
+    directoryEdit = new QLineEdit();
+    directoryRow->addWidget(directoryEdit);
+    QPushButton *browseButton = new QPushButton(tr("Browse..."));
+    connect(browseButton, SIGNAL(clicked()), this, SLOT(browseDirectory()));
+    directoryRow->addWidget(browseButton);
+    form->addRow(tr("Output directory:"), directoryRow);
+
+    sampleBox = new QSpinBox();
+    sampleBox->setRange(0, RSJobSweep::maxVariants);
+    sampleBox->setSpecialValueText(tr("All combinations"));
+    sampleBox->setToolTip(tr("Generate a random sample of this many variants instead of all combinations"));
+    connect(sampleBox, SIGNAL(valueChanged(int)), this, SLOT(updateCount()));
+    form->addRow(tr("Sample:"), sampleBox);
+
+    queueBox = new QCheckBox(tr("Add the variants to the run queue"));
+    queueBox->setChecked(true);
+    form->addRow(QString(), queueBox);
+
+    maxJobsBox = new QSpinBox();
+    maxJobsBox->setRange(1, 256);
+    maxJobsBox->setValue(RSJobRunQueue::getInstance().getMaxJobs());
+    maxJobsBox->setToolTip(tr("The job limit of the run queue, which applies to all queued jobs"));
+    form->addRow(tr("Jobs at the same time:"), maxJobsBox);
+
+    layout->addLayout(form);
+
+    statusLabel = new QLabel();
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    QPushButton *generateButton = buttons->addButton(tr("Generate"), QDialogButtonBox::ActionRole);
+    connect(generateButton, SIGNAL(clicked()), this, SLOT(generate()));
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttons);
+
+    setLayout(layout);
+    resize(720, 420);
+}
+
+void SweepDialog::addDimensionRow(int task, const QString &key, const QString &values)
+{
+    const int row = dimensionsTable->rowCount();
+    dimensionsTable->insertRow(row);
+
+    QComboBox *taskBox = new QComboBox();
+    taskBox->addItem(tr("Job arguments"), -1);
+    for ( int i=0; i<job.getTaskCount(); i++ ) {
+        taskBox->addItem(RSJobComparison::formatTask(i, job.getTask(i)), i);
+    }
+    taskBox->setCurrentIndex(task + 1);
+    connect(taskBox, SIGNAL(currentIndexChanged(int)), this, SLOT(updateCount()));
+    dimensionsTable->setCellWidget(row, 0, taskBox);
+
+    dimensionsTable->setItem(row, 1, new QTableWidgetItem(key));
+    dimensionsTable->setItem(row, 2, new QTableWidgetItem(values));
+}
+
+void SweepDialog::addDimension()
+{
+    addDimensionRow(job.getTaskCount() > 0 ? 0 : -1, QString(), QString());
+    dimensionsTable->setCurrentCell(dimensionsTable->rowCount() - 1, 1);
+}
+
+void SweepDialog::removeDimension()
+{
+    const int row = dimensionsTable->currentRow();
+    if ( row >= 0 ) {
+        dimensionsTable->removeRow(row);
+        updateCount();
+    }
+}
+
+void SweepDialog::browseDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Output Directory"), directoryEdit->text());
+    if ( ! directory.isEmpty() ) {
+        directoryEdit->setText(directory);
+    }
+}
+
+// Rows without an argument are still being filled in and are skipped
+void SweepDialog::fillSweep(RSJobSweep &sweep)
+{
+    for ( int row=0; row<dimensionsTable->rowCount(); row++ ) {
+        QTableWidgetItem *key = dimensionsTable->item(row, 1);
+        QTableWidgetItem *values = dimensionsTable->item(row, 2);
+        if ( key == NULL || values == NULL || key->text().trimmed().isEmpty() ) {
+            continue;
+        }
+
+        QComboBox *taskBox = (QComboBox*)dimensionsTable->cellWidget(row, 0);
+
+        rsSweepDimension dimension;
+        dimension.task = taskBox->itemData(taskBox->currentIndex()).toInt();
+        dimension.key = key->text().trimmed();
+        dimension.values = RSJobSweep::parseValues(values->text());
+        sweep.addDimension(dimension);
+    }
+
+    sweep.setSampleSize(sampleBox->value());
+}
+
+void SweepDialog::updateCount()
+{
+    try {
+        RSJobSweep sweep(job);
+        fillSweep(sweep);
+
+        if ( sweep.getVariantCount() < sweep.getCombinationCount() ) {
+            statusLabel->setText(tr("%1 of %2 combinations").arg(sweep.getVariantCount()).arg(sweep.getCombinationCount()));
+        } else {
+            statusLabel->setText(tr("%1 variants").arg(sweep.getVariantCount()));
+        }
+    } catch (const exception& e) {
+        statusLabel->setText(QString::fromUtf8(e.what()));
+    }
+}
+
+void SweepDialog::generate()
+{
+    try {
+        QElapsedTimer timer;
+        timer.start();
+
+        RSJobSweep sweep(job);
+        fillSweep(sweep);
+        QStringList jobs = sweep.generate(directoryEdit->text());
+
+        statusLabel->setText(tr("Wrote %1 variants in %2 ms").arg(jobs.size()).arg(timer.elapsed()));
+
+        if ( queueBox->isChecked() ) {
+            RSJobRunQueue &queue = RSJobRunQueue::getInstance();
+            queue.setMaxJobs(maxJobsBox->value());
+            foreach( const QString &path, jobs ) {
+                queue.enqueue(path, QFileInfo(path).completeBaseName());
+            }
+        }
+    } catch (const exception& e) {
+    	QErrorMessage errorMessage(this);
+    	errorMessage.showMessage(e.what());
+    	errorMessage.exec();
+    }
+}
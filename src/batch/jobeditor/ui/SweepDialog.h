@@ -0,0 +1,50 @@
+#ifndef rstools_rsbatch_jobeditor_ui_sweepdialog_h
+#define rstools_rsbatch_jobeditor_ui_sweepdialog_h
+
+#include <QDialog>
+#include "../rsjobsweep.h"
+
+QT_BEGIN_NAMESPACE
+class QLineEdit;
+class QCheckBox;
+class QLabel;
+class QSpinBox;
+class QTableWidget;
+QT_END_NAMESPACE
+
+using namespace rstools::batch::util;
+
+/*
+ * Front end for RSJobSweep: lists the arguments to sweep with their values
+ * and writes the variants of the job as it was when the dialog was opened.
+ * The variants can be handed to the run queue, which runs as many of them
+ * at the same time as its job limit allows.
+ */
+class SweepDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit SweepDialog(const RSJobSnapshot &job, QWidget * parent = 0);
+
+protected:
+    void setupLayout();
+    void addDimensionRow(int task, const QString &key, const QString &values);
+    void fillSweep(RSJobSweep &sweep);
+
+    RSJobSnapshot job;
+    QTableWidget *dimensionsTable;
+    QLineEdit *directoryEdit;
+    QSpinBox *sampleBox;
+    QCheckBox *queueBox;
+    QSpinBox *maxJobsBox;
+    QLabel *statusLabel;
+
+protected slots:
+    void addDimension();
+    void removeDimension();
+    void browseDirectory();
+    void updateCount();
+    void generate();
+};
+
+#endif
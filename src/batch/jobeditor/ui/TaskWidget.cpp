@@ -7,25 +7,74 @@
 #include <QScrollArea>
 #include <QTabWidget>
 
-TaskWidget::TaskWidget(RSTool *tool, QWidget *parent) : QWidget(parent, 0)
+/*
+ * The UI descriptors (I) are shared by all tasks of the same tool across
+ * all open documents, the widget itself only ever writes to its task.
+ * All edits go through the task's document.
+ */
+TaskWidget::TaskWidget(RSTask *task, rsUIInterface *I, RSJobDocument *document, QWidget *parent) : QWidget(parent, 0)
 {
-    this->tool = tool;
+    this->task = task;
+    this->I = I;
+    this->document = document;
+    widgets = NULL;
+    nWidgets = 0;
     setupLayout();
 }
 
 TaskWidget::~TaskWidget()
 {
-    
+    // the setting widgets themselves are children of this widget
+    free(widgets);
 }
 
 RSTask* TaskWidget::getTask()
 {
-    return tool->getTask();
+    return task;
+}
+
+rsUIInterface* TaskWidget::getInterface()
+{
+    return I;
+}
+
+size_t TaskWidget::getSettingWidgetCount()
+{
+    return nWidgets;
+}
+
+// Returns NULL for options that are not shown in the GUI
+SettingWidget* TaskWidget::getSettingWidget(size_t i)
+{
+    return widgets[i];
+}
+
+SettingWidget* TaskWidget::findSettingWidget(const char* optionName)
+{
+    // names that were never interned cannot belong to any option
+    const char *name = RSStringPool::getInstance().find(optionName);
+    return name == NULL ? NULL : widgetsByName.value(name, NULL);
+}
+
+/*
+ * Hands the page over to a task with the same values in another document,
+ * which keeps everything that is shown as it is.
+ */
+void TaskWidget::rebind(RSTask *task, RSJobDocument *document)
+{
+    this->task = task;
+    this->document = document;
+    
+    for ( size_t i=0; i<nWidgets; i++ ) {
+        if ( widgets[i] != NULL ) {
+            widgets[i]->rebind(task, document);
+        }
+    }
 }
 
-RSTool* TaskWidget::getTool()
+void TaskWidget::settingValueChanged(SettingWidget *setting)
 {
-    return tool;
+    emit settingChanged(this, setting);
 }
 
 void TaskWidget::setupLayout()
@@ -38,20 +87,22 @@ void TaskWidget::setupLayout()
     
     QBoxLayout *mainLayout = new QBoxLayout(QBoxLayout::TopToBottom);
     QBoxLayout *extendedLayout = new QBoxLayout(QBoxLayout::TopToBottom);
-    rsUIInterface* I = tool->createUI();
     
     nWidgets = I->nOptions;
     widgets = (SettingWidget**)malloc(sizeof(SettingWidget*)*nWidgets);
     
     for ( size_t i=0; i<I->nOptions; i++ ) {
         rsUIOption* o = I->options[i];
+        widgets[i] = NULL;
         
         if ( ! o->showInGUI ) {
             continue;
         }
         
-        SettingWidget *setting = new SettingWidget(getTask(), o);
+        SettingWidget *setting = new SettingWidget(getTask(), o, document);
         widgets[i] = setting;    
+        widgetsByName.insert(RSStringPool::getInstance().intern(o->name), setting);
+        connect(setting, SIGNAL(valueChanged(SettingWidget*)), this, SLOT(settingValueChanged(SettingWidget*)));
         
         if ( o->group == RS_UI_GROUP_EXTENDED ) {
             extendedLayout->addWidget(setting);
@@ -7,6 +7,8 @@
 #include "batch/util/rstool.hpp"
 #include "utils/rsui.h"
 #include "SettingWidget.h"
+#include "../rsjobdocument.h"
+#include <QHash>
 
 using namespace std;
 using namespace rstools::batch::util;
@@ -15,18 +17,33 @@ class TaskWidget : public QWidget
 {
     Q_OBJECT
 public:
-    explicit TaskWidget(RSTool* tool, QWidget * parent = 0);
+    explicit TaskWidget(RSTask* task, rsUIInterface* I, RSJobDocument *document, QWidget * parent = 0);
     ~TaskWidget();
     
     RSTask* getTask();
-    RSTool* getTool();
+    rsUIInterface* getInterface();
     
     void setupLayout();
     
+    size_t getSettingWidgetCount();
+    SettingWidget* getSettingWidget(size_t i);
+    SettingWidget* findSettingWidget(const char* optionName);
+    
+    void rebind(RSTask *task, RSJobDocument *document);
+    
+signals:
+    void settingChanged(TaskWidget *taskWidget, SettingWidget *setting);
+    
+protected slots:
+    void settingValueChanged(SettingWidget *setting);
+    
 protected:
-    RSTool *tool;
+    RSTask *task;
+    rsUIInterface *I;
+    RSJobDocument *document;
     SettingWidget **widgets;
     size_t nWidgets;
+    QHash<const char*, SettingWidget*> widgetsByName; // by interned option name
 };
 
 #endif
@@ -2,8 +2,21 @@
 #include <QApplication>
 #include <QWidget>
 #include "jobeditor/rsjobeditorapplication.h"
+#include "jobeditor/rssingleinstance.h"
+#include "jobeditor/rsmakefileexport.h"
+#include "jobeditor/rsjobtemplate.h"
+#include "jobeditor/rsjobdocument.h"
+#include "jobeditor/rsjobcomparison.h"
+#include "jobeditor/rsjobmerge.h"
+#include "jobeditor/rsjobsweep.h"
+#include "jobeditor/rsstudyindex.h"
+#include "jobeditor/rsstudyconsistency.h"
+#include "jobeditor/rstoolindex.h"
 #include "rscommon.h"
 #include "utils/rsstring.h"
+#include <glib.h>
+
+using namespace rstools::batch::util;
 
 class JobEditorApplication : public QApplication {
     public:
@@ -22,15 +35,299 @@ class JobEditorApplication : public QApplication {
         }
 };
 
+static gboolean singleInstance = FALSE;
+static gchar *exportMakefile = NULL;
+static gchar *generateTable = NULL;
+static gchar *outputDirectory = NULL;
+static gchar *namePattern = NULL;
+static gboolean compareJobs = FALSE;
+static gboolean mergeJobs = FALSE;
+static gchar *indexDirectory = NULL;
+static gchar *indexQuery = NULL;
+static gboolean checkConsistency = FALSE;
+static gdouble majorityShare = 0.9;
+static gchar **sweepSpecs = NULL;
+static gint sampleSize = 0;
+
+static GOptionEntry entries[] = {
+    { "single-instance", 's', 0, G_OPTION_ARG_NONE, &singleInstance, "Open the job in an already running editor instead of starting a new one", NULL },
+    { "export-makefile", 'm', 0, G_OPTION_ARG_FILENAME, &exportMakefile, "Write the given jobs into a Makefile for make -j instead of opening the editor", "<makefile>" },
+    { "generate", 'g', 0, G_OPTION_ARG_FILENAME, &generateTable, "Write one job per row of the given CSV/TSV table from the template job", "<table>" },
+    { "output-directory", 'o', 0, G_OPTION_ARG_FILENAME, &outputDirectory, "Directory for the generated jobs (default: current directory)", "<directory>" },
+    { "name", 'n', 0, G_OPTION_ARG_STRING, &namePattern, "File name of the generated jobs, e.g. {{subject}}.job", "<pattern>" },
+    { "diff", 'd', 0, G_OPTION_ARG_NONE, &compareJobs, "Compare each of the given jobs with the first one task by task and print what was changed, exits with 1 if any job differs and 2 on errors", NULL },
+    { "merge", 0, 0, G_OPTION_ARG_NONE, &mergeJobs, "Merge the changes of THEIRS since BASE into OURS (arguments: BASE OURS THEIRS), exits with 1 on conflicts", NULL },
+    { "index", 'i', 0, G_OPTION_ARG_FILENAME, &indexDirectory, "Update the index of all jobs below the given directory", "<directory>" },
+    { "query", 'q', 0, G_OPTION_ARG_STRING, &indexQuery, "Print the tasks of the jobs in the index of --index that match, e.g. \"code:rsbandpass f1=0.01\"", "<query>" },
+    { "consistency", 'c', 0, G_OPTION_ARG_NONE, &checkConsistency, "Print the settings in which the jobs in the index of --index deviate from the majority as tab-separated values", NULL },
+    { "majority", 0, 0, G_OPTION_ARG_DOUBLE, &majorityShare, "Share of the jobs that have to agree on a setting before deviations are reported (default: 0.9)", "<share>" },
+    { "sweep", 0, 0, G_OPTION_ARG_STRING_ARRAY, &sweepSpecs, "Write one variant of the given job per combination of the swept values, e.g. 2:fwhm=4,6,8 or job:f1=0.01:0.01:0.05 (may be repeated)", "<task:key=values>" },
+    { "sample", 0, 0, G_OPTION_ARG_INT, &sampleSize, "Write a random sample of this many variants of --sweep instead of all combinations", "<n>" },
+    { NULL }
+};
+
+static int runMakefileExport(int argc, char *argv[])
+{
+    if ( argc < 2 ) {
+        fprintf(stderr, "No job files were given to export\n");
+        return 1;
+    }
+    
+    QCoreApplication app(argc, argv);
+    
+    try {
+        RSMakefileExport exporter(QString::fromLocal8Bit(exportMakefile));
+        for ( int i=1; i<argc; i++ ) {
+            exporter.addJobFile(QString::fromLocal8Bit(argv[i]));
+        }
+        exporter.write();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
+
+static int runJobGeneration(int argc, char *argv[])
+{
+    if ( argc < 2 ) {
+        fprintf(stderr, "No template job was given\n");
+        return 1;
+    }
+    
+    QCoreApplication app(argc, argv);
+    
+    try {
+        RSJobTemplate jobTemplate;
+        jobTemplate.load(QString::fromLocal8Bit(argv[1]));
+        jobTemplate.readTable(QString::fromLocal8Bit(generateTable));
+        
+        QString name = namePattern != NULL
+            ? QString::fromUtf8(namePattern)
+            : QString("{{%1}}.job").arg(jobTemplate.getColumns().value(0));
+        QString directory = outputDirectory != NULL ? QString::fromLocal8Bit(outputDirectory) : QString(".");
+        
+        QStringList jobs = jobTemplate.generate(directory, name);
+        fprintf(stdout, "%d jobs written\n", jobs.size());
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
+
+static int runJobComparison(int argc, char *argv[])
+{
+    if ( argc < 3 ) {
+        fprintf(stderr, "A job and at least one job to compare it with have to be given\n");
+        return 2;
+    }
+    
+    QCoreApplication app(argc, argv);
+    
+    RSJobSnapshot reference;
+    try {
+        reference = RSJobDocument::read(QString::fromLocal8Bit(argv[1]));
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+    
+    // the reference is read once, so a template can be compared with all of its jobs.
+    // Like diff, the result is 0 if all jobs are identical, 1 if any differs
+    // and 2 if any could not be read.
+    int result = 0;
+    for ( int i=2; i<argc; i++ ) {
+        try {
+            RSJobComparison comparison(reference, RSJobDocument::read(QString::fromLocal8Bit(argv[i])));
+            if ( comparison.isIdentical() ) {
+                fprintf(stdout, "%s: identical\n", argv[i]);
+                continue;
+            }
+            
+            fprintf(stdout, "+++ %s\n", argv[i]);
+            foreach( const QString &line, comparison.toText() ) {
+                fprintf(stdout, "%s\n", line.toUtf8().data());
+            }
+            result = qMax(result, 1);
+        } catch (const std::exception& e) {
+            fprintf(stderr, "%s: %s\n", argv[i], e.what());
+            result = 2;
+        }
+    }
+    
+    return result;
+}
+
+/*
+ * Takes the arguments of a git merge driver: the merged job replaces OURS
+ * and conflicts are reported on stderr.
+ */
+static int runJobMerge(int argc, char *argv[])
+{
+    if ( argc != 4 ) {
+        fprintf(stderr, "The base job, our job and their job have to be given\n");
+        return 1;
+    }
+    
+    QCoreApplication app(argc, argv);
+    
+    try {
+        RSJobMerge merge(
+            RSJobDocument::read(QString::fromLocal8Bit(argv[1])),
+            RSJobDocument::read(QString::fromLocal8Bit(argv[2])),
+            RSJobDocument::read(QString::fromLocal8Bit(argv[3]))
+        );
+        merge.write(QString::fromLocal8Bit(argv[2]));
+        
+        foreach( const QString &conflict, merge.getConflicts() ) {
+            fprintf(stderr, "%s\n", conflict.toUtf8().data());
+        }
+        return merge.hasConflicts() ? 1 : 0;
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
+
+static int runStudyIndex(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    // with half of the jobs or less, two values could both be the majority
+    if ( checkConsistency && ( majorityShare <= 0.5 || majorityShare > 1.0 ) ) {
+        fprintf(stderr, "The share given by --majority has to be above 0.5 and at most 1\n");
+        return 1;
+    }
+    
+    try {
+        RSToolIndex::getInstance().build();
+        
+        RSStudyIndex index(QString::fromLocal8Bit(indexDirectory));
+        index.load();
+        
+        int read = 0, removed = 0;
+        index.update(read, removed);
+        index.save();
+        
+        if ( checkConsistency ) {
+            RSStudyConsistency consistency(index, majorityShare);
+            foreach( const QString &line, consistency.toTsv() ) {
+                fprintf(stdout, "%s\n", line.toUtf8().data());
+            }
+            return 0;
+        }
+        
+        if ( indexQuery == NULL ) {
+            fprintf(stdout, "%d jobs indexed, %d read, %d removed, %d unreadable\n", index.getJobCount(), read, removed, index.getUnreadableCount());
+            return 0;
+        }
+        
+        foreach( const rsIndexMatch &match, index.query(QString::fromUtf8(indexQuery)) ) {
+            QString line = match.path + QString("\t") + match.task;
+            if ( ! match.key.isEmpty() ) {
+                line += QString("\t") + match.key + QString("=") + match.value;
+            }
+            fprintf(stdout, "%s\n", line.toUtf8().data());
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
+
+/*
+ * Prints the written variants one per line, so they can be handed to
+ * --export-makefile and run with a bounded number of jobs by make -j.
+ */
+static int runJobSweep(int argc, char *argv[])
+{
+    if ( argc < 2 ) {
+        fprintf(stderr, "No job to sweep was given\n");
+        return 1;
+    }
+    
+    QCoreApplication app(argc, argv);
+    
+    try {
+        RSJobSweep sweep(RSJobDocument::read(QString::fromLocal8Bit(argv[1])));
+        for ( gchar **spec = sweepSpecs; *spec != NULL; spec++ ) {
+            sweep.addDimension(RSJobSweep::parseDimension(QString::fromUtf8(*spec)));
+        }
+        sweep.setSampleSize(sampleSize);
+        
+        QString directory = outputDirectory != NULL ? QString::fromLocal8Bit(outputDirectory) : QString(".");
+        foreach( const QString &job, sweep.generate(directory) ) {
+            fprintf(stdout, "%s\n", job.toLocal8Bit().data());
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
+    GError *error = NULL;
+    GOptionContext *context = g_option_context_new("[JOBFILE...] - edit RSTools job files");
+    g_option_context_add_main_entries(context, entries, NULL);
+    g_option_context_set_ignore_unknown_options(context, TRUE);
+    if ( ! g_option_context_parse(context, &argc, &argv, &error) ) {
+        fprintf(stderr, "option parsing failed: %s\n", error->message);
+        return 1;
+    }
+    g_option_context_free(context);
+    
+    if ( exportMakefile != NULL ) {
+        return runMakefileExport(argc, argv);
+    }
+    
+    if ( generateTable != NULL ) {
+        return runJobGeneration(argc, argv);
+    }
+    
+    if ( sweepSpecs != NULL ) {
+        return runJobSweep(argc, argv);
+    }
+    
+    if ( compareJobs ) {
+        return runJobComparison(argc, argv);
+    }
+    
+    if ( mergeJobs ) {
+        return runJobMerge(argc, argv);
+    }
+    
+    if ( indexDirectory != NULL ) {
+        return runStudyIndex(argc, argv);
+    }
+    
+    // hand the job over before paying for any of the Qt initialization
+    if ( singleInstance && RSSingleInstance::forward(argc > 1 ? argv[1] : NULL) ) {
+        return 0;
+    }
+    
     JobEditorApplication app(argc, argv);
-    JobEditorWindow widget;
+    JobEditorWindowManager& windows = JobEditorWindowManager::getInstance();
+    JobEditorWindow *widget = windows.createWindow();
+    
+    if ( singleInstance ) {
+        RSSingleInstance *instance = new RSSingleInstance(&app);
+        QObject::connect(instance, SIGNAL(openRequested(QString)), &windows, SLOT(openJobInNewWindow(QString)));
+        instance->listen();
+    }
+    
     if ( argc > 1 ) {
-        widget.openJob(rsString(argv[1]));
+        widget->openJob(rsString(argv[1]));
     } else {
-        widget.openJob(rsString(RSTOOLS_DATA_DIR"/rstools/jobs/empty.job"));
+        widget->openJob(rsString(RSTOOLS_DATA_DIR"/rstools/jobs/empty.job"));
     }
-    widget.show();
+    widget->show();
     return app.exec();
 }